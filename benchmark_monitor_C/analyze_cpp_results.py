@@ -18,11 +18,13 @@ def load_results(filename="results_cpp.csv"):
     
     results = []
     with open(filename, 'r') as f:
-        reader = csv.DictReader(f)
+        # La primera línea es "# schema_version=N"
+        reader = csv.DictReader(line for line in f if not line.startswith('#'))
         for row in reader:
             # Convertir valores numéricos
             for key in row:
-                if key not in ['timestamp', 'benchmark', 'cpu_governor']:
+                if key not in ['timestamp', 'benchmark', 'cpu_governor',
+                               'cstate_residency', 'flags', 'buffer_policy']:
                     try:
                         row[key] = float(row[key])
                     except (ValueError, TypeError):
@@ -0,0 +1,615 @@
+// analyze_results.cpp - Analizador de results_cpp.csv en C++
+//
+// Proyecta el CSV en memoria con mmap y lo parsea en trozos en paralelo (un
+// hilo por trozo, cortados en saltos de línea). Calcula estadísticas por
+// benchmark y tamaño, rankings de eficiencia energética (EDP y julios por
+// elemento) y marca regresiones de las últimas ejecuciones frente a una
+// línea base de ejecuciones anteriores.
+//
+// Uso: analyze_results [opciones] [results_cpp.csv]
+// Sale con 1 si encuentra regresiones y con 2 si hay errores.
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// ============================================================
+// Opciones
+// ============================================================
+
+struct Options {
+    std::string filename;
+    int threads;          // hilos de parseo
+    size_t window;        // ejecuciones recientes que se comparan
+    size_t baseline;      // ejecuciones anteriores que forman la línea base
+    double threshold;     // empeoramiento mínimo (%) para marcar regresión
+    size_t top;           // filas de cada ranking
+};
+
+void printUsage(const char* argv0) {
+    std::cout << "Uso: " << argv0 << " [opciones] [results_cpp.csv]\n"
+              << "  --threads=N      hilos de parseo (por defecto, todas las CPUs)\n"
+              << "  --window=N       ejecuciones recientes por benchmark que se comparan (3)\n"
+              << "  --baseline=N     ejecuciones anteriores que forman la línea base (10)\n"
+              << "  --threshold=PCT  empeoramiento de la mediana para marcar regresión (5)\n"
+              << "  --top=N          filas de cada ranking (10)\n";
+}
+
+// Valor de "--name=valor" en `arg`, o nullptr si no es esa opción
+const char* optionValue(const char* arg, const char* name) {
+    const size_t len = strlen(name);
+    if (strncmp(arg, name, len) != 0 || arg[len] != '=') return nullptr;
+    return arg + len + 1;
+}
+
+bool parseOptions(int argc, char** argv, Options* options) {
+    options->filename = "results_cpp.csv";
+    options->threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    options->window = 3;
+    options->baseline = 10;
+    options->threshold = 5.0;
+    options->top = 10;
+    for (int i = 1; i < argc; i++) {
+        const char* value;
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            return false;
+        } else if ((value = optionValue(argv[i], "--threads"))) {
+            options->threads = std::max(1, atoi(value));
+        } else if ((value = optionValue(argv[i], "--window"))) {
+            options->window = static_cast<size_t>(std::max(1, atoi(value)));
+        } else if ((value = optionValue(argv[i], "--baseline"))) {
+            options->baseline = static_cast<size_t>(std::max(1, atoi(value)));
+        } else if ((value = optionValue(argv[i], "--threshold"))) {
+            options->threshold = atof(value);
+        } else if ((value = optionValue(argv[i], "--top"))) {
+            options->top = static_cast<size_t>(std::max(1, atoi(value)));
+        } else if (argv[i][0] == '-') {
+            std::cerr << "Opción desconocida: " << argv[i] << std::endl;
+            return false;
+        } else {
+            options->filename = argv[i];
+        }
+    }
+    return true;
+}
+
+// ============================================================
+// Fichero proyectado en memoria
+// ============================================================
+
+class MappedFile {
+public:
+    MappedFile() : data_(nullptr), size_(0) {}
+    ~MappedFile() {
+        if (data_ && size_ > 0) munmap(const_cast<char*>(data_), size_);
+    }
+
+    bool open(const std::string& filename) {
+        const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+            // Se lee de principio a fin, una vez
+            madvise(p, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(p);
+        }
+        ::close(fd);
+        return true;
+    }
+
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+// ============================================================
+// Parseo de líneas
+// ============================================================
+
+// Un campo de la línea actual: apunta al fichero salvo que haya tenido que
+// quitar comillas, en cuyo caso apunta a `unquoted`
+struct Field {
+    const char* data;
+    size_t size;
+    bool quoted;
+    std::string unquoted;
+};
+
+// Separa la línea [p, end) en `fields` (reutilizando su memoria), hasta
+// `max_fields` campos; el resto de la línea se salta sin mirarlo. Devuelve
+// el comienzo de la línea siguiente.
+const char* splitLine(const char* p, const char* end, size_t max_fields,
+                      std::vector<Field>* fields, size_t* num_fields) {
+    size_t n = 0;
+    while (true) {
+        if (n == max_fields) {
+            p = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+            break;
+        }
+        if (n == fields->size()) fields->push_back(Field());
+        Field& field = (*fields)[n++];
+        if (p < end && *p == '"') {
+            // Campo entre comillas: "" es una comilla
+            field.unquoted.clear();
+            for (++p; p < end; ++p) {
+                if (*p == '"') {
+                    if (p + 1 < end && p[1] == '"') {
+                        field.unquoted += '"';
+                        ++p;
+                    } else {
+                        ++p;
+                        break;
+                    }
+                } else {
+                    field.unquoted += *p;
+                }
+            }
+            field.quoted = true;
+            field.size = field.unquoted.size();
+            while (p < end && *p != ',' && *p != '\n') ++p;
+        } else {
+            const char* start = p;
+            while (p < end && *p != ',' && *p != '\n') ++p;
+            const char* stop = p;
+            if (stop > start && stop[-1] == '\r') --stop;
+            field.data = start;
+            field.quoted = false;
+            field.size = static_cast<size_t>(stop - start);
+        }
+        if (p >= end || *p == '\n') break;
+        ++p;  // ','
+    }
+    // Al final: crecer `fields` mueve las cadenas de los campos anteriores
+    for (size_t i = 0; i < n; i++) {
+        if ((*fields)[i].quoted) (*fields)[i].data = (*fields)[i].unquoted.data();
+    }
+    *num_fields = n;
+    return p && p < end ? p + 1 : end;
+}
+
+double toDouble(const Field& field) {
+    // strtod necesita el texto terminado en '\0'
+    char buf[64];
+    if (field.size == 0 || field.size >= sizeof(buf)) return 0.0;
+    memcpy(buf, field.data, field.size);
+    buf[field.size] = '\0';
+    return strtod(buf, nullptr);
+}
+
+std::string toString(const Field& field) {
+    return std::string(field.data, field.size);
+}
+
+bool endsWith(const std::string& s, const char* suffix) {
+    const size_t len = strlen(suffix);
+    return s.size() >= len && s.compare(s.size() - len, len, suffix) == 0;
+}
+
+// ============================================================
+// Muestras
+// ============================================================
+
+// Lo que se usa de cada fila, normalizado por iteración
+struct Sample {
+    double time_per_iter_s;
+    double energy_per_iter_j;
+    double edp_per_iter;     // energía × tiempo² de una iteración
+    double j_per_item;       // 0 sin elementos o sin energía
+};
+
+// Muestras de un benchmark (nombre completo), en el orden del fichero
+struct Series {
+    std::string family;  // nombre hasta la primera '/'
+    int64_t size;        // columna N
+    std::vector<Sample> samples;
+};
+
+typedef std::map<std::string, Series> SeriesMap;
+// Lo que llena cada hilo: sin orden, para no comparar cadenas en cada fila
+typedef std::unordered_map<std::string, Series> PartialMap;
+
+// Índices de las columnas usadas (-1 si no están)
+struct Columns {
+    int benchmark, n, time_s, iterations, energy_j, energy_per_iter_j, items;
+
+    Columns() : benchmark(-1), n(-1), time_s(-1), iterations(-1), energy_j(-1),
+                energy_per_iter_j(-1), items(-1) {}
+};
+
+Columns findColumns(const std::vector<Field>& header, size_t num_fields) {
+    Columns columns;
+    for (size_t i = 0; i < num_fields; i++) {
+        const std::string name = toString(header[i]);
+        const int index = static_cast<int>(i);
+        if (name == "benchmark") columns.benchmark = index;
+        else if (name == "N") columns.n = index;
+        else if (name == "time_s") columns.time_s = index;
+        else if (name == "iterations") columns.iterations = index;
+        else if (name == "energy_J") columns.energy_j = index;
+        else if (name == "energy_per_iter_J") columns.energy_per_iter_j = index;
+        else if (name == "items") columns.items = index;
+    }
+    return columns;
+}
+
+// Parsea las líneas de [begin, end) en `series`. Los agregados de las
+// repeticiones (_mean, _median, ...) se saltan: se recalculan aquí.
+void parseChunk(const char* begin, const char* end, const Columns& columns,
+                PartialMap* series, size_t* rows) {
+    std::vector<Field> fields;
+    size_t num_fields = 0;
+    const size_t needed = static_cast<size_t>(std::max(
+        std::max(columns.benchmark, columns.n),
+        std::max(std::max(columns.time_s, columns.iterations),
+                 std::max(std::max(columns.energy_j, columns.energy_per_iter_j),
+                          columns.items))));
+    std::string name;
+    *rows = 0;
+    for (const char* p = begin; p < end; ) {
+        p = splitLine(p, end, needed + 1, &fields, &num_fields);
+        if (num_fields <= needed) continue;  // línea vacía o incompleta
+        name.assign(fields[columns.benchmark].data, fields[columns.benchmark].size);
+        if (endsWith(name, "_mean") || endsWith(name, "_median") ||
+            endsWith(name, "_stddev") || endsWith(name, "_cv")) {
+            continue;
+        }
+
+        const double time_s = toDouble(fields[columns.time_s]);
+        const double iterations = columns.iterations >= 0
+            ? toDouble(fields[columns.iterations]) : 1.0;
+        if (time_s <= 0.0 || iterations <= 0.0) continue;
+        const double energy_j = toDouble(fields[columns.energy_j]);
+        const double items = columns.items >= 0 ? toDouble(fields[columns.items]) : 0.0;
+
+        Sample sample;
+        sample.time_per_iter_s = time_s / iterations;
+        sample.energy_per_iter_j = columns.iterations >= 0
+            ? energy_j / iterations : toDouble(fields[columns.energy_per_iter_j]);
+        sample.edp_per_iter = sample.energy_per_iter_j * sample.time_per_iter_s *
+                              sample.time_per_iter_s;
+        sample.j_per_item = items > 0.0 ? energy_j / items : 0.0;
+
+        Series& s = (*series)[name];
+        if (s.samples.empty()) {
+            s.family = name.substr(0, name.find('/'));
+            s.size = static_cast<int64_t>(toDouble(fields[columns.n]));
+        }
+        s.samples.push_back(sample);
+        ++*rows;
+    }
+}
+
+// Parte [begin, end) en `parts` trozos cortados en saltos de línea
+std::vector<const char*> splitChunks(const char* begin, const char* end, int parts) {
+    std::vector<const char*> bounds(1, begin);
+    const size_t step = static_cast<size_t>(end - begin) / parts;
+    for (int i = 1; i < parts; i++) {
+        const char* p = std::max(bounds.back(), begin + i * step);
+        p = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!p) break;
+        bounds.push_back(p + 1);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
+
+// ============================================================
+// Estadísticas
+// ============================================================
+
+struct Stats {
+    size_t n;
+    double mean, stddev, min, median, max;
+};
+
+Stats computeStats(std::vector<double> values) {
+    Stats stats = Stats();
+    stats.n = values.size();
+    if (values.empty()) return stats;
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (size_t i = 0; i < values.size(); i++) sum += values[i];
+    stats.mean = sum / values.size();
+    double sq = 0.0;
+    for (size_t i = 0; i < values.size(); i++) {
+        sq += (values[i] - stats.mean) * (values[i] - stats.mean);
+    }
+    stats.stddev = values.size() > 1 ? std::sqrt(sq / (values.size() - 1)) : 0.0;
+    stats.min = values.front();
+    stats.max = values.back();
+    const size_t mid = values.size() / 2;
+    stats.median = values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+    return stats;
+}
+
+double medianOf(const std::vector<Sample>& samples, size_t begin, size_t end,
+                double Sample::*field) {
+    std::vector<double> values;
+    for (size_t i = begin; i < end; i++) values.push_back(samples[i].*field);
+    return computeStats(values).median;
+}
+
+// Tiempo con la unidad más legible
+std::string formatTime(double seconds) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3);
+    if (seconds >= 1.0) oss << seconds << " s";
+    else if (seconds >= 1e-3) oss << seconds * 1e3 << " ms";
+    else if (seconds >= 1e-6) oss << seconds * 1e6 << " us";
+    else oss << seconds * 1e9 << " ns";
+    return oss.str();
+}
+
+void printStats(const SeriesMap& series) {
+    std::cout << "\n" << std::string(80, '=') << "\n"
+              << "ESTADÍSTICAS POR BENCHMARK Y TAMAÑO (tiempo por iteración)\n"
+              << std::string(80, '=') << "\n";
+
+    // Agrupados por familia, y dentro por tamaño
+    std::map<std::string, std::vector<const SeriesMap::value_type*> > families;
+    for (SeriesMap::const_iterator it = series.begin(); it != series.end(); ++it) {
+        families[it->second.family].push_back(&*it);
+    }
+    for (auto fam = families.begin(); fam != families.end(); ++fam) {
+        std::vector<const SeriesMap::value_type*>& members = fam->second;
+        std::sort(members.begin(), members.end(),
+                  [](const SeriesMap::value_type* a, const SeriesMap::value_type* b) {
+                      return a->second.size != b->second.size ? a->second.size < b->second.size
+                                                              : a->first < b->first;
+                  });
+        std::cout << "\n📊 " << fam->first << "\n";
+        std::cout << "   " << std::left << std::setw(40) << "benchmark" << std::right
+                  << std::setw(6) << "n" << std::setw(13) << "mediana" << std::setw(13)
+                  << "media" << std::setw(8) << "cv%" << std::setw(13) << "min"
+                  << std::setw(13) << "max" << "\n";
+        for (size_t i = 0; i < members.size(); i++) {
+            const std::vector<Sample>& samples = members[i]->second.samples;
+            std::vector<double> times;
+            for (size_t j = 0; j < samples.size(); j++) times.push_back(samples[j].time_per_iter_s);
+            const Stats stats = computeStats(times);
+            std::cout << "   " << std::left << std::setw(40) << members[i]->first << std::right
+                      << std::setw(6) << stats.n << std::setw(13) << formatTime(stats.median)
+                      << std::setw(13) << formatTime(stats.mean) << std::setw(8)
+                      << std::fixed << std::setprecision(1)
+                      << (stats.mean > 0 ? 100.0 * stats.stddev / stats.mean : 0.0)
+                      << std::setw(13) << formatTime(stats.min) << std::setw(13)
+                      << formatTime(stats.max) << "\n";
+        }
+    }
+}
+
+// ============================================================
+// Rankings de eficiencia energética
+// ============================================================
+
+struct Ranked {
+    std::string name;
+    double j_per_item;
+    double edp_per_iter;
+};
+
+// Por tamaño, los benchmarks que hacen el mismo trabajo ordenados por
+// julios por elemento; el EDP por iteración al lado
+void printRankings(const SeriesMap& series, size_t top) {
+    std::cout << "\n" << std::string(80, '=') << "\n"
+              << "RANKINGS DE EFICIENCIA ENERGÉTICA (medianas)\n"
+              << std::string(80, '=') << "\n";
+
+    std::map<int64_t, std::vector<Ranked> > by_size;
+    bool any_energy = false;
+    for (SeriesMap::const_iterator it = series.begin(); it != series.end(); ++it) {
+        const std::vector<Sample>& samples = it->second.samples;
+        Ranked ranked;
+        ranked.name = it->first;
+        ranked.j_per_item = medianOf(samples, 0, samples.size(), &Sample::j_per_item);
+        ranked.edp_per_iter = medianOf(samples, 0, samples.size(), &Sample::edp_per_iter);
+        if (ranked.edp_per_iter <= 0.0) continue;  // sin RAPL
+        any_energy = true;
+        by_size[it->second.size].push_back(ranked);
+    }
+    if (!any_energy) {
+        std::cout << "\n⚠️  Sin datos de energía (RAPL no disponible al medir)\n";
+        return;
+    }
+
+    for (auto it = by_size.begin(); it != by_size.end(); ++it) {
+        std::vector<Ranked>& ranked = it->second;
+        if (ranked.size() < 2) continue;  // nada con lo que comparar
+        std::sort(ranked.begin(), ranked.end(), [](const Ranked& a, const Ranked& b) {
+            // Sin elementos van al final, ordenados por EDP
+            if ((a.j_per_item > 0) != (b.j_per_item > 0)) return a.j_per_item > 0;
+            if (a.j_per_item != b.j_per_item) return a.j_per_item < b.j_per_item;
+            return a.edp_per_iter < b.edp_per_iter;
+        });
+        std::cout << "\n⚡ N = " << it->first << "\n";
+        std::cout << "   " << std::left << std::setw(4) << "#" << std::setw(40) << "benchmark"
+                  << std::right << std::setw(14) << "J/elemento" << std::setw(16)
+                  << "EDP/iter (J·s)" << "\n";
+        for (size_t i = 0; i < ranked.size() && i < top; i++) {
+            std::cout << "   " << std::left << std::setw(4) << i + 1 << std::setw(40)
+                      << ranked[i].name << std::right << std::scientific
+                      << std::setprecision(3) << std::setw(14);
+            if (ranked[i].j_per_item > 0) std::cout << ranked[i].j_per_item;
+            else std::cout << "-";
+            std::cout << std::setw(16) << ranked[i].edp_per_iter << "\n";
+        }
+        std::cout << std::defaultfloat;
+    }
+}
+
+// ============================================================
+// Regresiones
+// ============================================================
+
+// Compara la mediana de las últimas `window` ejecuciones de cada benchmark
+// con la de las `baseline` anteriores. Devuelve cuántas ha marcado.
+size_t printRegressions(const SeriesMap& series, const Options& options) {
+    std::cout << "\n" << std::string(80, '=') << "\n"
+              << "REGRESIONES (últimas " << options.window << " ejecuciones frente a las "
+              << options.baseline << " anteriores, umbral " << options.threshold << "%)\n"
+              << std::string(80, '=') << "\n\n";
+
+    size_t compared = 0;
+    size_t regressions = 0;
+    for (SeriesMap::const_iterator it = series.begin(); it != series.end(); ++it) {
+        const std::vector<Sample>& samples = it->second.samples;
+        if (samples.size() < options.window + 1) continue;
+        const size_t current_begin = samples.size() - options.window;
+        const size_t base_begin = current_begin > options.baseline
+            ? current_begin - options.baseline : 0;
+        compared++;
+
+        const struct {
+            const char* what;
+            double Sample::*field;
+        } metrics[] = {
+            {"tiempo", &Sample::time_per_iter_s},
+            {"energía", &Sample::energy_per_iter_j},
+        };
+        for (size_t m = 0; m < sizeof(metrics) / sizeof(metrics[0]); m++) {
+            const double base = medianOf(samples, base_begin, current_begin, metrics[m].field);
+            const double current = medianOf(samples, current_begin, samples.size(),
+                                            metrics[m].field);
+            if (base <= 0.0) continue;  // p. ej. sin energía
+            const double change_pct = 100.0 * (current / base - 1.0);
+            if (change_pct <= options.threshold) continue;
+
+            // Ruido: la línea base ya varía más que el umbral
+            std::vector<double> base_values;
+            for (size_t i = base_begin; i < current_begin; i++) {
+                base_values.push_back(samples[i].*metrics[m].field);
+            }
+            const Stats stats = computeStats(base_values);
+            const bool noisy = stats.mean > 0 &&
+                               100.0 * stats.stddev / stats.mean > options.threshold;
+
+            regressions++;
+            std::cout << "  🔴 " << it->first << ": " << metrics[m].what << " +"
+                      << std::fixed << std::setprecision(1) << change_pct << "% (";
+            if (metrics[m].field == &Sample::time_per_iter_s) {
+                std::cout << formatTime(base) << " → " << formatTime(current);
+            } else {
+                std::cout << std::scientific << std::setprecision(3) << base << " J → "
+                          << current << " J";
+            }
+            std::cout << std::defaultfloat << ")"
+                      << (noisy ? "  ⚠️  línea base ruidosa" : "") << "\n";
+        }
+    }
+    if (regressions == 0) {
+        std::cout << "  ✅ Sin regresiones (" << compared << " benchmarks con historial suficiente)\n";
+    }
+    return regressions;
+}
+
+} // namespace
+
+// ============================================================
+// MAIN
+// ============================================================
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    MappedFile file;
+    if (!file.open(options.filename)) {
+        std::cerr << "❌ Error: no se pudo abrir " << options.filename << ": "
+                  << strerror(errno) << std::endl;
+        return 2;
+    }
+
+    // Línea de versión ("# schema_version=N") y cabecera
+    const char* p = file.begin();
+    int schema_version = 1;
+    while (p < file.end() && *p == '#') {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', file.end() - p));
+        const std::string line(p, eol ? eol : file.end());
+        const size_t eq = line.find("schema_version=");
+        if (eq != std::string::npos) schema_version = atoi(line.c_str() + eq + 15);
+        p = eol ? eol + 1 : file.end();
+    }
+    std::vector<Field> header;
+    size_t num_columns = 0;
+    p = splitLine(p, file.end(), static_cast<size_t>(-1), &header, &num_columns);
+    const Columns columns = findColumns(header, num_columns);
+    if (columns.benchmark < 0 || columns.n < 0 || columns.time_s < 0 || columns.energy_j < 0 ||
+        (columns.iterations < 0 && columns.energy_per_iter_j < 0)) {
+        std::cerr << "❌ Error: " << options.filename
+                  << " no tiene las columnas de results_cpp.csv" << std::endl;
+        return 2;
+    }
+    if (columns.iterations < 0) {
+        std::cerr << "⚠️  Esquema " << schema_version << " sin columna iterations: se usa el"
+                  << " tiempo de la región completa en lugar del de una iteración" << std::endl;
+    }
+
+    // Un trozo por hilo; cada uno llena su mapa y luego se unen en orden
+    const std::vector<const char*> bounds = splitChunks(p, file.end(), options.threads);
+    const size_t num_chunks = bounds.size() - 1;
+    std::vector<PartialMap> partial(num_chunks);
+    std::vector<size_t> rows(num_chunks, 0);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < num_chunks; i++) {
+        workers.push_back(std::thread(parseChunk, bounds[i], bounds[i + 1], columns,
+                                      &partial[i], &rows[i]));
+    }
+    size_t total_rows = 0;
+    for (size_t i = 0; i < num_chunks; i++) {
+        workers[i].join();
+        total_rows += rows[i];
+    }
+    SeriesMap series;
+    for (size_t i = 0; i < num_chunks; i++) {
+        for (PartialMap::iterator it = partial[i].begin(); it != partial[i].end(); ++it) {
+            Series& s = series[it->first];
+            if (s.samples.empty()) {
+                s.family = it->second.family;
+                s.size = it->second.size;
+            }
+            s.samples.insert(s.samples.end(), it->second.samples.begin(),
+                             it->second.samples.end());
+        }
+    }
+
+    std::cout << "📊 " << options.filename << ": " << total_rows << " ejecuciones de "
+              << series.size() << " benchmarks (esquema " << schema_version << ", "
+              << num_chunks << " trozos)\n";
+
+    printStats(series);
+    printRankings(series, options.top);
+    const size_t regressions = printRegressions(series, options);
+    std::cout << std::endl;
+    return regressions > 0 ? 1 : 0;
+}
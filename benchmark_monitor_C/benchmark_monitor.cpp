@@ -1,23 +1,49 @@
 // benchmark_monitor.cpp - Microbenchmarks con monitoreo de sistema completo
 #include <benchmark/benchmark.h>
 #include "system_monitor.h"
+#include "simd_kernels.h"
+#include "gemm_kernels.h"
+#include "memory_kernels.h"
+#include <algorithm>
+#include <memory>
 #include <vector>
 #include <cstring>
 #include <ctime>
 #include <iomanip>
 #include <sstream>
 #include <iostream>
+#include <deque>
+#include <thread>
 #include <unistd.h>  // Para geteuid()
 
 using namespace system_monitor;
+using simd_kernels::Scalar;
+using simd_kernels::SSE2;
+using simd_kernels::AVX2;
+using simd_kernels::AVX512;
 
 // ============================================================
 // Variables globales para monitoreo
 // ============================================================
 static SystemMonitor* g_monitor = nullptr;
-static CSVWriter* g_csv_writer = nullptr;
-static uint64_t g_energy_start = 0;
-static double g_temp_start = 0.0;
+static PowerSampler* g_sampler = nullptr;
+
+// Periodo de muestreo de RAPL, temperatura y frecuencia
+static const int kSampleIntervalMs = 10;
+static const char* const kResultsFile = "results_cpp.csv";
+static const char* const kPowerSeriesFile = "power_series_cpp.csv";
+static const char* const kLatencyCurveFile = "latency_curve_cpp.csv";
+static const char* const kBandwidthCurveFile = "bandwidth_curve_cpp.csv";
+
+// Perfiles de potencia pendientes de reportar. Cada llamada a la función del
+// benchmark (también las de calentamiento y estimación de iteraciones) deja
+// uno; el reporter se queda con los que tienen las mismas iteraciones que las
+// ejecuciones reportadas y descarta el resto.
+struct PendingProfile {
+    int64_t iterations;
+    PowerProfile profile;
+};
+static std::deque<PendingProfile> g_pending_profiles;
 
 // ============================================================
 // Utilidades
@@ -31,27 +57,169 @@ std::string getCurrentTimestamp() {
     return oss.str();
 }
 
+// Nombres de los contadores dentro de state.counters
+static const char* const kCounterInstructions = "perf_instructions";
+static const char* const kCounterCycles = "perf_cycles";
+static const char* const kCounterCacheMisses = "perf_cache_misses";
+static const char* const kCounterBranchMisses = "perf_branch_misses";
+static const char* const kCounterTaskClock = "perf_task_clock_ns";
+static const char* const kCounterThreads = "region_threads";
+static const char* const kCounterEnergy = "energy_J";
+static const char* const kCounterTime = "region_time_s";
+static const char* const kCounterPowerPeak = "power_peak_W";
+static const char* const kCounterTemperature = "temperature_C";
+static const char* const kCounterFreq = "cpu_freq_MHz";
+static const char* const kCounterGFLOPS = "GFLOPS";
+static const char* const kCounterPeakPct = "peak_pct";
+static const char* const kCounterLatency = "latency_ns";
+static const char* const kCounterBandwidth = "bandwidth_GBs";
+static const char* const kCounterMemThreads = "mem_threads";
+static const char* const kCounterWorkingSet = "working_set_B";
+
+// Política de los buffers de entrada: páginas grandes transparentes,
+// alineados a 64 bytes y ya tocados. La librería los reutiliza entre las
+// instancias de una familia, así que los fallos de página se pagan una vez.
+static benchmark::BufferPolicy inputPolicy() {
+    benchmark::BufferPolicy policy;
+    policy.pages = benchmark::BufferPolicy::kTransparentHugePages;
+    return policy;
+}
+
+// Buffer de `count` elementos con todos a `value`. Si no se puede reservar,
+// el benchmark queda saltado con error (state.skipped()).
+template <class T>
+T* inputBuffer(benchmark::State& state, size_t count, T value) {
+    T* data = state.AllocateBuffer<T>(count, inputPolicy());
+    if (data != nullptr) {
+        std::fill(data, data + count, value);
+    }
+    return data;
+}
+
+// Entrada de solo lectura de `count` elementos a `value`. Se construye una
+// sola vez por proceso y la comparten todas las familias, instancias y
+// repeticiones que piden el mismo tamaño y valor (p. ej. A y B de todas las
+// variantes de GEMM). La tasa de aciertos y el tiempo de construcción
+// aparecen como contadores shared_data_* en el CSV.
+template <class T>
+std::shared_ptr<const std::vector<T> > sharedInput(size_t count, T value) {
+    std::ostringstream key;
+    key << "input/" << sizeof(T) << "/" << count << "/" << static_cast<double>(value);
+    return benchmark::SharedData<std::vector<T> >(key.str(), [count, value]() {
+        return std::vector<T>(count, value);
+    });
+}
+
+// true para los contadores que recordMeasurement() guarda para las columnas
+// fijas del CSV; el resto van como columnas propias
+bool isMonitorCounter(const std::string& name) {
+    static const char* const kNames[] = {
+        kCounterInstructions, kCounterCycles, kCounterCacheMisses, kCounterBranchMisses,
+        kCounterTaskClock, kCounterThreads, kCounterEnergy, kCounterTime, kCounterPowerPeak, kCounterTemperature, kCounterFreq
+    };
+    for (size_t i = 0; i < sizeof(kNames) / sizeof(kNames[0]); i++) {
+        if (name == kNames[i]) return true;
+    }
+    return false;
+}
+
+// Empieza a medir la región medida (el bucle `for (auto _ : state)`)
+void startMeasurement() {
+    g_sampler->start();
+    g_monitor->startPerfCounters();
+}
+
+// Termina la medición y guarda los resultados en state.counters, para que
+// cada ejecución reportada lleve los suyos propios. `threads` son los hilos
+// que ejecutaron la región: los de perf los suman todos (los hilos de
+// trabajo heredan los contadores del hilo medido).
+void recordMeasurement(benchmark::State& state, int threads = 1) {
+    PerfMetrics perf = g_monitor->stopPerfCounters();
+    PowerProfile profile = g_sampler->stop();
+    
+    state.counters[kCounterInstructions] = static_cast<double>(perf.instructions);
+    state.counters[kCounterCycles] = static_cast<double>(perf.cycles);
+    state.counters[kCounterCacheMisses] = static_cast<double>(perf.cache_misses);
+    state.counters[kCounterBranchMisses] = static_cast<double>(perf.branch_misses);
+    state.counters[kCounterTaskClock] = static_cast<double>(perf.task_clock_ns);
+    state.counters[kCounterThreads] = threads;
+    
+    state.counters[kCounterEnergy] = profile.energy_j;
+    state.counters[kCounterTime] = profile.time_s;
+    state.counters[kCounterPowerPeak] = profile.power_peak_w;
+    state.counters[kCounterTemperature] = profile.temperature_avg_c;
+    state.counters[kCounterFreq] = profile.freq_avg_mhz;
+    
+    PendingProfile pending;
+    pending.iterations = state.iterations();
+    pending.profile = std::move(profile);
+    g_pending_profiles.push_back(std::move(pending));
+}
+
+// Saca el perfil de la ejecución reportada `run` (y descarta los de las
+// llamadas anteriores)
+bool takePendingProfile(const benchmark::BenchmarkReporter::Run& run,
+                        PowerProfile* profile) {
+    while (!g_pending_profiles.empty()) {
+        PendingProfile pending = std::move(g_pending_profiles.front());
+        g_pending_profiles.pop_front();
+        if (pending.iterations == run.iterations) {
+            *profile = std::move(pending.profile);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Lee un contador de un Run (0 si no existe)
+double getCounter(const benchmark::BenchmarkReporter::Run& run, const char* name) {
+    auto it = run.counters.find(name);
+    return it != run.counters.end() ? it->second.value : 0.0;
+}
+
+// Resumen específico del kernel para la consola: ", 123 GFLOP/s (45% del
+// pico)" para los GEMM, la latencia del pointer chase o el ancho de banda de
+// STREAM; vacío para el resto
+std::string kernelSummary(const benchmark::BenchmarkReporter::Run& run) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1);
+    if (run.counters.find(kCounterGFLOPS) != run.counters.end()) {
+        oss << ", " << getCounter(run, kCounterGFLOPS) << " GFLOP/s"
+            << " (" << getCounter(run, kCounterPeakPct) << "% del pico)";
+    } else if (run.counters.find(kCounterLatency) != run.counters.end()) {
+        oss << std::setprecision(2) << ", " << getCounter(run, kCounterLatency)
+            << " ns/carga [" << run.report_label << "]";
+    } else if (run.counters.find(kCounterBandwidth) != run.counters.end()) {
+        oss << ", " << getCounter(run, kCounterBandwidth) << " GB/s ["
+            << run.report_label << "]";
+    }
+    return oss.str();
+}
+
 // ============================================================
 // BENCHMARK 1: Vector Add (Suma de Vectores)
 // ============================================================
 static void BM_VectorAdd(benchmark::State& state) {
     const int64_t N = state.range(0);
     
-    std::vector<double> a(N, 1.0);
-    std::vector<double> b(N, 2.0);
-    std::vector<double> c(N, 0.0);
+    std::shared_ptr<const std::vector<double> > aInput = sharedInput<double>(N, 1.0);
+    const double* a = aInput->data();
+    std::shared_ptr<const std::vector<double> > bInput = sharedInput<double>(N, 2.0);
+    const double* b = bInput->data();
+    double* c = inputBuffer<double>(state, N, 0.0);
+    if (state.skipped()) return;
     
-    // Medición inicial
-    g_energy_start = g_monitor->readRAPLEnergy();
-    g_temp_start = g_monitor->getTemperature();
+    // Medición de la región medida
+    startMeasurement();
     
     for (auto _ : state) {
         for (int64_t i = 0; i < N; i++) {
             c[i] = a[i] + b[i];
         }
-        benchmark::DoNotOptimize(c.data());
+        benchmark::DoNotOptimize(c);
         benchmark::ClobberMemory();
     }
+    recordMeasurement(state);
     
     // Calcular bytes procesados
     state.SetBytesProcessed(state.iterations() * N * sizeof(double) * 3);
@@ -66,11 +234,13 @@ BENCHMARK(BM_VectorAdd)->Range(1<<14, 1<<20)->Unit(benchmark::kMillisecond);
 static void BM_DotProduct(benchmark::State& state) {
     const int64_t N = state.range(0);
     
-    std::vector<double> a(N, 1.5);
-    std::vector<double> b(N, 2.5);
+    std::shared_ptr<const std::vector<double> > aInput = sharedInput<double>(N, 1.5);
+    const double* a = aInput->data();
+    std::shared_ptr<const std::vector<double> > bInput = sharedInput<double>(N, 2.5);
+    const double* b = bInput->data();
+    if (state.skipped()) return;
     
-    g_energy_start = g_monitor->readRAPLEnergy();
-    g_temp_start = g_monitor->getTemperature();
+    startMeasurement();
     
     for (auto _ : state) {
         double result = 0.0;
@@ -79,6 +249,7 @@ static void BM_DotProduct(benchmark::State& state) {
         }
         benchmark::DoNotOptimize(result);
     }
+    recordMeasurement(state);
     
     // 2 operaciones por elemento (mul + add)
     state.SetItemsProcessed(state.iterations() * N * 2);
@@ -92,21 +263,25 @@ BENCHMARK(BM_DotProduct)->Range(1<<14, 1<<20)->Unit(benchmark::kMillisecond);
 static void BM_MemCpy(benchmark::State& state) {
     const int64_t N = state.range(0);
     
-    std::vector<char> src(N, 'A');
-    std::vector<char> dst(N, 'B');
+    std::shared_ptr<const std::vector<char> > srcInput = sharedInput<char>(N, 'A');
+    const char* src = srcInput->data();
+    char* dst = inputBuffer<char>(state, N, 'B');
+    if (state.skipped()) return;
     
-    g_energy_start = g_monitor->readRAPLEnergy();
-    g_temp_start = g_monitor->getTemperature();
+    startMeasurement();
     
     for (auto _ : state) {
-        memcpy(dst.data(), src.data(), N);
+        memcpy(dst, src, N);
         benchmark::ClobberMemory();
     }
+    recordMeasurement(state);
     
     state.SetBytesProcessed(state.iterations() * N);
 }
 
-BENCHMARK(BM_MemCpy)->Range(1<<14, 1<<24)->Unit(benchmark::kMillisecond);
+// Conjuntos de trabajo alrededor de cada nivel de caché de la máquina (dos
+// buffers de N bytes); la etiqueta del reporte es el nivel ("L1" ... "DRAM")
+BENCHMARK(BM_MemCpy)->WorkingSetSweep(2)->Unit(benchmark::kMillisecond);
 
 // ============================================================
 // BENCHMARK 4: Loop Copy (comparación con memcpy)
@@ -114,11 +289,12 @@ BENCHMARK(BM_MemCpy)->Range(1<<14, 1<<24)->Unit(benchmark::kMillisecond);
 static void BM_LoopCopy(benchmark::State& state) {
     const int64_t N = state.range(0);
     
-    std::vector<char> src(N, 'A');
-    std::vector<char> dst(N, 'B');
+    std::shared_ptr<const std::vector<char> > srcInput = sharedInput<char>(N, 'A');
+    const char* src = srcInput->data();
+    char* dst = inputBuffer<char>(state, N, 'B');
+    if (state.skipped()) return;
     
-    g_energy_start = g_monitor->readRAPLEnergy();
-    g_temp_start = g_monitor->getTemperature();
+    startMeasurement();
     
     for (auto _ : state) {
         for (int64_t i = 0; i < N; i++) {
@@ -126,11 +302,12 @@ static void BM_LoopCopy(benchmark::State& state) {
         }
         benchmark::ClobberMemory();
     }
+    recordMeasurement(state);
     
     state.SetBytesProcessed(state.iterations() * N);
 }
 
-BENCHMARK(BM_LoopCopy)->Range(1<<14, 1<<24)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoopCopy)->WorkingSetSweep(2)->Unit(benchmark::kMillisecond);
 
 // ============================================================
 // BENCHMARK 5: Matrix Multiply (Multiplicación de Matrices)
@@ -140,12 +317,14 @@ static void BM_MatrixMultiply(benchmark::State& state) {
     const int K = state.range(1);
     const int N = state.range(2);
     
-    std::vector<float> A(M * K, 1.0f);
-    std::vector<float> B(K * N, 2.0f);
-    std::vector<float> C(M * N, 0.0f);
+    std::shared_ptr<const std::vector<float> > AInput = sharedInput<float>(M * K, 1.0f);
+    const float* A = AInput->data();
+    std::shared_ptr<const std::vector<float> > BInput = sharedInput<float>(K * N, 2.0f);
+    const float* B = BInput->data();
+    float* C = inputBuffer<float>(state, M * N, 0.0f);
+    if (state.skipped()) return;
     
-    g_energy_start = g_monitor->readRAPLEnergy();
-    g_temp_start = g_monitor->getTemperature();
+    startMeasurement();
     
     for (auto _ : state) {
         for (int i = 0; i < M; i++) {
@@ -157,9 +336,10 @@ static void BM_MatrixMultiply(benchmark::State& state) {
                 C[i * N + j] = sum;
             }
         }
-        benchmark::DoNotOptimize(C.data());
+        benchmark::DoNotOptimize(C);
         benchmark::ClobberMemory();
     }
+    recordMeasurement(state);
     
     // FLOPS = 2 * M * N * K
     state.SetItemsProcessed(state.iterations() * 2 * M * N * K);
@@ -171,21 +351,480 @@ BENCHMARK(BM_MatrixMultiply)->Args({32, 32, 32})
                              ->Unit(benchmark::kMillisecond);
 
 // ============================================================
-// Custom Reporter para CSV con métricas del sistema
+// BENCHMARKS SIMD: los mismos kernels por nivel de ISA
 // ============================================================
-class SystemMetricsReporter : public benchmark::BenchmarkReporter {
-public:
-    SystemMetricsReporter() : monitor_(new SystemMonitor()) {
-        csv_writer_ = new CSVWriter("results_cpp.csv");
+//
+// Una instancia por ISA (BM_VectorAddSIMD<AVX2>, ...). El binario se compila
+// una vez y el nivel se elige en tiempo de ejecución con cpuid; si la CPU no
+// lo soporta, la ejecución se salta con un error en lugar de dar SIGILL.
+
+// true si se puede ejecutar el kernel del nivel ISA; si no, salta el benchmark
+template <class ISA>
+bool checkISA(benchmark::State& state) {
+    if (simd_kernels::isSupported(ISA::kLevel)) return true;
+    state.SkipWithError((std::string(ISA::name()) + " no soportado por esta CPU").c_str());
+    return false;
+}
+
+template <class ISA>
+static void BM_VectorAddSIMD(benchmark::State& state) {
+    if (!checkISA<ISA>(state)) return;
+    const int64_t N = state.range(0);
+    
+    std::shared_ptr<const std::vector<double> > aInput = sharedInput<double>(N, 1.0);
+    const double* a = aInput->data();
+    std::shared_ptr<const std::vector<double> > bInput = sharedInput<double>(N, 2.0);
+    const double* b = bInput->data();
+    double* c = inputBuffer<double>(state, N, 0.0);
+    if (state.skipped()) return;
+    
+    startMeasurement();
+    
+    for (auto _ : state) {
+        ISA::vectorAdd(a, b, c, N);
+        benchmark::DoNotOptimize(c);
+        benchmark::ClobberMemory();
+    }
+    recordMeasurement(state);
+    
+    state.SetBytesProcessed(state.iterations() * N * sizeof(double) * 3);
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+BENCHMARK_TEMPLATE(BM_VectorAddSIMD, Scalar)->Range(1<<14, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_VectorAddSIMD, SSE2)->Range(1<<14, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_VectorAddSIMD, AVX2)->Range(1<<14, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_VectorAddSIMD, AVX512)->Range(1<<14, 1<<20)->Unit(benchmark::kMillisecond);
+
+template <class ISA>
+static void BM_DotProductSIMD(benchmark::State& state) {
+    if (!checkISA<ISA>(state)) return;
+    const int64_t N = state.range(0);
+    
+    std::shared_ptr<const std::vector<double> > aInput = sharedInput<double>(N, 1.5);
+    const double* a = aInput->data();
+    std::shared_ptr<const std::vector<double> > bInput = sharedInput<double>(N, 2.5);
+    const double* b = bInput->data();
+    if (state.skipped()) return;
+    
+    startMeasurement();
+    
+    for (auto _ : state) {
+        double result = ISA::dotProduct(a, b, N);
+        benchmark::DoNotOptimize(result);
+    }
+    recordMeasurement(state);
+    
+    // 2 operaciones por elemento (mul + add)
+    state.SetItemsProcessed(state.iterations() * N * 2);
+}
+
+BENCHMARK_TEMPLATE(BM_DotProductSIMD, Scalar)->Range(1<<14, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_DotProductSIMD, SSE2)->Range(1<<14, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_DotProductSIMD, AVX2)->Range(1<<14, 1<<20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_DotProductSIMD, AVX512)->Range(1<<14, 1<<20)->Unit(benchmark::kMillisecond);
+
+template <class ISA>
+static void BM_CopySIMD(benchmark::State& state) {
+    if (!checkISA<ISA>(state)) return;
+    const int64_t N = state.range(0);
+    
+    std::shared_ptr<const std::vector<char> > srcInput = sharedInput<char>(N, 'A');
+    const char* src = srcInput->data();
+    char* dst = inputBuffer<char>(state, N, 'B');
+    if (state.skipped()) return;
+    
+    startMeasurement();
+    
+    for (auto _ : state) {
+        ISA::copy(src, dst, N);
+        benchmark::ClobberMemory();
+    }
+    recordMeasurement(state);
+    
+    state.SetBytesProcessed(state.iterations() * N);
+}
+
+BENCHMARK_TEMPLATE(BM_CopySIMD, Scalar)->Range(1<<14, 1<<24)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CopySIMD, SSE2)->Range(1<<14, 1<<24)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CopySIMD, AVX2)->Range(1<<14, 1<<24)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CopySIMD, AVX512)->Range(1<<14, 1<<24)->Unit(benchmark::kMillisecond);
+
+template <class ISA>
+static void BM_MatrixMultiplySIMD(benchmark::State& state) {
+    if (!checkISA<ISA>(state)) return;
+    const int M = state.range(0);
+    const int K = state.range(1);
+    const int N = state.range(2);
+    
+    std::shared_ptr<const std::vector<float> > AInput = sharedInput<float>(M * K, 1.0f);
+    const float* A = AInput->data();
+    std::shared_ptr<const std::vector<float> > BInput = sharedInput<float>(K * N, 2.0f);
+    const float* B = BInput->data();
+    float* C = inputBuffer<float>(state, M * N, 0.0f);
+    if (state.skipped()) return;
+    
+    startMeasurement();
+    
+    for (auto _ : state) {
+        ISA::matMul(A, B, C, M, K, N);
+        benchmark::DoNotOptimize(C);
+        benchmark::ClobberMemory();
+    }
+    recordMeasurement(state);
+    
+    // FLOPS = 2 * M * N * K
+    state.SetItemsProcessed(state.iterations() * 2 * M * N * K);
+}
+
+BENCHMARK_TEMPLATE(BM_MatrixMultiplySIMD, Scalar)->Args({32, 32, 32})->Args({64, 64, 64})
+                                                 ->Args({128, 128, 128})
+                                                 ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MatrixMultiplySIMD, SSE2)->Args({32, 32, 32})->Args({64, 64, 64})
+                                               ->Args({128, 128, 128})
+                                               ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MatrixMultiplySIMD, AVX2)->Args({32, 32, 32})->Args({64, 64, 64})
+                                               ->Args({128, 128, 128})
+                                               ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MatrixMultiplySIMD, AVX512)->Args({32, 32, 32})->Args({64, 64, 64})
+                                                 ->Args({128, 128, 128})
+                                                 ->Unit(benchmark::kMillisecond);
+
+// ============================================================
+// GEMM: naive, ikj, por bloques, empaquetado y multihilo
+// ============================================================
+//
+// C = A × B con matrices cuadradas de float. Cada variante informa de
+// GFLOPS (2·M·N·K por iteración sobre el tiempo de la región medida) y de
+// peak_pct, el porcentaje del pico teórico de los núcleos que usa. Al crecer
+// el tamaño, las variantes sin bloques caen cuando B deja de caber en cada
+// nivel de caché; las empaquetadas deberían mantenerse cerca del pico.
+
+// Tamaños de bloque a partir de las cachés de cpu0. Con varios hilos cada
+// uno se queda con su parte de la L3 compartida.
+gemm_kernels::BlockSizes gemmBlockSizes(int num_threads) {
+    int64_t level_bytes[4] = {0, 0, 0, 0};
+    int l3_sharing = 1;
+    const std::vector<CacheLevel> caches = g_monitor->getCPUInfo().caches;
+    for (size_t i = 0; i < caches.size(); i++) {
+        if (caches[i].level >= 1 && caches[i].level <= 3) {
+            level_bytes[caches[i].level] = caches[i].size_bytes;
+            if (caches[i].level == 3) l3_sharing = caches[i].num_sharing;
+        }
+    }
+    const int l3_users = std::max(1, std::min(num_threads, l3_sharing));
+    return gemm_kernels::blockSizesFromCaches(level_bytes[1], level_bytes[2],
+                                              level_bytes[3] / l3_users);
+}
+
+// Nivel de ISA más alto que soporta la CPU
+simd_kernels::ISALevel bestISA() {
+    if (simd_kernels::isSupported(simd_kernels::kISAAVX512)) return simd_kernels::kISAAVX512;
+    if (simd_kernels::isSupported(simd_kernels::kISAAVX2)) return simd_kernels::kISAAVX2;
+    if (simd_kernels::isSupported(simd_kernels::kISASSE2)) return simd_kernels::kISASSE2;
+    return simd_kernels::kISAScalar;
+}
+
+// GFLOP/s teóricos de `num_threads` núcleos con el nivel `isa`, a la
+// frecuencia base (o la actual si no se conoce); 0 si no hay frecuencia
+double peakGFLOPS(simd_kernels::ISALevel isa, int num_threads) {
+    double freq_mhz = g_monitor->getBaseFreqMHz();
+    if (freq_mhz == 0.0) freq_mhz = g_monitor->getCPUFreqMHz(0);
+    if (freq_mhz == 0.0) freq_mhz = benchmark::CPUInfo::Get().cycles_per_second / 1e6;
+    return freq_mhz / 1000.0 * gemm_kernels::flopsPerCycle(isa) * num_threads;
+}
+
+// GFLOPS y peak_pct, a partir del tiempo de la región que dejó
+// recordMeasurement()
+void setGemmCounters(benchmark::State& state, int M, int K, int N, double peak_gflops) {
+    const double flops = 2.0 * M * N * K * state.iterations();
+    const double time_s = state.counters[kCounterTime];
+    const double gflops = time_s > 0.0 ? flops / time_s / 1e9 : 0.0;
+    state.counters[kCounterGFLOPS] = gflops;
+    state.counters[kCounterPeakPct] = peak_gflops > 0.0 ? 100.0 * gflops / peak_gflops : 0.0;
+    state.SetItemsProcessed(static_cast<int64_t>(flops));
+}
+
+// Matrices cuadradas de 128 a `max_size`
+template <int max_size>
+static void gemmSizes(benchmark::internal::Benchmark* b) {
+    for (int n = 128; n <= max_size; n *= 2) {
+        b->Args({n, n, n});
+    }
+}
+
+// Matrices de 1024 a 4096 con 1, 2, 4, ... hilos hasta los de la máquina
+static void gemmThreadSizes(benchmark::internal::Benchmark* b) {
+    const int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int n = 1024; n <= 4096; n *= 2) {
+        for (int t = 1; ; t *= 2) {
+            const int threads = std::min(t, max_threads);
+            b->Args({n, n, n, threads});
+            if (threads == max_threads) break;
+        }
+    }
+}
+
+// Una variante de un solo hilo: kernel(A, B, C, M, K, N)
+template <void (*Kernel)(const float*, const float*, float*, int, int, int)>
+static void BM_GemmSimple(benchmark::State& state) {
+    const int M = state.range(0);
+    const int K = state.range(1);
+    const int N = state.range(2);
+    
+    std::shared_ptr<const std::vector<float> > AInput = sharedInput<float>(static_cast<size_t>(M) * K, 1.0f);
+    const float* A = AInput->data();
+    std::shared_ptr<const std::vector<float> > BInput = sharedInput<float>(static_cast<size_t>(K) * N, 2.0f);
+    const float* B = BInput->data();
+    float* C = inputBuffer<float>(state, static_cast<size_t>(M) * N, 0.0f);
+    if (state.skipped()) return;
+    
+    startMeasurement();
+    
+    for (auto _ : state) {
+        Kernel(A, B, C, M, K, N);
+        benchmark::DoNotOptimize(C);
+        benchmark::ClobberMemory();
+    }
+    recordMeasurement(state);
+    
+    setGemmCounters(state, M, K, N, peakGFLOPS(bestISA(), 1));
+}
+
+static void gemmBlockedWithCaches(const float* A, const float* B, float* C,
+                                  int M, int K, int N) {
+    static const gemm_kernels::BlockSizes blocks = gemmBlockSizes(1);
+    gemm_kernels::gemmBlocked(A, B, C, M, K, N, blocks);
+}
+
+static void BM_GemmNaive(benchmark::State& state) {
+    BM_GemmSimple<gemm_kernels::gemmNaive>(state);
+}
+static void BM_GemmIKJ(benchmark::State& state) {
+    BM_GemmSimple<gemm_kernels::gemmIKJ>(state);
+}
+static void BM_GemmBlocked(benchmark::State& state) {
+    BM_GemmSimple<gemmBlockedWithCaches>(state);
+}
+
+// El naive a 4096³ tarda minutos por iteración; su caída ya se ve antes
+BENCHMARK(BM_GemmNaive)->Apply(gemmSizes<1024>)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_GemmIKJ)->Apply(gemmSizes<2048>)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_GemmBlocked)->Apply(gemmSizes<4096>)->Unit(benchmark::kMillisecond);
+
+// Paneles empaquetados con micro-kernel de ISA. Con 4 argumentos
+// (M, K, N, hilos) reparte las filas de C entre hilos propios.
+template <class ISA>
+static void BM_GemmPacked(benchmark::State& state) {
+    if (!checkISA<ISA>(state)) return;
+    const int M = state.range(0);
+    const int K = state.range(1);
+    const int N = state.range(2);
+    const int num_threads = state.range(3);
+    const gemm_kernels::BlockSizes blocks = gemmBlockSizes(num_threads);
+    
+    std::shared_ptr<const std::vector<float> > AInput = sharedInput<float>(static_cast<size_t>(M) * K, 1.0f);
+    const float* A = AInput->data();
+    std::shared_ptr<const std::vector<float> > BInput = sharedInput<float>(static_cast<size_t>(K) * N, 2.0f);
+    const float* B = BInput->data();
+    float* C = inputBuffer<float>(state, static_cast<size_t>(M) * N, 0.0f);
+    if (state.skipped()) return;
+    
+    startMeasurement();
+    
+    for (auto _ : state) {
+        gemm_kernels::gemmPacked(ISA::kLevel, A, B, C, M, K, N,
+                                 blocks, num_threads);
+        benchmark::DoNotOptimize(C);
+        benchmark::ClobberMemory();
+    }
+    recordMeasurement(state, num_threads);
+    
+    setGemmCounters(state, M, K, N, peakGFLOPS(ISA::kLevel, num_threads));
+}
+
+// Un hilo: 4 argumentos con hilos = 1
+static void gemmPackedSizes(benchmark::internal::Benchmark* b) {
+    for (int n = 128; n <= 4096; n *= 2) {
+        b->Args({n, n, n, 1});
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_GemmPacked, AVX2)->Apply(gemmPackedSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GemmPacked, AVX512)->Apply(gemmPackedSizes)->Unit(benchmark::kMillisecond);
+
+// Multihilo: el tiempo de CPU del hilo del benchmark no cuenta el de los
+// hilos de trabajo, así que se reporta tiempo real
+BENCHMARK_TEMPLATE(BM_GemmPacked, AVX2)->Name("BM_GemmPackedMT<AVX2>")
+                                       ->Apply(gemmThreadSizes)->UseRealTime()
+                                       ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GemmPacked, AVX512)->Name("BM_GemmPackedMT<AVX512>")
+                                         ->Apply(gemmThreadSizes)->UseRealTime()
+                                         ->Unit(benchmark::kMillisecond);
+
+// ============================================================
+// Jerarquía de memoria: pointer chase y STREAM
+// ============================================================
+//
+// Se registran en main(), cuando ya se conocen las cachés: los tamaños del
+// pointer chase recorren cada nivel y los arrays de STREAM son 4 veces la
+// última caché, como pide STREAM. Cada punto se añade además a una curva
+// (latencia / conjunto de trabajo y ancho de banda / hilos) para comparar
+// máquinas.
+
+// Cargas dependientes por iteración del pointer chase
+static const int64_t kChaseSteps = 1 << 16;
+
+// Nivel de caché en el que cabe `bytes` ("L1", "L2", "L3" o "DRAM")
+std::string cacheLevelFor(int64_t bytes) {
+    const std::vector<CacheLevel> caches = g_monitor->getCPUInfo().caches;
+    for (size_t i = 0; i < caches.size(); i++) {
+        if (bytes <= caches[i].size_bytes) {
+            std::ostringstream oss;
+            oss << "L" << caches[i].level;
+            return oss.str();
+        }
+    }
+    return "DRAM";
+}
+
+// Latencia de carga con un conjunto de trabajo de range(0) bytes
+static void BM_PointerChase(benchmark::State& state, memory_kernels::PageKind kind) {
+    const int64_t bytes = state.range(0);
+    memory_kernels::Buffer buffer;
+    if (!memory_kernels::allocate(bytes, kind, &buffer)) {
+        state.SkipWithError("mmap falló");
+        return;
+    }
+    void* p = memory_kernels::buildChase(buffer.data, bytes, 42);
+    // Una vuelta entera para dejar las cachés y la TLB en régimen
+    p = memory_kernels::chase(p, bytes / memory_kernels::kChaseStride);
+    
+    startMeasurement();
+    
+    for (auto _ : state) {
+        p = memory_kernels::chase(p, kChaseSteps);
+        benchmark::DoNotOptimize(p);
     }
+    recordMeasurement(state);
     
-    ~SystemMetricsReporter() {
-        if (csv_writer_) {
-            csv_writer_->close();
-            delete csv_writer_;
+    const double loads = static_cast<double>(state.iterations()) * kChaseSteps;
+    state.counters[kCounterLatency] = state.counters[kCounterTime] * 1e9 / loads;
+    state.counters[kCounterWorkingSet] = static_cast<double>(bytes);
+    state.SetItemsProcessed(static_cast<int64_t>(loads));
+    state.SetLabel(cacheLevelFor(bytes) + "/" + buffer.pages);
+    memory_kernels::release(&buffer);
+}
+
+// STREAM con arrays de range(0) bytes y range(1) hilos
+static void BM_Stream(benchmark::State& state, memory_kernels::StreamKernel kernel,
+                      memory_kernels::PageKind kind, bool non_temporal) {
+    const int64_t array_bytes = state.range(0);
+    const int num_threads = state.range(1);
+    const int64_t n = array_bytes / sizeof(double);
+    
+    memory_kernels::Buffer a, b, c;
+    const bool ok_a = memory_kernels::allocate(array_bytes, kind, &a);
+    const bool ok_b = memory_kernels::allocate(array_bytes, kind, &b);
+    const bool ok_c = memory_kernels::allocate(array_bytes, kind, &c);
+    if (!ok_a || !ok_b || !ok_c) {
+        memory_kernels::release(&a);
+        memory_kernels::release(&b);
+        memory_kernels::release(&c);
+        state.SkipWithError("mmap falló");
+        return;
+    }
+    double* pa = static_cast<double*>(a.data);
+    double* pb = static_cast<double*>(b.data);
+    double* pc = static_cast<double*>(c.data);
+    memory_kernels::streamInit(pa, pb, pc, n, num_threads);
+    
+    startMeasurement();
+    
+    for (auto _ : state) {
+        memory_kernels::streamParallel(kernel, pa, pb, pc, 3.0, n, non_temporal, num_threads);
+        benchmark::ClobberMemory();
+    }
+    recordMeasurement(state, num_threads);
+    
+    const double bytes = static_cast<double>(state.iterations()) * n *
+                         memory_kernels::streamBytesPerElement(kernel);
+    const double time_s = state.counters[kCounterTime];
+    state.counters[kCounterBandwidth] = time_s > 0.0 ? bytes / time_s / 1e9 : 0.0;
+    state.counters[kCounterMemThreads] = num_threads;
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.SetLabel(a.pages);
+    memory_kernels::release(&a);
+    memory_kernels::release(&b);
+    memory_kernels::release(&c);
+}
+
+void registerMemorySuite() {
+    const std::vector<CacheLevel> caches = g_monitor->getCPUInfo().caches;
+    const int64_t last_cache = caches.empty() ? (8 << 20) : caches.back().size_bytes;
+    
+    // Pointer chase: 4 KiB .. 4x la última caché (mínimo 64 MiB), con dos
+    // puntos por octava (2^k y 1.5 * 2^k)
+    const int64_t chase_max = std::min<int64_t>(std::max<int64_t>(4 * last_cache, 64 << 20),
+                                                int64_t(1) << 30);
+    std::vector<int64_t> chase_sizes;
+    for (int64_t size = 4 << 10; size <= chase_max; size *= 2) {
+        chase_sizes.push_back(size);
+        if (size + size / 2 <= chase_max) chase_sizes.push_back(size + size / 2);
+    }
+    const struct { memory_kernels::PageKind kind; const char* name; } kPages[] = {
+        {memory_kernels::kPages4K, "4K"}, {memory_kernels::kPagesHuge, "huge"}};
+    for (size_t k = 0; k < 2; k++) {
+        benchmark::internal::Benchmark* b = benchmark::RegisterBenchmark(
+            (std::string("BM_PointerChase<") + kPages[k].name + ">").c_str(),
+            BM_PointerChase, kPages[k].kind);
+        for (size_t i = 0; i < chase_sizes.size(); i++) b->Arg(chase_sizes[i]);
+        b->Unit(benchmark::kMicrosecond);
+    }
+    
+    // STREAM: arrays de 4x la última caché (entre 64 y 512 MiB), de 1 hilo
+    // a todos los de la máquina
+    const int64_t array_bytes = std::min<int64_t>(std::max<int64_t>(4 * last_cache, 64 << 20),
+                                                  512 << 20) / (2 << 20) * (2 << 20);
+    const int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    const memory_kernels::StreamKernel kKernels[] = {
+        memory_kernels::kCopy, memory_kernels::kScale, memory_kernels::kAdd,
+        memory_kernels::kTriad};
+    for (size_t i = 0; i < 4; i++) {
+        for (int nt = 0; nt <= 1; nt++) {
+            for (size_t k = 0; k < 2; k++) {
+                std::string name = std::string("BM_Stream") +
+                                   memory_kernels::streamKernelName(kKernels[i]) +
+                                   (nt ? "NT" : "") + "<" + kPages[k].name + ">";
+                benchmark::internal::Benchmark* b = benchmark::RegisterBenchmark(
+                    name.c_str(), BM_Stream, kKernels[i], kPages[k].kind, nt == 1);
+                for (int t = 1; ; t *= 2) {
+                    const int threads = std::min(t, max_threads);
+                    b->Args({array_bytes, threads});
+                    if (threads == max_threads) break;
+                }
+                // Los hilos de trabajo no cuentan en el tiempo de CPU del
+                // hilo del benchmark
+                b->UseRealTime()->Unit(benchmark::kMillisecond);
+            }
         }
-        delete monitor_;
     }
+}
+
+// ============================================================
+// Custom Reporter para CSV con métricas del sistema
+// ============================================================
+class SystemMetricsReporter : public benchmark::BenchmarkReporter {
+public:
+    // Comparte g_monitor: los ficheros del sistema se descubren y abren una
+    // sola vez
+    SystemMetricsReporter()
+        : monitor_(g_monitor),
+          csv_writer_(kResultsFile, kResultsSchemaVersion, resultColumns()),
+          power_writer_(kPowerSeriesFile, kSeriesSchemaVersion, powerSeriesColumns()),
+          latency_writer_(kLatencyCurveFile, kSeriesSchemaVersion, latencyCurveColumns()),
+          bandwidth_writer_(kBandwidthCurveFile, kSeriesSchemaVersion,
+                            bandwidthCurveColumns()) {}
     
     bool ReportContext(const Context& context) override {
         std::cout << "\n" << std::string(80, '=') << std::endl;
@@ -200,11 +839,40 @@ public:
         std::cout << "   Governor: " << cpu_info.governor << std::endl;
         
         if (monitor_->isRAPLAvailable()) {
-            std::cout << "   ✅ RAPL disponible" << std::endl;
+            std::cout << "   ✅ RAPL disponible:";
+            const std::vector<RAPLDomain>& domains = monitor_->getRAPLDomains();
+            for (size_t i = 0; i < domains.size(); i++) {
+                std::cout << " " << domains[i].name;
+            }
+            std::cout << std::endl;
         } else {
             std::cout << "   ⚠️  RAPL no disponible" << std::endl;
         }
         
+        std::cout << "   Zonas térmicas: " << monitor_->getThermalZones().size() << std::endl;
+        
+        // Los contadores de perf se abren en el hilo que ejecuta los
+        // benchmarks
+        if (monitor_->isPerfAvailable()) {
+            std::cout << "   ✅ perf_event disponible" << std::endl;
+        } else {
+            std::cout << "   ⚠️  perf_event no disponible" << std::endl;
+        }
+        
+        std::cout << "   ISA SIMD: " << simd_kernels::supportedISAs() << std::endl;
+        
+        const std::vector<CacheLevel>& caches = cpu_info.caches;
+        std::cout << "   Cachés:";
+        for (size_t i = 0; i < caches.size(); i++) {
+            std::cout << " L" << caches[i].level << " " << (caches[i].size_bytes >> 10) << " KiB"
+                      << " (x" << caches[i].num_sharing << " CPUs)";
+        }
+        std::cout << std::endl;
+        const gemm_kernels::BlockSizes blocks = gemmBlockSizes(1);
+        std::cout << "   Bloques GEMM: mc=" << blocks.mc << " kc=" << blocks.kc
+                  << " nc=" << blocks.nc
+                  << ", pico " << peakGFLOPS(bestISA(), 1) << " GFLOP/s por núcleo" << std::endl;
+        
         std::cout << "\n🚀 Ejecutando benchmarks...\n" << std::endl;
         
         return true;
@@ -233,53 +901,157 @@ public:
             // CPU info
             result.cpu_info = monitor_->getCPUInfo();
             
-            // Tiempo
-            result.time_s = run.GetAdjustedRealTime() / 1e9;  // ns a s
+            // Tiempo de pared de la región medida completa (todas las
+            // iteraciones), no el tiempo por iteración
+            result.time_s = getCounter(run, kCounterTime);
+            result.iterations = run.iterations;
             
-            // Energía
-            uint64_t energy_end = monitor_->readRAPLEnergy();
-            result.energy.energy_uj = energy_end - g_energy_start;
-            result.energy.energy_j = result.energy.energy_uj / 1e6;
+            // Elementos de la región: items_per_second es una tasa sobre el
+            // tiempo de CPU, o el real con UseRealTime/UseManualTime
+            const double rate_seconds = run.run_name.time_type.empty()
+                ? run.cpu_accumulated_time : run.real_accumulated_time;
+            result.items = getCounter(run, "items_per_second") * rate_seconds;
+            
+            // Energía de la misma región
+            result.energy.energy_j = getCounter(run, kCounterEnergy);
+            result.energy.energy_uj = static_cast<uint64_t>(result.energy.energy_j * 1e6);
             result.energy.power_avg_w = SystemMonitor::calculatePowerAvg(
                 result.energy.energy_j, result.time_s);
+            result.energy.power_peak_w = getCounter(run, kCounterPowerPeak);
+            result.energy.energy_per_iter_j = run.iterations > 0
+                ? result.energy.energy_j / run.iterations : 0.0;
             
-            // Temperatura
-            result.temperature_c = monitor_->getTemperature();
+            // Temperatura y frecuencia medias durante la región
+            result.temperature_c = getCounter(run, kCounterTemperature);
+            if (getCounter(run, kCounterFreq) > 0.0) {
+                result.cpu_info.freq_mhz = getCounter(run, kCounterFreq);
+            }
             
             // EDP
             result.edp = SystemMonitor::calculateEDP(
                 result.energy.energy_j, result.time_s);
             
-            // Perf metrics (se llenarán desde el wrapper de perf)
-            // Por ahora, valores por defecto
-            result.perf.instructions = 0;
-            result.perf.cycles = 0;
-            result.perf.ipc = 0.0;
-            result.perf.cache_misses = 0;
-            result.perf.branch_misses = 0;
+            // Perf metrics, medidos en proceso durante la región medida
+            result.perf.instructions = static_cast<uint64_t>(getCounter(run, kCounterInstructions));
+            result.perf.cycles = static_cast<uint64_t>(getCounter(run, kCounterCycles));
+            result.perf.cache_misses = static_cast<uint64_t>(getCounter(run, kCounterCacheMisses));
+            result.perf.branch_misses = static_cast<uint64_t>(getCounter(run, kCounterBranchMisses));
+            result.perf.ipc = SystemMonitor::calculateIPC(
+                result.perf.instructions, result.perf.cycles);
+            
+            // Actividad de las CPUs en las que corrió (solo ejecuciones
+            // individuales; los agregados no tienen perfil)
+            result.activity = CPUActivity();  // en cero
+            PowerProfile profile;
+            const bool has_profile = run.run_type == Run::RT_Iteration &&
+                                     takePendingProfile(run, &profile);
+            if (has_profile) {
+                result.activity = profile.activity;
+            }
+            // Con varios hilos, APERF/MPERF de las CPUs del hilo medido (que
+            // casi solo espera) no dicen nada: frecuencia efectiva por perf,
+            // ciclos de todos los hilos / su tiempo en CPU. Sin MSR, igual;
+            // sin task-clock, ciclos / tiempo de la región.
+            const double task_clock_s = getCounter(run, kCounterTaskClock) * 1e-9;
+            if (getCounter(run, kCounterThreads) > 1.0) {
+                result.activity.freq_eff_mhz = task_clock_s > 0.0
+                    ? result.perf.cycles / task_clock_s / 1e6 : 0.0;
+            } else if (result.activity.freq_eff_mhz == 0.0) {
+                if (task_clock_s > 0.0) {
+                    result.activity.freq_eff_mhz = result.perf.cycles / task_clock_s / 1e6;
+                } else if (result.time_s > 0.0) {
+                    result.activity.freq_eff_mhz = result.perf.cycles / result.time_s / 1e6;
+                }
+            }
+            
+            // Contadores propios del benchmark, como columnas del CSV
+            for (benchmark::UserCounters::const_iterator it = run.counters.begin();
+                 it != run.counters.end(); ++it) {
+                if (!isMonitorCounter(it->first)) {
+                    result.counters.push_back(std::make_pair(it->first, it->second.value));
+                }
+            }
             
-            // Escribir a CSV
-            csv_writer_->writeResult(result);
+            // Encolar para el CSV (lo escribe el hilo del CSVWriter)
+            CSVWriter::Row row = resultRow(result);
+            if (!run.buffer_policy.empty()) {
+                row.push_back(std::make_pair(std::string("buffer_policy"), run.buffer_policy));
+            }
+            if (!run.report_label.empty()) {
+                row.push_back(std::make_pair(std::string("label"), run.report_label));
+            }
+            csv_writer_.writeRow(row);
+            
+            // Serie temporal de la región
+            if (has_profile) {
+                const std::vector<CSVWriter::Row> rows =
+                    powerSeriesRows(run.benchmark_name(), profile);
+                for (size_t i = 0; i < rows.size(); i++) {
+                    power_writer_.writeRow(rows[i]);
+                }
+            }
+            
+            // Curvas de la jerarquía de memoria (solo ejecuciones
+            // individuales). La etiqueta del pointer chase es "nivel/páginas".
+            if (run.run_type == Run::RT_Iteration &&
+                run.counters.find(kCounterLatency) != run.counters.end()) {
+                const size_t slash = run.report_label.find('/');
+                latency_writer_.writeRow(latencyPointRow(
+                    result.cpu_info.model_name, run.benchmark_name(),
+                    static_cast<int64_t>(getCounter(run, kCounterWorkingSet)),
+                    run.report_label.substr(0, slash),
+                    slash != std::string::npos ? run.report_label.substr(slash + 1) : "",
+                    getCounter(run, kCounterLatency)));
+            }
+            if (run.run_type == Run::RT_Iteration &&
+                run.counters.find(kCounterBandwidth) != run.counters.end()) {
+                bandwidth_writer_.writeRow(bandwidthPointRow(
+                    result.cpu_info.model_name, run.benchmark_name(),
+                    static_cast<int>(getCounter(run, kCounterMemThreads)),
+                    result.data_size, getCounter(run, kCounterBandwidth)));
+            }
             
             // Mostrar en consola
             std::cout << "  " << run.benchmark_name() 
-                      << ": " << run.GetAdjustedRealTime() / 1e6 << " ms"
-                      << ", Energy: " << result.energy.energy_j << " J"
+                      << ": " << run.GetAdjustedRealTime() << " "
+                      << benchmark::GetTimeUnitString(run.time_unit) << "/iter"
+                      << ", Energy/iter: " << result.energy.energy_per_iter_j << " J"
+                      << ", Power: " << result.energy.power_avg_w << " W"
+                      << " (pico " << result.energy.power_peak_w << " W)"
+                      << ", IPC: " << result.perf.ipc
                       << ", Temp: " << result.temperature_c << " °C"
+                      << kernelSummary(run)
+                      << (result.activity.flags.empty() ? "" : "  ⚠️  ")
+                      << result.activity.flags
                       << std::endl;
         }
+        
+        // Los perfiles que queden son de llamadas no reportadas de esta
+        // instancia
+        g_pending_profiles.clear();
     }
     
     void Finalize() override {
+        csv_writer_.close();
+        power_writer_.close();
+        latency_writer_.close();
+        bandwidth_writer_.close();
         std::cout << "\n" << std::string(80, '=') << std::endl;
         std::cout << "✅ Benchmarks completados" << std::endl;
-        std::cout << "📊 Resultados guardados en: results_cpp.csv" << std::endl;
+        std::cout << "📊 Resultados guardados en: " << kResultsFile << std::endl;
+        std::cout << "📈 Series de potencia en: " << kPowerSeriesFile << std::endl;
+        std::cout << "📉 Curvas de memoria en: " << kLatencyCurveFile << ", "
+                  << kBandwidthCurveFile << std::endl;
         std::cout << std::string(80, '=') << std::endl << std::endl;
     }
     
 private:
-    SystemMonitor* monitor_;
-    CSVWriter* csv_writer_;
+    SystemMonitor* monitor_;  // no es propietario
+    CSVWriter csv_writer_;
+    // Series y curvas, por el mismo escritor en segundo plano
+    CSVWriter power_writer_;
+    CSVWriter latency_writer_;
+    CSVWriter bandwidth_writer_;
 };
 
 // ============================================================
@@ -288,6 +1060,10 @@ private:
 int main(int argc, char** argv) {
     // Inicializar monitor global
     g_monitor = new SystemMonitor();
+    g_sampler = new PowerSampler(*g_monitor, kSampleIntervalMs);
+    
+    // Benchmarks cuyos tamaños dependen de las cachés
+    registerMemorySuite();
     
     // Verificar permisos
     if (geteuid() != 0) {
@@ -302,6 +1078,7 @@ int main(int argc, char** argv) {
     benchmark::RunSpecifiedBenchmarks(&reporter);
     
     // Cleanup
+    delete g_sampler;
     delete g_monitor;
     
     return 0;
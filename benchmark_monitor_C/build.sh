@@ -73,7 +73,7 @@ make -j$(nproc) || {
 }
 
 # Copiar el binario al directorio raíz para facilitar ejecución
-cp benchmark_monitor ../ || {
+cp benchmark_monitor analyze_results ../ || {
     echo -e "${YELLOW}⚠️  No se pudo copiar el binario${NC}"
 }
 
@@ -82,9 +82,10 @@ cd ..
 echo ""
 echo -e "${GREEN}✅ Compilación exitosa!${NC}"
 echo ""
-echo "📄 Binario generado: benchmark_monitor"
+echo "📄 Binarios generados: benchmark_monitor, analyze_results"
 echo ""
 echo "🚀 Para ejecutar:"
 echo "   ./benchmark_monitor                    # Ejecución simple"
 echo "   sudo ./run_benchmark_with_perf.sh      # Con métricas de perf"
+echo "   ./analyze_results                      # Estadísticas y regresiones"
 echo ""
@@ -0,0 +1,303 @@
+// gemm_kernels.cpp - Implementación de la familia GEMM
+#include "gemm_kernels.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GEMM_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace gemm_kernels {
+
+// ============================================================
+// Tamaños de bloque y rendimiento teórico
+// ============================================================
+
+namespace {
+
+// Filas del micro-kernel (iguales en AVX2 y AVX-512) y columnas del más ancho
+const int kMR = 6;
+const int kMaxNR = 32;
+
+// Valores típicos si no se conoce alguna caché
+const int64_t kDefaultL1 = 32 << 10;
+const int64_t kDefaultL2 = 1 << 20;
+const int64_t kDefaultL3 = 8 << 20;
+
+int clampInt(int64_t value, int lo, int hi) {
+    return static_cast<int>(std::max<int64_t>(lo, std::min<int64_t>(hi, value)));
+}
+
+} // namespace
+
+BlockSizes blockSizesFromCaches(int64_t l1_bytes, int64_t l2_bytes, int64_t l3_bytes) {
+    if (l1_bytes <= 0) l1_bytes = kDefaultL1;
+    if (l2_bytes <= 0) l2_bytes = kDefaultL2;
+    if (l3_bytes <= 0) l3_bytes = kDefaultL3;
+
+    BlockSizes blocks;
+    // Micro-panel de B (kc x NR floats) en media L1
+    blocks.kc = clampInt(l1_bytes / 2 / (kMaxNR * sizeof(float)), 64, 512) / 8 * 8;
+    // Bloque de A (mc x kc) en media L2, múltiplo de MR
+    blocks.mc = clampInt(l2_bytes / 2 / (blocks.kc * sizeof(float)), kMR, 4096) / kMR * kMR;
+    // Panel de B (kc x nc) en media L3, múltiplo de NR
+    blocks.nc = clampInt(l3_bytes / 2 / (blocks.kc * sizeof(float)), kMaxNR, 8192) / kMaxNR * kMaxNR;
+    return blocks;
+}
+
+double flopsPerCycle(simd_kernels::ISALevel isa) {
+    switch (isa) {
+        case simd_kernels::kISAAVX512: return 2 * 2 * 16;  // 2 FMA x 16 floats
+        case simd_kernels::kISAAVX2:   return 2 * 2 * 8;   // 2 FMA x 8 floats
+        case simd_kernels::kISASSE2:   return 2 * 4;       // mul + add x 4 floats
+        default:                       return 2;           // mul + add escalares
+    }
+}
+
+// ============================================================
+// Naive, ikj y por bloques
+// ============================================================
+
+void gemmNaive(const float* A, const float* B, float* C, int M, int K, int N) {
+    for (int i = 0; i < M; i++) {
+        for (int j = 0; j < N; j++) {
+            float sum = 0.0f;
+            for (int k = 0; k < K; k++) {
+                sum += A[static_cast<int64_t>(i) * K + k] * B[static_cast<int64_t>(k) * N + j];
+            }
+            C[static_cast<int64_t>(i) * N + j] = sum;
+        }
+    }
+}
+
+void gemmIKJ(const float* A, const float* B, float* C, int M, int K, int N) {
+    memset(C, 0, sizeof(float) * M * static_cast<int64_t>(N));
+    for (int i = 0; i < M; i++) {
+        float* c = C + static_cast<int64_t>(i) * N;
+        for (int k = 0; k < K; k++) {
+            const float a = A[static_cast<int64_t>(i) * K + k];
+            const float* b = B + static_cast<int64_t>(k) * N;
+            for (int j = 0; j < N; j++) {
+                c[j] += a * b[j];
+            }
+        }
+    }
+}
+
+void gemmBlocked(const float* A, const float* B, float* C, int M, int K, int N,
+                 const BlockSizes& blocks) {
+    memset(C, 0, sizeof(float) * M * static_cast<int64_t>(N));
+    for (int jc = 0; jc < N; jc += blocks.nc) {
+        const int j_end = std::min(N, jc + blocks.nc);
+        for (int pc = 0; pc < K; pc += blocks.kc) {
+            const int p_end = std::min(K, pc + blocks.kc);
+            for (int ic = 0; ic < M; ic += blocks.mc) {
+                const int i_end = std::min(M, ic + blocks.mc);
+                for (int i = ic; i < i_end; i++) {
+                    float* c = C + static_cast<int64_t>(i) * N;
+                    for (int p = pc; p < p_end; p++) {
+                        const float a = A[static_cast<int64_t>(i) * K + p];
+                        const float* b = B + static_cast<int64_t>(p) * N;
+                        for (int j = jc; j < j_end; j++) {
+                            c[j] += a * b[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// ============================================================
+// GEMM empaquetado
+// ============================================================
+
+namespace {
+
+// A(rows x depth), a partir de (i0, p0), en micro-paneles de MR filas:
+// para cada p, las MR filas seguidas. Las filas que faltan se rellenan con 0.
+void packA(const float* A, int lda, int i0, int p0, int rows, int depth, float* buf) {
+    for (int r0 = 0; r0 < rows; r0 += kMR) {
+        for (int p = 0; p < depth; p++) {
+            for (int r = 0; r < kMR; r++) {
+                *buf++ = r0 + r < rows
+                    ? A[static_cast<int64_t>(i0 + r0 + r) * lda + p0 + p] : 0.0f;
+            }
+        }
+    }
+}
+
+// B(depth x cols), a partir de (p0, j0), en micro-paneles de NR columnas:
+// para cada p, las NR columnas seguidas. Las que faltan se rellenan con 0.
+void packB(const float* B, int ldb, int p0, int j0, int depth, int cols, int nr, float* buf) {
+    for (int c0 = 0; c0 < cols; c0 += nr) {
+        const int width = std::min(nr, cols - c0);
+        for (int p = 0; p < depth; p++) {
+            const float* b = B + static_cast<int64_t>(p0 + p) * ldb + j0 + c0;
+            int c = 0;
+            for (; c < width; c++) *buf++ = b[c];
+            for (; c < nr; c++) *buf++ = 0.0f;
+        }
+    }
+}
+
+// Ejecuta el algoritmo empaquetado completo sobre C(M x N), un hilo.
+// Micro::kernel(kc, a, b, c, ldc) hace C(MR x NR) += A_panel * B_panel.
+template <class Micro>
+void packedSerial(const float* A, const float* B, float* C, int M, int K, int N,
+                  const BlockSizes& blocks) {
+    const int NR = Micro::kNR;
+    std::vector<float> a_buf(static_cast<size_t>((blocks.mc + kMR - 1) / kMR * kMR) * blocks.kc);
+    std::vector<float> b_buf(static_cast<size_t>((blocks.nc + NR - 1) / NR * NR) * blocks.kc);
+    float edge[kMR * kMaxNR];
+
+    for (int i = 0; i < M; i++) {
+        memset(C + static_cast<int64_t>(i) * N, 0, sizeof(float) * N);
+    }
+    for (int jc = 0; jc < N; jc += blocks.nc) {
+        const int nc = std::min(blocks.nc, N - jc);
+        for (int pc = 0; pc < K; pc += blocks.kc) {
+            const int kc = std::min(blocks.kc, K - pc);
+            packB(B, N, pc, jc, kc, nc, NR, b_buf.data());
+            for (int ic = 0; ic < M; ic += blocks.mc) {
+                const int mc = std::min(blocks.mc, M - ic);
+                packA(A, K, ic, pc, mc, kc, a_buf.data());
+                for (int jr = 0; jr < nc; jr += NR) {
+                    const int n_cur = std::min(NR, nc - jr);
+                    const float* b_panel = b_buf.data() + static_cast<int64_t>(jr) * kc;
+                    for (int ir = 0; ir < mc; ir += kMR) {
+                        const int m_cur = std::min(kMR, mc - ir);
+                        const float* a_panel = a_buf.data() + static_cast<int64_t>(ir) * kc;
+                        float* c = C + static_cast<int64_t>(ic + ir) * N + jc + jr;
+                        if (m_cur == kMR && n_cur == NR) {
+                            Micro::kernel(kc, a_panel, b_panel, c, N);
+                            continue;
+                        }
+                        // Borde: calcular el bloque completo aparte y sumar
+                        // solo la parte que existe
+                        memset(edge, 0, sizeof(edge));
+                        Micro::kernel(kc, a_panel, b_panel, edge, NR);
+                        for (int r = 0; r < m_cur; r++) {
+                            for (int col = 0; col < n_cur; col++) {
+                                c[static_cast<int64_t>(r) * N + col] += edge[r * NR + col];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Reparte las filas de C entre `num_threads` hilos (bloques múltiplos de MR)
+template <class Micro>
+void packedParallel(const float* A, const float* B, float* C, int M, int K, int N,
+                    const BlockSizes& blocks, int num_threads) {
+    if (num_threads < 1) num_threads = 1;
+    const int rows_per_thread = ((M + num_threads - 1) / num_threads + kMR - 1) / kMR * kMR;
+    if (num_threads == 1 || rows_per_thread >= M) {
+        packedSerial<Micro>(A, B, C, M, K, N, blocks);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (int r0 = 0; r0 < M; r0 += rows_per_thread) {
+        const int rows = std::min(rows_per_thread, M - r0);
+        threads.push_back(std::thread(packedSerial<Micro>,
+                                      A + static_cast<int64_t>(r0) * K, B,
+                                      C + static_cast<int64_t>(r0) * N, rows, K, N,
+                                      blocks));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+}
+
+#ifdef GEMM_KERNELS_X86
+
+// 6x16 con AVX2: 12 acumuladores ymm, 2 para B y 1 para la difusión de A
+struct MicroAVX2 {
+    static const int kNR = 16;
+
+    __attribute__((target("avx2,fma")))
+    static void kernel(int kc, const float* a, const float* b, float* c, int ldc) {
+        __m256 acc[kMR][2];
+        for (int r = 0; r < kMR; r++) {
+            acc[r][0] = _mm256_setzero_ps();
+            acc[r][1] = _mm256_setzero_ps();
+        }
+        for (int p = 0; p < kc; p++) {
+            const __m256 b0 = _mm256_loadu_ps(b);
+            const __m256 b1 = _mm256_loadu_ps(b + 8);
+            for (int r = 0; r < kMR; r++) {
+                const __m256 av = _mm256_broadcast_ss(a + r);
+                acc[r][0] = _mm256_fmadd_ps(av, b0, acc[r][0]);
+                acc[r][1] = _mm256_fmadd_ps(av, b1, acc[r][1]);
+            }
+            a += kMR;
+            b += kNR;
+        }
+        for (int r = 0; r < kMR; r++) {
+            float* row = c + static_cast<int64_t>(r) * ldc;
+            _mm256_storeu_ps(row, _mm256_add_ps(_mm256_loadu_ps(row), acc[r][0]));
+            _mm256_storeu_ps(row + 8, _mm256_add_ps(_mm256_loadu_ps(row + 8), acc[r][1]));
+        }
+    }
+};
+
+// 6x32 con AVX-512: 12 acumuladores zmm
+struct MicroAVX512 {
+    static const int kNR = 32;
+
+    __attribute__((target("avx512f")))
+    static void kernel(int kc, const float* a, const float* b, float* c, int ldc) {
+        __m512 acc[kMR][2];
+        for (int r = 0; r < kMR; r++) {
+            acc[r][0] = _mm512_setzero_ps();
+            acc[r][1] = _mm512_setzero_ps();
+        }
+        for (int p = 0; p < kc; p++) {
+            const __m512 b0 = _mm512_loadu_ps(b);
+            const __m512 b1 = _mm512_loadu_ps(b + 16);
+            for (int r = 0; r < kMR; r++) {
+                const __m512 av = _mm512_set1_ps(a[r]);
+                acc[r][0] = _mm512_fmadd_ps(av, b0, acc[r][0]);
+                acc[r][1] = _mm512_fmadd_ps(av, b1, acc[r][1]);
+            }
+            a += kMR;
+            b += kNR;
+        }
+        for (int r = 0; r < kMR; r++) {
+            float* row = c + static_cast<int64_t>(r) * ldc;
+            _mm512_storeu_ps(row, _mm512_add_ps(_mm512_loadu_ps(row), acc[r][0]));
+            _mm512_storeu_ps(row + 16, _mm512_add_ps(_mm512_loadu_ps(row + 16), acc[r][1]));
+        }
+    }
+};
+
+#endif  // GEMM_KERNELS_X86
+
+} // namespace
+
+void gemmPacked(simd_kernels::ISALevel isa, const float* A, const float* B, float* C,
+                int M, int K, int N, const BlockSizes& blocks, int num_threads) {
+#ifdef GEMM_KERNELS_X86
+    if (isa == simd_kernels::kISAAVX512) {
+        packedParallel<MicroAVX512>(A, B, C, M, K, N, blocks, num_threads);
+        return;
+    }
+    if (isa == simd_kernels::kISAAVX2) {
+        packedParallel<MicroAVX2>(A, B, C, M, K, N, blocks, num_threads);
+        return;
+    }
+#else
+    (void)isa;
+    (void)num_threads;
+#endif
+    // Sin micro-kernel para este nivel
+    gemmBlocked(A, B, C, M, K, N, blocks);
+}
+
+} // namespace gemm_kernels
@@ -0,0 +1,67 @@
+// gemm_kernels.h - Familia de kernels GEMM (naive, ikj, por bloques, empaquetado)
+#ifndef GEMM_KERNELS_H
+#define GEMM_KERNELS_H
+
+#include <cstdint>
+#include "simd_kernels.h"
+
+namespace gemm_kernels {
+
+// Todos calculan C(MxN) = A(MxK) * B(KxN) en float, con matrices row-major
+// densas (leading dimension = número de columnas).
+
+// ============================================================
+// Tamaños de bloque
+// ============================================================
+
+// Bloques del GEMM empaquetado (esquema de Goto/BLIS):
+//   kc: profundidad del panel; un micro-panel de B (kc x NR) cabe en L1
+//   mc: filas del bloque de A empaquetado (mc x kc), que vive en L2
+//   nc: columnas del panel de B empaquetado (kc x nc), que vive en L3
+// El GEMM por bloques sin empaquetar usa los mismos tamaños.
+struct BlockSizes {
+    int mc;
+    int kc;
+    int nc;
+};
+
+// Tamaños a partir de las cachés de datos (bytes; 0 = desconocida, se usan
+// valores típicos). Cada bloque ocupa como mucho la mitad de su caché, para
+// dejar sitio a los otros operandos. `l3_bytes` es la parte de L3 de un
+// hilo (tamaño / CPUs que la comparten) cuando se ejecuta en paralelo.
+BlockSizes blockSizesFromCaches(int64_t l1_bytes, int64_t l2_bytes, int64_t l3_bytes);
+
+// ============================================================
+// Rendimiento teórico
+// ============================================================
+
+// FLOP de float por ciclo y núcleo con el nivel `isa`, suponiendo dos
+// unidades FMA (Haswell y posteriores, Zen 2+); algunas CPUs con AVX-512
+// tienen una sola unidad de 512 bits y alcanzan la mitad.
+double flopsPerCycle(simd_kernels::ISALevel isa);
+
+// ============================================================
+// Kernels
+// ============================================================
+
+// Triple bucle i-j-k: B se recorre por columnas (acceso con salto N)
+void gemmNaive(const float* A, const float* B, float* C, int M, int K, int N);
+
+// Bucles intercambiados i-k-j: B y C se recorren por filas y el compilador
+// vectoriza el bucle interno
+void gemmIKJ(const float* A, const float* B, float* C, int M, int K, int N);
+
+// i-k-j por bloques de mc x kc x nc, sin empaquetar
+void gemmBlocked(const float* A, const float* B, float* C, int M, int K, int N,
+                 const BlockSizes& blocks);
+
+// Paneles empaquetados con micro-kernel de registros (AVX2: 6x16,
+// AVX-512: 6x32). `isa` debe ser kISAAVX2 o kISAAVX512 y estar soportado.
+// Con `num_threads` > 1 las filas de C se reparten entre hilos, cada uno con
+// sus propios paneles.
+void gemmPacked(simd_kernels::ISALevel isa, const float* A, const float* B, float* C,
+                int M, int K, int N, const BlockSizes& blocks, int num_threads = 1);
+
+} // namespace gemm_kernels
+
+#endif // GEMM_KERNELS_H
@@ -0,0 +1,243 @@
+// memory_kernels.cpp - Implementación de los kernels de memoria
+#include "memory_kernels.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MEMORY_KERNELS_X86 1
+#include <emmintrin.h>
+#endif
+
+namespace memory_kernels {
+
+// ============================================================
+// Buffers
+// ============================================================
+
+namespace {
+
+const size_t kHugePageSize = 2 << 20;
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+bool allocate(size_t bytes, PageKind kind, Buffer* buffer) {
+    buffer->data = nullptr;
+    buffer->bytes = 0;
+    buffer->pages.clear();
+
+    void* data = MAP_FAILED;
+    size_t mapped = bytes;
+    if (kind == kPagesHuge) {
+        // Páginas reservadas en /proc/sys/vm/nr_hugepages
+        mapped = roundUp(bytes, kHugePageSize);
+#ifdef MAP_HUGETLB
+        data = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (data != MAP_FAILED) buffer->pages = "hugetlb";
+#endif
+        if (data == MAP_FAILED) {
+            data = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (data == MAP_FAILED) return false;
+            madvise(data, mapped, MADV_HUGEPAGE);
+            buffer->pages = "THP";
+        }
+    } else {
+        data = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED) return false;
+        madvise(data, mapped, MADV_NOHUGEPAGE);
+        buffer->pages = "4K";
+    }
+
+    buffer->data = data;
+    buffer->bytes = mapped;
+    return true;
+}
+
+void release(Buffer* buffer) {
+    if (buffer->data) munmap(buffer->data, buffer->bytes);
+    buffer->data = nullptr;
+    buffer->bytes = 0;
+}
+
+// ============================================================
+// STREAM
+// ============================================================
+
+const char* streamKernelName(StreamKernel kernel) {
+    switch (kernel) {
+        case kCopy:  return "Copy";
+        case kScale: return "Scale";
+        case kAdd:   return "Add";
+        case kTriad: return "Triad";
+    }
+    return "";
+}
+
+int streamBytesPerElement(StreamKernel kernel) {
+    return (kernel == kCopy || kernel == kScale) ? 16 : 24;
+}
+
+namespace {
+
+// Kernels con stores normales; el compilador los vectoriza
+void streamTemporal(StreamKernel kernel, double* a, double* b, double* c, double s,
+                    int64_t begin, int64_t end) {
+    switch (kernel) {
+        case kCopy:
+            for (int64_t i = begin; i < end; i++) c[i] = a[i];
+            break;
+        case kScale:
+            for (int64_t i = begin; i < end; i++) b[i] = s * c[i];
+            break;
+        case kAdd:
+            for (int64_t i = begin; i < end; i++) c[i] = a[i] + b[i];
+            break;
+        case kTriad:
+            for (int64_t i = begin; i < end; i++) a[i] = b[i] + s * c[i];
+            break;
+    }
+}
+
+#ifdef MEMORY_KERNELS_X86
+
+// Kernels con stores no temporales de SSE2 (base de x86-64). Los extremos
+// no alineados a 16 bytes se hacen con stores normales.
+void streamNonTemporal(StreamKernel kernel, double* a, double* b, double* c, double s,
+                       int64_t begin, int64_t end) {
+    double* dst = kernel == kCopy || kernel == kAdd ? c : (kernel == kScale ? b : a);
+    int64_t head = begin;
+    while (head < end && (reinterpret_cast<uintptr_t>(dst + head) & 15) != 0) head++;
+    const int64_t tail = head + (end - head) / 2 * 2;
+    streamTemporal(kernel, a, b, c, s, begin, head);
+
+    const __m128d vs = _mm_set1_pd(s);
+    switch (kernel) {
+        case kCopy:
+            for (int64_t i = head; i < tail; i += 2)
+                _mm_stream_pd(c + i, _mm_loadu_pd(a + i));
+            break;
+        case kScale:
+            for (int64_t i = head; i < tail; i += 2)
+                _mm_stream_pd(b + i, _mm_mul_pd(vs, _mm_loadu_pd(c + i)));
+            break;
+        case kAdd:
+            for (int64_t i = head; i < tail; i += 2)
+                _mm_stream_pd(c + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+            break;
+        case kTriad:
+            for (int64_t i = head; i < tail; i += 2)
+                _mm_stream_pd(a + i, _mm_add_pd(_mm_loadu_pd(b + i),
+                                                _mm_mul_pd(vs, _mm_loadu_pd(c + i))));
+            break;
+    }
+    // Los stores no temporales no están ordenados con los normales
+    _mm_sfence();
+    streamTemporal(kernel, a, b, c, s, tail, end);
+}
+
+#endif  // MEMORY_KERNELS_X86
+
+// Parte [0, n) en `num_threads` trozos contiguos, alineados a 8 elementos
+// (una línea de caché), y ejecuta fn(begin, end) en un hilo por trozo
+template <class Fn>
+void parallelChunks(int64_t n, int num_threads, Fn fn) {
+    if (num_threads <= 1) {
+        fn(static_cast<int64_t>(0), n);
+        return;
+    }
+    const int64_t chunk = ((n + num_threads - 1) / num_threads + 7) / 8 * 8;
+    std::vector<std::thread> threads;
+    for (int64_t begin = 0; begin < n; begin += chunk) {
+        threads.push_back(std::thread(fn, begin, std::min(n, begin + chunk)));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+}
+
+} // namespace
+
+void stream(StreamKernel kernel, double* a, double* b, double* c, double scalar,
+            int64_t begin, int64_t end, bool non_temporal) {
+#ifdef MEMORY_KERNELS_X86
+    if (non_temporal) {
+        streamNonTemporal(kernel, a, b, c, scalar, begin, end);
+        return;
+    }
+#else
+    (void)non_temporal;
+#endif
+    streamTemporal(kernel, a, b, c, scalar, begin, end);
+}
+
+void streamParallel(StreamKernel kernel, double* a, double* b, double* c, double scalar,
+                    int64_t n, bool non_temporal, int num_threads) {
+    parallelChunks(n, num_threads, [=](int64_t begin, int64_t end) {
+        stream(kernel, a, b, c, scalar, begin, end, non_temporal);
+    });
+}
+
+void streamInit(double* a, double* b, double* c, int64_t n, int num_threads) {
+    parallelChunks(n, num_threads, [=](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+            a[i] = 1.0;
+            b[i] = 2.0;
+            c[i] = 0.0;
+        }
+    });
+}
+
+// ============================================================
+// Pointer chase
+// ============================================================
+
+void* buildChase(void* buffer, size_t bytes, uint64_t seed) {
+    const size_t lines = bytes / kChaseStride;
+    char* base = static_cast<char*>(buffer);
+    if (lines == 0) return buffer;
+
+    // Sattolo: permutación con un único ciclo que pasa por todas las líneas
+    std::vector<uint32_t> order(lines);
+    for (size_t i = 0; i < lines; i++) order[i] = static_cast<uint32_t>(i);
+    std::mt19937_64 rng(seed);
+    for (size_t i = lines - 1; i > 0; i--) {
+        std::uniform_int_distribution<size_t> pick(0, i - 1);
+        std::swap(order[i], order[pick(rng)]);
+    }
+    for (size_t i = 0; i < lines; i++) {
+        void** node = reinterpret_cast<void**>(base + order[i] * kChaseStride);
+        *node = base + order[(i + 1) % lines] * kChaseStride;
+    }
+    return base + order[0] * kChaseStride;
+}
+
+void* chase(void* start, int64_t steps) {
+    void* p = start;
+    // Desenrollado para que el coste del bucle no se sume a la latencia
+    int64_t i = 0;
+    for (; i + 8 <= steps; i += 8) {
+        p = *static_cast<void**>(p);
+        p = *static_cast<void**>(p);
+        p = *static_cast<void**>(p);
+        p = *static_cast<void**>(p);
+        p = *static_cast<void**>(p);
+        p = *static_cast<void**>(p);
+        p = *static_cast<void**>(p);
+        p = *static_cast<void**>(p);
+    }
+    for (; i < steps; i++) {
+        p = *static_cast<void**>(p);
+    }
+    return p;
+}
+
+} // namespace memory_kernels
@@ -0,0 +1,82 @@
+// memory_kernels.h - Kernels de la jerarquía de memoria (STREAM, pointer chase)
+#ifndef MEMORY_KERNELS_H
+#define MEMORY_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace memory_kernels {
+
+// ============================================================
+// Buffers con páginas de 4 KiB o páginas grandes
+// ============================================================
+
+enum PageKind {
+    kPages4K = 0,   // MADV_NOHUGEPAGE: THP no las convierte por su cuenta
+    kPagesHuge      // MAP_HUGETLB si hay páginas reservadas, si no THP
+};
+
+struct Buffer {
+    void* data;
+    size_t bytes;
+    std::string pages;  // "4K", "hugetlb" o "THP"
+};
+
+// Reserva `bytes` con mmap (alineado a página). Las páginas se crean en el
+// primer acceso: hay que inicializar el buffer antes de medir, y en NUMA
+// desde los hilos que lo van a usar. false si mmap falla.
+bool allocate(size_t bytes, PageKind kind, Buffer* buffer);
+void release(Buffer* buffer);
+
+// ============================================================
+// STREAM (McCalpin)
+// ============================================================
+
+enum StreamKernel {
+    kCopy = 0,   // c = a
+    kScale,      // b = s * c
+    kAdd,        // c = a + b
+    kTriad       // a = b + s * c
+};
+
+const char* streamKernelName(StreamKernel kernel);
+
+// Bytes movidos por elemento según el convenio de STREAM (sin contar la
+// lectura por write-allocate de las escrituras normales): 16 o 24
+int streamBytesPerElement(StreamKernel kernel);
+
+// Ejecuta `kernel` sobre los elementos [begin, end). Con `non_temporal`
+// las escrituras usan stores no temporales (sin write-allocate ni
+// contaminar la caché); los arrays deben estar alineados a 16 bytes.
+void stream(StreamKernel kernel, double* a, double* b, double* c, double scalar,
+            int64_t begin, int64_t end, bool non_temporal);
+
+// Lo mismo repartido en `num_threads` hilos, con un trozo contiguo cada uno
+void streamParallel(StreamKernel kernel, double* a, double* b, double* c, double scalar,
+                    int64_t n, bool non_temporal, int num_threads);
+
+// Inicializa a, b y c (a = 1, b = 2, c = 0) con el mismo reparto entre
+// hilos que streamParallel, para que en NUMA cada página quede en el nodo
+// del hilo que la usa
+void streamInit(double* a, double* b, double* c, int64_t n, int num_threads);
+
+// ============================================================
+// Pointer chase
+// ============================================================
+
+// Tamaño de cada nodo: una línea de caché
+const size_t kChaseStride = 64;
+
+// Enlaza las líneas de `buffer` en un único ciclo aleatorio (algoritmo de
+// Sattolo), para que el prefetcher no pueda adivinar la siguiente dirección.
+// Devuelve el primer nodo.
+void* buildChase(void* buffer, size_t bytes, uint64_t seed);
+
+// Sigue `steps` punteros desde `start`; cada carga depende de la anterior,
+// así que el tiempo por paso es la latencia de carga. Devuelve el último.
+void* chase(void* start, int64_t steps);
+
+} // namespace memory_kernels
+
+#endif // MEMORY_KERNELS_H
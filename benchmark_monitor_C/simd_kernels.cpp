@@ -0,0 +1,362 @@
+// simd_kernels.cpp - Implementación de los kernels por nivel de ISA
+#include "simd_kernels.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_KERNELS_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+// Desactivar la auto-vectorización en los kernels escalares, para que sean
+// una referencia escalar de verdad aunque se compile con -O3 -march=native
+#if defined(__clang__)
+#define SCALAR_FUNCTION
+#define SCALAR_LOOP _Pragma("clang loop vectorize(disable) interleave(disable)")
+#elif defined(__GNUC__)
+#define SCALAR_FUNCTION __attribute__((optimize("no-tree-vectorize")))
+#define SCALAR_LOOP
+#else
+#define SCALAR_FUNCTION
+#define SCALAR_LOOP
+#endif
+
+namespace simd_kernels {
+
+// ============================================================
+// Detección de ISA (cpuid + xgetbv)
+// ============================================================
+
+#ifdef SIMD_KERNELS_X86
+
+namespace {
+
+// Estado de los registros que el SO guarda (XCR0)
+uint64_t readXCR0() {
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+
+} // namespace
+
+bool isSupported(ISALevel level) {
+    unsigned int eax, ebx, ecx, edx;
+    if (level == kISAScalar) return true;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+
+    const bool sse2 = (edx >> 26) & 1;
+    if (level == kISASSE2) return sse2;
+
+    // AVX y superiores: la CPU lo soporta y el SO guarda los registros
+    const bool osxsave = (ecx >> 27) & 1;
+    const bool avx = (ecx >> 28) & 1;
+    const bool fma = (ecx >> 12) & 1;
+    if (!osxsave || !avx) return false;
+    const uint64_t xcr0 = readXCR0();
+    const bool ymm_state = (xcr0 & 0x6) == 0x6;           // SSE + AVX
+    const bool zmm_state = (xcr0 & 0xE6) == 0xE6;         // + opmask, ZMM
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+    const bool avx2 = (ebx >> 5) & 1;
+    const bool avx512f = (ebx >> 16) & 1;
+
+    if (level == kISAAVX2) return avx2 && fma && ymm_state;
+    if (level == kISAAVX512) return avx512f && zmm_state;
+    return false;
+}
+
+#else  // SIMD_KERNELS_X86
+
+bool isSupported(ISALevel level) {
+    return level == kISAScalar;
+}
+
+#endif  // SIMD_KERNELS_X86
+
+std::string supportedISAs() {
+    std::string result = Scalar::name();
+    if (isSupported(kISASSE2)) result += std::string(" ") + SSE2::name();
+    if (isSupported(kISAAVX2)) result += std::string(" ") + AVX2::name();
+    if (isSupported(kISAAVX512)) result += std::string(" ") + AVX512::name();
+    return result;
+}
+
+// ============================================================
+// Escalar
+// ============================================================
+
+SCALAR_FUNCTION
+void Scalar::vectorAdd(const double* a, const double* b, double* c, int64_t n) {
+    SCALAR_LOOP
+    for (int64_t i = 0; i < n; i++) {
+        c[i] = a[i] + b[i];
+    }
+}
+
+SCALAR_FUNCTION
+double Scalar::dotProduct(const double* a, const double* b, int64_t n) {
+    double sum = 0.0;
+    SCALAR_LOOP
+    for (int64_t i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+SCALAR_FUNCTION
+void Scalar::copy(const char* src, char* dst, int64_t n) {
+    // De 8 en 8 bytes (lo más ancho sin registros vectoriales)
+    int64_t i = 0;
+    SCALAR_LOOP
+    for (; i + 8 <= n; i += 8) {
+        uint64_t word;
+        memcpy(&word, src + i, sizeof(word));
+        memcpy(dst + i, &word, sizeof(word));
+    }
+    for (; i < n; i++) {
+        dst[i] = src[i];
+    }
+}
+
+SCALAR_FUNCTION
+void Scalar::matMul(const float* A, const float* B, float* C, int M, int K, int N) {
+    for (int i = 0; i < M; i++) {
+        float* c = C + static_cast<int64_t>(i) * N;
+        for (int j = 0; j < N; j++) c[j] = 0.0f;
+        for (int k = 0; k < K; k++) {
+            const float a = A[static_cast<int64_t>(i) * K + k];
+            const float* b = B + static_cast<int64_t>(k) * N;
+            SCALAR_LOOP
+            for (int j = 0; j < N; j++) {
+                c[j] += a * b[j];
+            }
+        }
+    }
+}
+
+#ifdef SIMD_KERNELS_X86
+
+// ============================================================
+// SSE2 (128 bits: 2 doubles, 4 floats)
+// ============================================================
+
+__attribute__((target("sse2")))
+void SSE2::vectorAdd(const double* a, const double* b, double* c, int64_t n) {
+    int64_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(c + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    }
+    for (; i < n; i++) c[i] = a[i] + b[i];
+}
+
+__attribute__((target("sse2")))
+double SSE2::dotProduct(const double* a, const double* b, int64_t n) {
+    // Cuatro acumuladores para ocultar la latencia de la suma
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    __m128d acc2 = _mm_setzero_pd(), acc3 = _mm_setzero_pd();
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+        acc2 = _mm_add_pd(acc2, _mm_mul_pd(_mm_loadu_pd(a + i + 4), _mm_loadu_pd(b + i + 4)));
+        acc3 = _mm_add_pd(acc3, _mm_mul_pd(_mm_loadu_pd(a + i + 6), _mm_loadu_pd(b + i + 6)));
+    }
+    __m128d acc = _mm_add_pd(_mm_add_pd(acc0, acc1), _mm_add_pd(acc2, acc3));
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    double sum = lanes[0] + lanes[1];
+    for (; i < n; i++) sum += a[i] * b[i];
+    return sum;
+}
+
+__attribute__((target("sse2")))
+void SSE2::copy(const char* src, char* dst, int64_t n) {
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+    }
+    for (; i < n; i++) dst[i] = src[i];
+}
+
+__attribute__((target("sse2")))
+void SSE2::matMul(const float* A, const float* B, float* C, int M, int K, int N) {
+    for (int i = 0; i < M; i++) {
+        float* c = C + static_cast<int64_t>(i) * N;
+        for (int j = 0; j < N; j++) c[j] = 0.0f;
+        for (int k = 0; k < K; k++) {
+            const float a_scalar = A[static_cast<int64_t>(i) * K + k];
+            const __m128 a = _mm_set1_ps(a_scalar);
+            const float* b = B + static_cast<int64_t>(k) * N;
+            int j = 0;
+            for (; j + 4 <= N; j += 4) {
+                _mm_storeu_ps(c + j, _mm_add_ps(_mm_loadu_ps(c + j),
+                                                _mm_mul_ps(a, _mm_loadu_ps(b + j))));
+            }
+            for (; j < N; j++) c[j] += a_scalar * b[j];
+        }
+    }
+}
+
+// ============================================================
+// AVX2 + FMA (256 bits: 4 doubles, 8 floats)
+// ============================================================
+
+__attribute__((target("avx2,fma")))
+void AVX2::vectorAdd(const double* a, const double* b, double* c, int64_t n) {
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(c + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    for (; i < n; i++) c[i] = a[i] + b[i];
+}
+
+__attribute__((target("avx2,fma")))
+double AVX2::dotProduct(const double* a, const double* b, int64_t n) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+        acc2 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 8), _mm256_loadu_pd(b + i + 8), acc2);
+        acc3 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12), acc3);
+    }
+    __m256d acc = _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    double sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; i++) sum += a[i] * b[i];
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+void AVX2::copy(const char* src, char* dst, int64_t n) {
+    int64_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+    }
+    for (; i < n; i++) dst[i] = src[i];
+}
+
+__attribute__((target("avx2,fma")))
+void AVX2::matMul(const float* A, const float* B, float* C, int M, int K, int N) {
+    for (int i = 0; i < M; i++) {
+        float* c = C + static_cast<int64_t>(i) * N;
+        for (int j = 0; j < N; j++) c[j] = 0.0f;
+        for (int k = 0; k < K; k++) {
+            const float a_scalar = A[static_cast<int64_t>(i) * K + k];
+            const __m256 a = _mm256_set1_ps(a_scalar);
+            const float* b = B + static_cast<int64_t>(k) * N;
+            int j = 0;
+            for (; j + 8 <= N; j += 8) {
+                _mm256_storeu_ps(c + j, _mm256_fmadd_ps(a, _mm256_loadu_ps(b + j),
+                                                        _mm256_loadu_ps(c + j)));
+            }
+            for (; j < N; j++) c[j] += a_scalar * b[j];
+        }
+    }
+}
+
+// ============================================================
+// AVX-512F (512 bits: 8 doubles, 16 floats)
+// ============================================================
+
+__attribute__((target("avx512f")))
+void AVX512::vectorAdd(const double* a, const double* b, double* c, int64_t n) {
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(c + i, _mm512_add_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i)));
+    }
+    // Cola con máscara en lugar de bucle escalar
+    if (i < n) {
+        const __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+        _mm512_mask_storeu_pd(c + i, mask, _mm512_add_pd(_mm512_maskz_loadu_pd(mask, a + i),
+                                                         _mm512_maskz_loadu_pd(mask, b + i)));
+    }
+}
+
+__attribute__((target("avx512f")))
+double AVX512::dotProduct(const double* a, const double* b, int64_t n) {
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    __m512d acc2 = _mm512_setzero_pd(), acc3 = _mm512_setzero_pd();
+    int64_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+        acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), acc1);
+        acc2 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 16), _mm512_loadu_pd(b + i + 16), acc2);
+        acc3 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 24), _mm512_loadu_pd(b + i + 24), acc3);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+    }
+    if (i < n) {
+        const __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+        acc1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a + i),
+                               _mm512_maskz_loadu_pd(mask, b + i), acc1);
+    }
+    __m512d acc = _mm512_add_pd(_mm512_add_pd(acc0, acc1), _mm512_add_pd(acc2, acc3));
+    double lanes[8];
+    _mm512_storeu_pd(lanes, acc);
+    double sum = 0.0;
+    for (int l = 0; l < 8; l++) sum += lanes[l];
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+void AVX512::copy(const char* src, char* dst, int64_t n) {
+    int64_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        _mm512_storeu_si512(dst + i, _mm512_loadu_si512(src + i));
+    }
+    for (; i < n; i++) dst[i] = src[i];
+}
+
+__attribute__((target("avx512f")))
+void AVX512::matMul(const float* A, const float* B, float* C, int M, int K, int N) {
+    for (int i = 0; i < M; i++) {
+        float* c = C + static_cast<int64_t>(i) * N;
+        for (int j = 0; j < N; j++) c[j] = 0.0f;
+        for (int k = 0; k < K; k++) {
+            const __m512 a = _mm512_set1_ps(A[static_cast<int64_t>(i) * K + k]);
+            const float* b = B + static_cast<int64_t>(k) * N;
+            int j = 0;
+            for (; j + 16 <= N; j += 16) {
+                _mm512_storeu_ps(c + j, _mm512_fmadd_ps(a, _mm512_loadu_ps(b + j),
+                                                        _mm512_loadu_ps(c + j)));
+            }
+            if (j < N) {
+                const __mmask16 mask = static_cast<__mmask16>((1u << (N - j)) - 1);
+                _mm512_mask_storeu_ps(c + j, mask,
+                                      _mm512_fmadd_ps(a, _mm512_maskz_loadu_ps(mask, b + j),
+                                                      _mm512_maskz_loadu_ps(mask, c + j)));
+            }
+        }
+    }
+}
+
+#else  // SIMD_KERNELS_X86
+
+// Fuera de x86 solo existe el nivel escalar; isSupported() hace que estos
+// benchmarks se salten, pero las funciones tienen que existir.
+
+void SSE2::vectorAdd(const double* a, const double* b, double* c, int64_t n) { Scalar::vectorAdd(a, b, c, n); }
+double SSE2::dotProduct(const double* a, const double* b, int64_t n) { return Scalar::dotProduct(a, b, n); }
+void SSE2::copy(const char* src, char* dst, int64_t n) { Scalar::copy(src, dst, n); }
+void SSE2::matMul(const float* A, const float* B, float* C, int M, int K, int N) { Scalar::matMul(A, B, C, M, K, N); }
+
+void AVX2::vectorAdd(const double* a, const double* b, double* c, int64_t n) { Scalar::vectorAdd(a, b, c, n); }
+double AVX2::dotProduct(const double* a, const double* b, int64_t n) { return Scalar::dotProduct(a, b, n); }
+void AVX2::copy(const char* src, char* dst, int64_t n) { Scalar::copy(src, dst, n); }
+void AVX2::matMul(const float* A, const float* B, float* C, int M, int K, int N) { Scalar::matMul(A, B, C, M, K, N); }
+
+void AVX512::vectorAdd(const double* a, const double* b, double* c, int64_t n) { Scalar::vectorAdd(a, b, c, n); }
+double AVX512::dotProduct(const double* a, const double* b, int64_t n) { return Scalar::dotProduct(a, b, n); }
+void AVX512::copy(const char* src, char* dst, int64_t n) { Scalar::copy(src, dst, n); }
+void AVX512::matMul(const float* A, const float* B, float* C, int M, int K, int N) { Scalar::matMul(A, B, C, M, K, N); }
+
+#endif  // SIMD_KERNELS_X86
+
+} // namespace simd_kernels
@@ -0,0 +1,64 @@
+// simd_kernels.h - Kernels vectorizados explícitamente (escalar/SSE/AVX2/AVX-512)
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstdint>
+#include <string>
+
+namespace simd_kernels {
+
+// ============================================================
+// Niveles de ISA y detección en tiempo de ejecución
+// ============================================================
+
+enum ISALevel {
+    kISAScalar = 0,
+    kISASSE2,
+    kISAAVX2,     // AVX2 + FMA
+    kISAAVX512    // AVX-512F
+};
+
+// true si la CPU (cpuid) y el sistema operativo (xgetbv: registros
+// guardados en los cambios de contexto) soportan `level`
+bool isSupported(ISALevel level);
+
+// Niveles soportados, p. ej. "Scalar SSE2 AVX2"
+std::string supportedISAs();
+
+// ============================================================
+// Kernels, uno por nivel de ISA
+// ============================================================
+//
+// Cada struct implementa los mismos kernels con intrinsics de su nivel (el
+// escalar con la auto-vectorización desactivada). Los benchmarks son
+// plantillas sobre estos structs, de modo que cada ISA es una instancia
+// distinta. Las funciones se compilan con el atributo `target` de su nivel:
+// el binario funciona en cualquier x86-64 y el benchmark se salta si la CPU
+// no soporta el nivel.
+
+#define SIMD_KERNELS_DECLARE(ISA_NAME, ISA_LEVEL, DISPLAY_NAME)                  \
+    struct ISA_NAME {                                                            \
+        static const ISALevel kLevel = ISA_LEVEL;                                \
+        static const char* name() { return DISPLAY_NAME; }                       \
+        /* c[i] = a[i] + b[i] */                                                 \
+        static void vectorAdd(const double* a, const double* b, double* c,      \
+                              int64_t n);                                        \
+        /* Σ a[i] * b[i] */                                                      \
+        static double dotProduct(const double* a, const double* b, int64_t n);  \
+        /* dst[i] = src[i], con cargas y escrituras vectoriales */              \
+        static void copy(const char* src, char* dst, int64_t n);                 \
+        /* C(MxN) = A(MxK) * B(KxN), orden ikj */                                \
+        static void matMul(const float* A, const float* B, float* C, int M,      \
+                           int K, int N);                                        \
+    };
+
+SIMD_KERNELS_DECLARE(Scalar, kISAScalar, "Scalar")
+SIMD_KERNELS_DECLARE(SSE2, kISASSE2, "SSE2")
+SIMD_KERNELS_DECLARE(AVX2, kISAAVX2, "AVX2")
+SIMD_KERNELS_DECLARE(AVX512, kISAAVX512, "AVX-512")
+
+#undef SIMD_KERNELS_DECLARE
+
+} // namespace simd_kernels
+
+#endif // SIMD_KERNELS_H
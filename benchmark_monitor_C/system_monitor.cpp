@@ -8,29 +8,369 @@
 #include <iomanip>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <sched.h>
+#include <cstdio>
 #include <dirent.h>
 #include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 namespace system_monitor {
 
+// ============================================================
+// Helpers de lectura con descriptores abiertos
+// ============================================================
+
+namespace {
+
+// Lee un entero decimal de un fichero de sysfs ya abierto. Usa pread desde
+// el offset 0 (sysfs regenera el contenido en cada lectura) y un buffer en
+// la pila.
+bool preadUInt64(int fd, uint64_t* value) {
+    if (fd < 0) return false;
+    char buf[32];
+    const ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) return false;
+    buf[n] = '\0';
+    char* end = nullptr;
+    *value = strtoull(buf, &end, 10);
+    return end != buf;
+}
+
+int openReadOnly(const std::string& path) {
+    return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+// Entradas de un directorio (sin . ni ..), ordenadas
+std::vector<std::string> listDirectory(const std::string& path) {
+    std::vector<std::string> entries;
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return entries;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] != '.') {
+            entries.push_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+
+bool startsWith(const std::string& s, const char* prefix) {
+    return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// Tamaño de caché de sysfs: "48K", "2048K", "32M"
+int64_t parseCacheSize(const std::string& text) {
+    char* end = nullptr;
+    int64_t size = strtoll(text.c_str(), &end, 10);
+    if (end == text.c_str()) return 0;
+    switch (*end) {
+        case 'K': return size << 10;
+        case 'M': return size << 20;
+        case 'G': return size << 30;
+        default: return size;
+    }
+}
+
+// Número de CPUs de una lista de sysfs: "0-3,8-11" -> 8
+int countCPUList(const std::string& list) {
+    int count = 0;
+    const char* p = list.c_str();
+    while (*p) {
+        char* end = nullptr;
+        const long first = strtol(p, &end, 10);
+        if (end == p) break;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        count += static_cast<int>(last - first + 1);
+        if (*p == ',') p++;
+    }
+    return count;
+}
+
+} // namespace
+
 // ============================================================
 // Constructor y Destructor
 // ============================================================
 
 SystemMonitor::SystemMonitor() 
-    : rapl_path_("/sys/class/powercap/intel-rapl"),
+    : rapl_path_("/sys/class/powercap"),
       rapl_available_(false),
-      perf_available_(false) {
+      temperature_fd_(-1),
+      governor_fd_(-1),
+      num_cpus_(static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN))),
+      base_freq_mhz_(0.0),
+      proc_stat_fd_(-1),
+      perf_available_(false),
+      perf_opened_(false),
+      perf_leader_fd_(-1) {
     
-    // Verificar disponibilidad de RAPL
-    struct stat st;
-    rapl_available_ = (stat(rapl_path_.c_str(), &st) == 0);
+    // Descubrir una sola vez todo lo que se va a leer durante las mediciones
+    discoverRAPL();
+    discoverThermalZones();
+    discoverCPUFreq();
+    discoverCPUActivity();
+    discoverCaches();
+    rapl_available_ = !rapl_domains_.empty();
     
-    // Verificar disponibilidad de perf
-    perf_available_ = (system("which perf > /dev/null 2>&1") == 0);
+    // Los contadores de perf se abren al primer uso, desde el hilo que los mide
+    for (int i = 0; i < kNumPerfEvents; i++) {
+        perf_fds_[i] = -1;
+    }
+}
+
+SystemMonitor::~SystemMonitor() {
+    closePerfCounters();
+    for (size_t i = 0; i < rapl_domains_.size(); i++) {
+        ::close(rapl_domains_[i].fd);
+    }
+    for (size_t i = 0; i < thermal_zones_.size(); i++) {
+        ::close(thermal_zones_[i].fd);
+    }
+    for (size_t i = 0; i < cpufreq_fds_.size(); i++) {
+        if (cpufreq_fds_[i] >= 0) ::close(cpufreq_fds_[i]);
+    }
+    if (governor_fd_ >= 0) ::close(governor_fd_);
+    for (size_t i = 0; i < cpu_files_.size(); i++) {
+        const CPUFiles& files = cpu_files_[i];
+        if (files.msr_fd >= 0) ::close(files.msr_fd);
+        if (files.core_throttle_fd >= 0) ::close(files.core_throttle_fd);
+        if (files.package_throttle_fd >= 0) ::close(files.package_throttle_fd);
+        for (size_t k = 0; k < files.cstate_fds.size(); k++) {
+            if (files.cstate_fds[k] >= 0) ::close(files.cstate_fds[k]);
+        }
+    }
+    if (proc_stat_fd_ >= 0) ::close(proc_stat_fd_);
 }
 
-SystemMonitor::~SystemMonitor() {}
+// ============================================================
+// Descubrimiento (solo en el constructor)
+// ============================================================
+
+void SystemMonitor::discoverRAPL() {
+    // Zonas intel-rapl:<paquete> y subzonas intel-rapl:<paquete>:<n> (también
+    // en AMD). Las zonas intel-rapl-mmio duplican los paquetes y se omiten.
+    std::vector<std::string> zones = listDirectory(rapl_path_);
+    for (size_t i = 0; i < zones.size(); i++) {
+        if (!startsWith(zones[i], "intel-rapl:")) continue;
+        
+        const std::string dir = rapl_path_ + "/" + zones[i];
+        RAPLDomain domain;
+        domain.name = readSysFile(dir + "/name");
+        domain.zone = zones[i];
+        domain.max_range_uj = readSysFileUInt64(dir + "/max_energy_range_uj");
+        domain.is_package = startsWith(domain.name, "package");
+        domain.fd = openReadOnly(dir + "/energy_uj");
+        
+        uint64_t value = 0;
+        if (domain.name.empty() || !preadUInt64(domain.fd, &value)) {
+            // Sin permisos (energy_uj es root-only en kernels recientes)
+            if (domain.fd >= 0) ::close(domain.fd);
+            continue;
+        }
+        rapl_domains_.push_back(domain);
+    }
+}
+
+void SystemMonitor::discoverThermalZones() {
+    std::vector<std::string> zones = listDirectory("/sys/class/thermal");
+    for (size_t i = 0; i < zones.size(); i++) {
+        if (!startsWith(zones[i], "thermal_zone")) continue;
+        
+        const std::string dir = "/sys/class/thermal/" + zones[i];
+        ThermalZone zone;
+        zone.type = readSysFile(dir + "/type");
+        zone.fd = openReadOnly(dir + "/temp");
+        if (zone.fd < 0) continue;
+        thermal_zones_.push_back(zone);
+    }
+    
+    // Sensores hwmon (coretemp, k10temp, ...) como respaldo
+    std::vector<std::string> hwmons = listDirectory("/sys/class/hwmon");
+    for (size_t i = 0; i < hwmons.size(); i++) {
+        const std::string dir = "/sys/class/hwmon/" + hwmons[i];
+        ThermalZone zone;
+        zone.type = readSysFile(dir + "/name");
+        zone.fd = openReadOnly(dir + "/temp1_input");
+        if (zone.fd < 0) continue;
+        thermal_zones_.push_back(zone);
+    }
+    
+    // getTemperature() usa la zona del paquete si existe, si no la primera
+    // que se pueda leer
+    for (size_t i = 0; i < thermal_zones_.size(); i++) {
+        const std::string& type = thermal_zones_[i].type;
+        if (type == "x86_pkg_temp" || type == "coretemp" || type == "k10temp") {
+            temperature_fd_ = thermal_zones_[i].fd;
+            break;
+        }
+    }
+    for (size_t i = 0; i < thermal_zones_.size() && temperature_fd_ < 0; i++) {
+        uint64_t value = 0;
+        if (preadUInt64(thermal_zones_[i].fd, &value)) {
+            temperature_fd_ = thermal_zones_[i].fd;
+        }
+    }
+}
+
+void SystemMonitor::discoverCPUFreq() {
+    // Un fd por CPU (-1 si esa CPU no tiene cpufreq)
+    const int num_cpus = num_cpus_ > 0 ? num_cpus_ : 1;
+    cpufreq_fds_.assign(num_cpus, -1);
+    for (int cpu = 0; cpu < num_cpus; cpu++) {
+        std::ostringstream path;
+        path << "/sys/devices/system/cpu/cpu" << cpu << "/cpufreq/scaling_cur_freq";
+        cpufreq_fds_[cpu] = openReadOnly(path.str());
+    }
+    governor_fd_ = openReadOnly("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+}
+
+void SystemMonitor::discoverCPUActivity() {
+    const std::string cpu_root = "/sys/devices/system/cpu";
+    
+    // Nombres de los C-states, de cpu0 (iguales en todas las CPUs)
+    for (int k = 0; ; k++) {
+        std::ostringstream path;
+        path << cpu_root << "/cpu0/cpuidle/state" << k << "/name";
+        std::string name = readSysFile(path.str());
+        if (name.empty()) break;
+        cstate_names_.push_back(name);
+    }
+    
+    cpu_files_.resize(cpufreq_fds_.size());
+    for (size_t cpu = 0; cpu < cpu_files_.size(); cpu++) {
+        std::ostringstream dir;
+        dir << cpu_root << "/cpu" << cpu;
+        CPUFiles& files = cpu_files_[cpu];
+        
+        std::ostringstream msr;
+        msr << "/dev/cpu/" << cpu << "/msr";
+        files.msr_fd = openReadOnly(msr.str());
+        files.core_throttle_fd = openReadOnly(dir.str() + "/thermal_throttle/core_throttle_count");
+        files.package_throttle_fd = openReadOnly(dir.str() + "/thermal_throttle/package_throttle_count");
+        for (size_t k = 0; k < cstate_names_.size(); k++) {
+            std::ostringstream path;
+            path << dir.str() << "/cpuidle/state" << k << "/time";
+            files.cstate_fds.push_back(openReadOnly(path.str()));
+        }
+    }
+    
+    // Nombre del modelo, para identificar la máquina en los resultados
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (!startsWith(line, "model name")) continue;
+        const size_t colon = line.find(':');
+        const size_t start = colon != std::string::npos
+            ? line.find_first_not_of(' ', colon + 1) : std::string::npos;
+        if (start != std::string::npos) model_name_ = line.substr(start);
+        break;
+    }
+    
+    // Frecuencia base, a la que cuenta MPERF: base_frequency (intel_pstate)
+    // o la del nombre del modelo ("... @ 2.40GHz")
+    base_freq_mhz_ = readSysFileUInt64(cpu_root + "/cpu0/cpufreq/base_frequency") / 1000.0;
+    const size_t at = model_name_.rfind('@');
+    if (base_freq_mhz_ == 0.0 && at != std::string::npos) {
+        base_freq_mhz_ = strtod(model_name_.c_str() + at + 1, nullptr) * 1000.0;
+    }
+    
+    proc_stat_fd_ = openReadOnly("/proc/stat");
+    proc_stat_buf_.resize(1 << 16);
+}
+
+void SystemMonitor::discoverCaches() {
+    // Cachés de datos y unificadas de cpu0, ordenadas por nivel (las de
+    // instrucciones no sirven para dimensionar bloques de datos)
+    const std::string dir = "/sys/devices/system/cpu/cpu0/cache";
+    std::vector<std::string> entries = listDirectory(dir);
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!startsWith(entries[i], "index")) continue;
+        const std::string index = dir + "/" + entries[i];
+        CacheLevel cache;
+        cache.level = static_cast<int>(readSysFileUInt64(index + "/level"));
+        cache.type = readSysFile(index + "/type");
+        cache.size_bytes = parseCacheSize(readSysFile(index + "/size"));
+        cache.num_sharing = countCPUList(readSysFile(index + "/shared_cpu_list"));
+        if (cache.type == "Instruction" || cache.level <= 0 || cache.size_bytes <= 0) continue;
+        caches_.push_back(cache);
+    }
+    std::stable_sort(caches_.begin(), caches_.end(),
+                     [](const CacheLevel& a, const CacheLevel& b) { return a.level < b.level; });
+}
+
+void SystemMonitor::snapshotCPUs(const std::vector<int>& cpus,
+                                 std::vector<CPUSnapshot>* snapshots) {
+    snapshots->resize(cpus.size());
+    
+    // /proc/stat entero (la línea intr puede ser muy larga); el buffer crece
+    // solo si no cabe
+    size_t length = 0;
+    if (proc_stat_fd_ >= 0) {
+        for (;;) {
+            const ssize_t n = pread(proc_stat_fd_, &proc_stat_buf_[length],
+                                    proc_stat_buf_.size() - length - 1, length);
+            if (n <= 0) break;
+            length += n;
+            if (length + 1 == proc_stat_buf_.size()) {
+                proc_stat_buf_.resize(proc_stat_buf_.size() * 2);
+            }
+        }
+    }
+    proc_stat_buf_[length] = '\0';
+    
+    for (size_t i = 0; i < cpus.size(); i++) {
+        const int cpu = cpus[i];
+        CPUSnapshot& snap = (*snapshots)[i];
+        snap.aperf = snap.mperf = 0;
+        snap.busy_ticks = snap.total_ticks = 0;
+        snap.throttle_count = 0;
+        snap.cstate_time_us.assign(cstate_names_.size(), 0);
+        if (cpu < 0 || cpu >= static_cast<int>(cpu_files_.size())) continue;
+        const CPUFiles& files = cpu_files_[cpu];
+        
+        // APERF/MPERF
+        if (files.msr_fd >= 0) {
+            if (pread(files.msr_fd, &snap.aperf, sizeof(snap.aperf), 0xE8) != sizeof(snap.aperf) ||
+                pread(files.msr_fd, &snap.mperf, sizeof(snap.mperf), 0xE7) != sizeof(snap.mperf)) {
+                snap.aperf = snap.mperf = 0;
+            }
+        }
+        
+        // "cpuN user nice system idle iowait irq softirq steal ..."
+        char key[16];
+        snprintf(key, sizeof(key), "\ncpu%d ", cpu);
+        const char* line = strstr(&proc_stat_buf_[0], key);
+        if (line) {
+            uint64_t v[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+            char* p = const_cast<char*>(line) + strlen(key);
+            for (int f = 0; f < 8; f++) {
+                v[f] = strtoull(p, &p, 10);
+            }
+            snap.busy_ticks = v[0] + v[1] + v[2] + v[5] + v[6] + v[7];
+            snap.total_ticks = snap.busy_ticks + v[3] + v[4];
+        }
+        
+        uint64_t value = 0;
+        if (preadUInt64(files.core_throttle_fd, &value)) snap.throttle_count += value;
+        if (preadUInt64(files.package_throttle_fd, &value)) snap.throttle_count += value;
+        for (size_t k = 0; k < files.cstate_fds.size(); k++) {
+            preadUInt64(files.cstate_fds[k], &snap.cstate_time_us[k]);
+        }
+    }
+}
 
 // ============================================================
 // Métodos de lectura del sistema
@@ -65,77 +405,65 @@ uint64_t SystemMonitor::readSysFileUInt64(const std::string& path) {
 CPUInfo SystemMonitor::getCPUInfo() {
     CPUInfo info;
     
-    // Frecuencia de CPU (de /proc/cpuinfo o /sys)
-    std::string freq_str = readSysFile("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq");
-    if (!freq_str.empty()) {
-        info.freq_mhz = std::stod(freq_str) / 1000.0;  // kHz a MHz
-    } else {
-        info.freq_mhz = 0.0;
-    }
+    // Frecuencia de CPU
+    info.freq_mhz = getCPUFreqMHz(0);
     
     // Governor
-    info.governor = readSysFile("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+    info.governor.clear();
+    if (governor_fd_ >= 0) {
+        char buf[64];
+        const ssize_t n = pread(governor_fd_, buf, sizeof(buf) - 1, 0);
+        if (n > 0) {
+            buf[n] = '\0';
+            buf[strcspn(buf, "\n")] = '\0';
+            info.governor = buf;
+        }
+    }
     
     // Número de threads (cores)
-    info.num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    info.num_threads = num_cpus_;
     
-    // Uso de CPU (simplificado - en producción usarías muestreo)
-    info.usage_pct = 0.0;  // Requeriría muestreo de /proc/stat
+    // Modelo y jerarquía de cachés (descubiertos en el constructor)
+    info.model_name = model_name_;
+    info.caches = caches_;
     
     return info;
 }
 
-uint64_t SystemMonitor::readRAPLEnergy() {
-    if (!rapl_available_) {
-        return 0;
-    }
-    
-    // Buscar el dominio package-0 (o el primero disponible)
-    DIR* dir = opendir(rapl_path_.c_str());
-    if (!dir) {
-        return 0;
+void SystemMonitor::readRAPLDomains(uint64_t* values_uj) {
+    for (size_t i = 0; i < rapl_domains_.size(); i++) {
+        values_uj[i] = 0;
+        preadUInt64(rapl_domains_[i].fd, &values_uj[i]);
     }
-    
+}
+
+uint64_t SystemMonitor::readRAPLEnergy() {
     uint64_t total_energy = 0;
-    struct dirent* entry;
-    
-    while ((entry = readdir(dir)) != nullptr) {
-        std::string dirname = entry->d_name;
-        
-        // Buscar intel-rapl:0 (package-0)
-        if (dirname.find("intel-rapl:0") != std::string::npos) {
-            std::string energy_path = rapl_path_ + "/" + dirname + "/energy_uj";
-            total_energy = readSysFileUInt64(energy_path);
-            break;
+    for (size_t i = 0; i < rapl_domains_.size(); i++) {
+        uint64_t value = 0;
+        if (rapl_domains_[i].is_package && preadUInt64(rapl_domains_[i].fd, &value)) {
+            total_energy += value;
         }
     }
-    
-    closedir(dir);
     return total_energy;
 }
 
+double SystemMonitor::getCPUFreqMHz(int cpu) {
+    uint64_t khz = 0;
+    if (cpu < 0 || cpu >= static_cast<int>(cpufreq_fds_.size()) ||
+        !preadUInt64(cpufreq_fds_[cpu], &khz)) {
+        return 0.0;
+    }
+    return khz / 1000.0;  // kHz a MHz
+}
+
 double SystemMonitor::getTemperature() {
-    // Intentar leer de diferentes fuentes de temperatura
-    std::vector<std::string> temp_paths = {
-        "/sys/class/thermal/thermal_zone0/temp",
-        "/sys/class/thermal/thermal_zone1/temp",
-        "/sys/class/hwmon/hwmon0/temp1_input",
-        "/sys/class/hwmon/hwmon1/temp1_input"
-    };
-    
-    for (const auto& path : temp_paths) {
-        std::string temp_str = readSysFile(path);
-        if (!temp_str.empty()) {
-            try {
-                // Temperatura suele estar en mili-grados Celsius
-                return std::stod(temp_str) / 1000.0;
-            } catch (...) {
-                continue;
-            }
-        }
+    // Temperatura en mili-grados Celsius
+    uint64_t millidegrees = 0;
+    if (!preadUInt64(temperature_fd_, &millidegrees)) {
+        return 0.0;  // No disponible
     }
-    
-    return 0.0;  // No disponible
+    return millidegrees / 1000.0;
 }
 
 bool SystemMonitor::isRAPLAvailable() {
@@ -143,9 +471,141 @@ bool SystemMonitor::isRAPLAvailable() {
 }
 
 bool SystemMonitor::isPerfAvailable() {
+    openPerfCounters();
     return perf_available_;
 }
 
+// ============================================================
+// Contadores de rendimiento (perf_event_open)
+// ============================================================
+
+namespace {
+
+// Valores leídos de un grupo con PERF_FORMAT_GROUP |
+// PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+struct PerfGroupRead {
+    uint64_t nr;
+    uint64_t time_enabled;
+    uint64_t time_running;
+    uint64_t values[5];
+};
+
+int openPerfEvent(uint32_t type, uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = (group_fd == -1) ? 1 : 0;  // El líder controla el grupo
+    attr.inherit = 1;  // También los hilos que cree el hilo medido
+    attr.exclude_kernel = 1;  // Permitido con perf_event_paranoid <= 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // pid = 0, cpu = -1: el hilo actual (y sus hijos), en cualquier CPU
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1,
+                                    group_fd, PERF_FLAG_FD_CLOEXEC));
+}
+
+} // namespace
+
+void SystemMonitor::openPerfCounters() {
+    if (perf_leader_fd_ >= 0) return;
+    if (perf_opened_ && !perf_available_) return;
+    
+    const uint32_t types[kNumPerfEvents] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+        PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE
+    };
+    const uint64_t configs[kNumPerfEvents] = {
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+        PERF_COUNT_SW_TASK_CLOCK
+    };
+    
+    // El primer evento que se abra es el líder; el resto se une a su grupo
+    // para que todos cuenten exactamente la misma región.
+    for (int i = 0; i < kNumPerfEvents; i++) {
+        perf_fds_[i] = openPerfEvent(types[i], configs[i], perf_leader_fd_);
+        if (perf_fds_[i] >= 0 && perf_leader_fd_ < 0) {
+            perf_leader_fd_ = perf_fds_[i];
+        }
+    }
+    
+    if (!perf_opened_) {
+        perf_opened_ = true;
+        perf_available_ = (perf_leader_fd_ >= 0);
+        if (!perf_available_) {
+            std::cerr << "Advertencia: contadores perf_event no disponibles ("
+                      << strerror(errno) << "). Revisa "
+                      << "/proc/sys/kernel/perf_event_paranoid" << std::endl;
+        }
+    }
+}
+
+void SystemMonitor::closePerfCounters() {
+    for (int i = 0; i < kNumPerfEvents; i++) {
+        if (perf_fds_[i] >= 0) {
+            ::close(perf_fds_[i]);
+            perf_fds_[i] = -1;
+        }
+    }
+    perf_leader_fd_ = -1;
+}
+
+void SystemMonitor::startPerfCounters() {
+    // Un grupo nuevo por región: hereda solo los hilos creados a partir de
+    // aquí, y empieza con las cuentas de los hijos a cero
+    closePerfCounters();
+    openPerfCounters();
+    if (perf_leader_fd_ < 0) return;
+    
+    ioctl(perf_leader_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(perf_leader_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+PerfMetrics SystemMonitor::stopPerfCounters() {
+    PerfMetrics metrics = {0, 0, 0, 0, 0.0, 0};
+    if (perf_leader_fd_ < 0) return metrics;
+    
+    ioctl(perf_leader_fd_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    
+    // La lectura del líder suma la de los hilos heredados, también la de
+    // los que ya terminaron
+    PerfGroupRead data;
+    memset(&data, 0, sizeof(data));
+    if (read(perf_leader_fd_, &data, sizeof(data)) <= 0) {
+        closePerfCounters();
+        return metrics;
+    }
+    
+    // Si el kernel multiplexó los contadores, escalar al tiempo habilitado
+    double scale = 1.0;
+    if (data.time_running > 0 && data.time_running < data.time_enabled) {
+        scale = static_cast<double>(data.time_enabled) / data.time_running;
+    }
+    
+    // Los valores vienen en el orden en que se unieron al grupo
+    uint64_t values[kNumPerfEvents] = {0, 0, 0, 0, 0};
+    uint64_t next = 0;
+    for (int i = 0; i < kNumPerfEvents && next < data.nr; i++) {
+        if (perf_fds_[i] >= 0) {
+            values[i] = static_cast<uint64_t>(data.values[next++] * scale);
+        }
+    }
+    closePerfCounters();
+    
+    metrics.instructions = values[kInstructions];
+    metrics.cycles = values[kCycles];
+    metrics.cache_misses = values[kCacheMisses];
+    metrics.branch_misses = values[kBranchMisses];
+    metrics.task_clock_ns = values[kTaskClock];
+    metrics.ipc = calculateIPC(metrics.instructions, metrics.cycles);
+    return metrics;
+}
+
 // ============================================================
 // Cálculo de métricas derivadas
 // ============================================================
@@ -164,12 +624,268 @@ double SystemMonitor::calculatePowerAvg(double energy_j, double time_s) {
     return energy_j / time_s;
 }
 
+uint64_t SystemMonitor::counterDelta(uint64_t start, uint64_t end, uint64_t range) {
+    if (end >= start) return end - start;
+    // El contador dio la vuelta; sin rango conocido no se puede corregir
+    if (range == 0) return 0;
+    return end + range - start;
+}
+
+// ============================================================
+// PowerSampler - Implementación
+// ============================================================
+
+const double PowerSampler::kFreqDropThreshold = 90.0;
+
+PowerSampler::PowerSampler(SystemMonitor& monitor, int interval_ms)
+    : monitor_(monitor),
+      interval_(interval_ms),
+      thread_stat_fd_(-1),
+      running_(false),
+      energy_last_uj_(monitor.getRAPLDomains().size(), 0),
+      energy_now_uj_(monitor.getRAPLDomains().size(), 0),
+      energy_accum_uj_(0) {}
+
+PowerSampler::~PowerSampler() {
+    if (thread_.joinable()) {
+        stop();
+    }
+}
+
+void PowerSampler::start() {
+    samples_.clear();
+    // Reservar de antemano para no asignar memoria mientras se muestrea
+    samples_.reserve(1024);
+    energy_accum_uj_ = 0;
+    
+    // CPUs en las que puede correr el hilo medido, y su fichero stat para
+    // saber en cuál corre en cada muestra
+    cpus_.clear();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) cpus_.push_back(cpu);
+        }
+    }
+    std::ostringstream stat_path;
+    stat_path << "/proc/self/task/" << syscall(SYS_gettid) << "/stat";
+    thread_stat_fd_ = open(stat_path.str().c_str(), O_RDONLY | O_CLOEXEC);
+    
+    monitor_.snapshotCPUs(cpus_, &cpu_start_);
+    if (!energy_last_uj_.empty()) {
+        monitor_.readRAPLDomains(&energy_last_uj_[0]);
+    }
+    start_time_ = Clock::now();
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = true;
+    }
+    thread_ = std::thread(&PowerSampler::run, this);
+}
+
+void PowerSampler::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Clock::time_point next = Clock::now() + interval_;
+    while (running_) {
+        // Despertar en el siguiente instante de muestreo, o antes si stop()
+        if (cv_.wait_until(lock, next, [this] { return !running_; })) {
+            break;
+        }
+        lock.unlock();
+        samples_.push_back(takeSample());
+        lock.lock();
+        next += interval_;
+    }
+}
+
+int PowerSampler::currentCPU() {
+    // Campo 39 (processor) de /proc/<pid>/task/<tid>/stat: la CPU en la que
+    // corrió el hilo por última vez. El nombre del hilo (campo 2) puede
+    // contener espacios, así que se cuenta desde el último ')'.
+    char buf[1024];
+    const ssize_t n = thread_stat_fd_ >= 0 ? pread(thread_stat_fd_, buf, sizeof(buf) - 1, 0) : -1;
+    if (n <= 0) return sched_getcpu();
+    buf[n] = '\0';
+    const char* p = strrchr(buf, ')');
+    if (!p) return sched_getcpu();
+    int field = 2;
+    while (*p && field < 39) {
+        if (*p++ == ' ') field++;
+    }
+    return atoi(p);
+}
+
+PowerSample PowerSampler::takeSample() {
+    // Energía de los dominios package, corrigiendo la vuelta de cada contador
+    const std::vector<RAPLDomain>& domains = monitor_.getRAPLDomains();
+    if (!domains.empty()) {
+        monitor_.readRAPLDomains(&energy_now_uj_[0]);
+    }
+    for (size_t i = 0; i < domains.size(); i++) {
+        if (domains[i].is_package) {
+            energy_accum_uj_ += SystemMonitor::counterDelta(
+                energy_last_uj_[i], energy_now_uj_[i], domains[i].max_range_uj);
+        }
+    }
+    energy_last_uj_.swap(energy_now_uj_);
+    
+    PowerSample sample;
+    sample.t_s = std::chrono::duration<double>(Clock::now() - start_time_).count();
+    sample.energy_j = energy_accum_uj_ / 1e6;
+    sample.temperature_c = monitor_.getTemperature();
+    sample.cpu = currentCPU();
+    sample.freq_mhz = monitor_.getCPUFreqMHz(sample.cpu);
+    
+    const double prev_t = samples_.empty() ? 0.0 : samples_.back().t_s;
+    const double prev_e = samples_.empty() ? 0.0 : samples_.back().energy_j;
+    sample.power_w = SystemMonitor::calculatePowerAvg(sample.energy_j - prev_e,
+                                                      sample.t_s - prev_t);
+    return sample;
+}
+
+PowerProfile PowerSampler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_one();
+    thread_.join();
+    
+    // Lectura final en el hilo que llama: cierra la ventana exacta
+    const PowerSample last = takeSample();
+    monitor_.snapshotCPUs(cpus_, &cpu_end_);
+    if (thread_stat_fd_ >= 0) {
+        ::close(thread_stat_fd_);
+        thread_stat_fd_ = -1;
+    }
+    
+    PowerProfile profile;
+    profile.time_s = last.t_s;
+    profile.energy_j = last.energy_j;
+    profile.power_avg_w = SystemMonitor::calculatePowerAvg(profile.energy_j, profile.time_s);
+    profile.power_peak_w = profile.power_avg_w;
+    profile.temperature_peak_c = last.temperature_c;
+    
+    // Promedios ponderados por el tiempo que representa cada muestra
+    double temp_sum = 0.0;
+    double freq_sum = 0.0;
+    double prev_t = 0.0;
+    samples_.push_back(last);
+    for (size_t i = 0; i < samples_.size(); i++) {
+        const PowerSample& s = samples_[i];
+        const double dt = s.t_s - prev_t;
+        temp_sum += s.temperature_c * dt;
+        freq_sum += s.freq_mhz * dt;
+        prev_t = s.t_s;
+        if (s.temperature_c > profile.temperature_peak_c) {
+            profile.temperature_peak_c = s.temperature_c;
+        }
+        // Con una sola muestra (regiones cortas) el pico es la media
+        if (samples_.size() > 1 && s.power_w > profile.power_peak_w) {
+            profile.power_peak_w = s.power_w;
+        }
+    }
+    if (profile.time_s > 0.0) {
+        profile.temperature_avg_c = temp_sum / profile.time_s;
+        profile.freq_avg_mhz = freq_sum / profile.time_s;
+    } else {
+        profile.temperature_avg_c = last.temperature_c;
+        profile.freq_avg_mhz = last.freq_mhz;
+    }
+    
+    // Actividad de las CPUs visitadas
+    std::vector<int> visited;
+    for (size_t i = 0; i < samples_.size(); i++) {
+        if (std::find(visited.begin(), visited.end(), samples_[i].cpu) == visited.end()) {
+            visited.push_back(samples_[i].cpu);
+        }
+    }
+    std::sort(visited.begin(), visited.end());
+    profile.activity = computeActivity(cpus_, cpu_start_, cpu_end_, visited,
+                                       monitor_.getCStateNames(),
+                                       monitor_.getBaseFreqMHz(), profile.time_s);
+    
+    // Caídas de frecuencia entre muestras
+    profile.activity.freq_min_mhz = 0.0;
+    profile.activity.freq_max_mhz = 0.0;
+    for (size_t i = 0; i < samples_.size(); i++) {
+        const double f = samples_[i].freq_mhz;
+        if (f <= 0.0) continue;
+        if (profile.activity.freq_min_mhz == 0.0 || f < profile.activity.freq_min_mhz) {
+            profile.activity.freq_min_mhz = f;
+        }
+        if (f > profile.activity.freq_max_mhz) {
+            profile.activity.freq_max_mhz = f;
+        }
+    }
+    if (profile.activity.freq_min_mhz > 0.0 &&
+        profile.activity.freq_min_mhz < profile.activity.freq_max_mhz * kFreqDropThreshold / 100.0) {
+        if (!profile.activity.flags.empty()) profile.activity.flags += "|";
+        profile.activity.flags += "FREQ_DROP";
+    }
+    
+    profile.samples.swap(samples_);
+    return profile;
+}
+
+CPUActivity PowerSampler::computeActivity(const std::vector<int>& cpus,
+                                          const std::vector<CPUSnapshot>& before,
+                                          const std::vector<CPUSnapshot>& after,
+                                          const std::vector<int>& visited,
+                                          const std::vector<std::string>& cstate_names,
+                                          double base_freq_mhz, double time_s) {
+    CPUActivity activity;
+    activity.cpus = visited;
+    activity.usage_pct = 0.0;
+    activity.freq_eff_mhz = 0.0;
+    activity.freq_min_mhz = 0.0;
+    activity.freq_max_mhz = 0.0;
+    activity.throttle_count = 0;
+    
+    uint64_t busy = 0, total = 0, aperf = 0, mperf = 0;
+    std::vector<uint64_t> cstate_us(cstate_names.size(), 0);
+    size_t counted = 0;
+    for (size_t i = 0; i < cpus.size() && i < before.size() && i < after.size(); i++) {
+        if (std::find(visited.begin(), visited.end(), cpus[i]) == visited.end()) continue;
+        const CPUSnapshot& b = before[i];
+        const CPUSnapshot& a = after[i];
+        counted++;
+        busy += a.busy_ticks - b.busy_ticks;
+        total += a.total_ticks - b.total_ticks;
+        aperf += a.aperf - b.aperf;
+        mperf += a.mperf - b.mperf;
+        activity.throttle_count += a.throttle_count - b.throttle_count;
+        for (size_t k = 0; k < cstate_us.size() && k < a.cstate_time_us.size(); k++) {
+            cstate_us[k] += a.cstate_time_us[k] - b.cstate_time_us[k];
+        }
+    }
+    
+    if (total > 0) {
+        activity.usage_pct = 100.0 * busy / total;
+    }
+    if (mperf > 0 && base_freq_mhz > 0.0) {
+        activity.freq_eff_mhz = base_freq_mhz * aperf / mperf;
+    }
+    if (counted > 0 && time_s > 0.0) {
+        for (size_t k = 0; k < cstate_us.size(); k++) {
+            const double pct = 100.0 * cstate_us[k] / (time_s * 1e6 * counted);
+            activity.cstate_pct.push_back(std::make_pair(cstate_names[k], pct));
+        }
+    }
+    if (activity.throttle_count > 0) {
+        activity.flags = "THROTTLE";
+    }
+    return activity;
+}
+
 // ============================================================
 // Parser de métricas de perf
 // ============================================================
 
 PerfMetrics SystemMonitor::parsePerfMetrics(const std::string& perf_output) {
-    PerfMetrics metrics = {0, 0, 0, 0, 0.0};
+    PerfMetrics metrics = {0, 0, 0, 0, 0.0, 0};
     
     std::istringstream stream(perf_output);
     std::string line;
@@ -218,76 +934,442 @@ PerfMetrics SystemMonitor::parsePerfMetrics(const std::string& perf_output) {
 // CSVWriter - Implementación
 // ============================================================
 
-CSVWriter::CSVWriter(const std::string& filename) 
-    : filename_(filename), header_written_(false), file_(nullptr) {
-    
-    // Verificar si el archivo ya existe
-    struct stat st;
-    header_written_ = (stat(filename_.c_str(), &st) == 0);
+namespace {
+
+// Filas encoladas a partir de las cuales se despierta al hilo escritor
+// antes de su periodo
+const size_t kCSVBatchRows = 256;
+const std::chrono::seconds kCSVFlushPeriod(1);
+
+// Separa una línea de CSV en campos, respetando las comillas
+std::vector<std::string> splitCSVLine(const std::string& line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        const char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                fields.back() += '"';
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                fields.back() += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(std::string());
+        } else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+std::string schemaLine(int schema_version) {
+    std::ostringstream oss;
+    oss << "# schema_version=" << schema_version;
+    return oss.str();
+}
+
+// "results_cpp.csv" -> "results_cpp.20250101-120000.csv"
+std::string rotatedName(const std::string& filename) {
+    char stamp[32];
+    const std::time_t t = std::time(nullptr);
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&t));
+    const size_t dot = filename.rfind('.');
+    if (dot == std::string::npos || filename.find('/', dot) != std::string::npos) {
+        return filename + "." + stamp;
+    }
+    return filename.substr(0, dot) + "." + stamp + filename.substr(dot);
+}
+
+std::string formatNumber(const char* format, double value) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), format, value);
+    return buf;
+}
+
+std::string formatInt(int64_t value) {
+    std::ostringstream oss;
+    oss << value;
+    return oss.str();
+}
+
+std::string formatUInt(uint64_t value) {
+    std::ostringstream oss;
+    oss << value;
+    return oss.str();
+}
+
+} // namespace
+
+CSVWriter::CSVWriter(const std::string& filename, int schema_version,
+                     const std::vector<std::string>& columns)
+    : filename_(filename),
+      schema_version_(schema_version),
+      file_(nullptr),
+      running_(false),
+      flush_requested_(false),
+      writing_(false),
+      columns_(columns),
+      columns_in_file_(0) {
+    if (!adoptExisting()) {
+        columns_ = columns;
+        columns_in_file_ = 0;
+    }
+    for (size_t i = 0; i < columns_.size(); i++) {
+        column_index_[columns_[i]] = i;
+    }
     
-    // Abrir en modo append
     file_ = fopen(filename_.c_str(), "a");
     if (!file_) {
         std::cerr << "Error: No se pudo abrir " << filename_ << std::endl;
+        return;
     }
+    running_ = true;
+    thread_ = std::thread(&CSVWriter::run, this);
 }
 
 CSVWriter::~CSVWriter() {
     close();
 }
 
-void CSVWriter::writeHeader() {
-    if (!file_ || header_written_) return;
+bool CSVWriter::adoptExisting() {
+    std::ifstream in(filename_.c_str());
+    if (!in) return false;
+    std::string version_line, header_line;
+    if (!std::getline(in, version_line)) return false;  // vacío
+    std::getline(in, header_line);
+    in.close();
     
-    fprintf(file_, "timestamp,benchmark,N,cpu_freq_MHz,cpu_governor,cpu_usage_pct,threads,");
-    fprintf(file_, "instructions,cycles,ipc,cache_misses,branch_misses,");
-    fprintf(file_, "energy_uj,energy_J,time_s,edp,power_avg_W,temperature_C\n");
+    const std::vector<std::string> existing = splitCSVLine(header_line);
+    const std::vector<std::string> base = columns_;
+    const bool compatible = version_line == schemaLine(schema_version_) &&
+                            existing.size() >= base.size() &&
+                            std::equal(base.begin(), base.end(), existing.begin());
+    if (compatible) {
+        columns_ = existing;
+        columns_in_file_ = existing.size();
+        return true;
+    }
     
-    fflush(file_);
-    header_written_ = true;
+    // Otro esquema: no mezclar filas incompatibles en el mismo fichero
+    const std::string rotated = rotatedName(filename_);
+    if (rename(filename_.c_str(), rotated.c_str()) == 0) {
+        std::cerr << "⚠️  " << filename_ << " tiene otro esquema; movido a "
+                  << rotated << std::endl;
+    } else {
+        std::cerr << "Error: No se pudo mover " << filename_ << " a " << rotated
+                  << ": " << strerror(errno) << std::endl;
+    }
+    return false;
 }
 
-void CSVWriter::writeResult(const BenchmarkResult& result) {
-    if (!file_) return;
-    
-    // Escribir encabezado si no existe
-    if (!header_written_) {
-        writeHeader();
+std::string CSVWriter::quote(const std::string& field) {
+    std::string value = field;
+    std::replace(value.begin(), value.end(), '\n', ' ');
+    std::replace(value.begin(), value.end(), '\r', ' ');
+    const bool needs_quotes = value.find_first_of(",\"") != std::string::npos ||
+                              (!value.empty() && (value[0] == ' ' || value[0] == '#' ||
+                                                  value[value.size() - 1] == ' '));
+    if (!needs_quotes) return value;
+    std::string quoted = "\"";
+    for (size_t i = 0; i < value.size(); i++) {
+        if (value[i] == '"') quoted += '"';
+        quoted += value[i];
     }
-    
-    // Construir línea completa en un buffer para evitar saltos de línea
-    char line_buffer[1024];
-    snprintf(line_buffer, sizeof(line_buffer),
-             "%s,%s,%ld,%.2f,%s,%.1f,%d,%lu,%lu,%.3f,%lu,%lu,%lu,%.6f,%.6f,%.2e,%.3f,%.1f\n",
-             result.timestamp.c_str(),
-             result.benchmark_name.c_str(),
-             result.data_size,
-             result.cpu_info.freq_mhz,
-             result.cpu_info.governor.c_str(),
-             result.cpu_info.usage_pct,
-             result.cpu_info.num_threads,
-             result.perf.instructions,
-             result.perf.cycles,
-             result.perf.ipc,
-             result.perf.cache_misses,
-             result.perf.branch_misses,
-             result.energy.energy_uj,
-             result.energy.energy_j,
-             result.time_s,
-             result.edp,
-             result.energy.power_avg_w,
-             result.temperature_c);
-    
-    // Escribir línea completa de una vez
-    fputs(line_buffer, file_);
-    fflush(file_);
+    quoted += '"';
+    return quoted;
+}
+
+void CSVWriter::writeRow(const Row& row) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) return;
+    std::vector<std::string> cells(columns_.size());
+    for (size_t i = 0; i < row.size(); i++) {
+        std::map<std::string, size_t>::const_iterator it = column_index_.find(row[i].first);
+        size_t index;
+        if (it != column_index_.end()) {
+            index = it->second;
+        } else {
+            // Columna nueva: al final
+            index = columns_.size();
+            columns_.push_back(row[i].first);
+            column_index_[row[i].first] = index;
+        }
+        if (index >= cells.size()) cells.resize(index + 1);
+        cells[index] = quote(row[i].second);
+    }
+    pending_.push_back(std::vector<std::string>());
+    pending_.back().swap(cells);
+    if (pending_.size() >= kCSVBatchRows) cv_.notify_one();
+}
+
+void CSVWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_) return;
+    flush_requested_ = true;
+    cv_.notify_one();
+    flushed_.wait(lock, [this] { return !running_ || (pending_.empty() && !writing_); });
 }
 
 void CSVWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
     if (file_) {
         fclose(file_);
         file_ = nullptr;
     }
 }
 
+void CSVWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        cv_.wait_for(lock, kCSVFlushPeriod, [this] {
+            return !running_ || flush_requested_ || pending_.size() >= kCSVBatchRows;
+        });
+        writePending(lock);
+    }
+    // Lo que quede al cerrar
+    writePending(lock);
+}
+
+// Escribe las filas encoladas sin tener el mutex durante la E/S
+void CSVWriter::writePending(std::unique_lock<std::mutex>& lock) {
+    flush_requested_ = false;
+    if (pending_.empty() && columns_in_file_ == columns_.size()) {
+        flushed_.notify_all();
+        return;
+    }
+    std::vector<std::vector<std::string> > rows;
+    rows.swap(pending_);
+    const size_t old_columns = columns_in_file_;
+    const size_t num_columns = columns_.size();
+    std::string header;
+    for (size_t i = 0; i < num_columns; i++) {
+        header += (i ? "," : "") + quote(columns_[i]);
+    }
+    columns_in_file_ = num_columns;
+    writing_ = true;
+    lock.unlock();
+    
+    bool ok = file_ != nullptr;
+    if (ok && old_columns == 0) {
+        fprintf(file_, "%s\n%s\n", schemaLine(schema_version_).c_str(), header.c_str());
+    } else if (ok && old_columns < num_columns) {
+        ok = rewriteFile(old_columns, header);
+    }
+    if (ok) {
+        std::string text;
+        for (size_t r = 0; r < rows.size(); r++) {
+            for (size_t i = 0; i < num_columns; i++) {
+                if (i) text += ',';
+                if (i < rows[r].size()) text += rows[r][i];
+            }
+            text += '\n';
+        }
+        fwrite(text.data(), 1, text.size(), file_);
+        fflush(file_);
+    }
+    
+    lock.lock();
+    writing_ = false;
+    flushed_.notify_all();
+}
+
+// Reescribe el fichero con la nueva cabecera y `new - old` campos vacíos
+// más en cada fila (las columnas nuevas siempre van al final)
+bool CSVWriter::rewriteFile(size_t old_columns, const std::string& header) {
+    fclose(file_);
+    file_ = nullptr;
+    const size_t added = splitCSVLine(header).size() - old_columns;
+    const std::string padding(added, ',');
+    const std::string tmp = filename_ + ".tmp";
+    
+    std::ifstream in(filename_.c_str());
+    std::ofstream out(tmp.c_str(), std::ios::trunc);
+    std::string line;
+    std::getline(in, line);  // versión
+    std::getline(in, line);  // cabecera antigua
+    out << schemaLine(schema_version_) << "\n" << header << "\n";
+    while (std::getline(in, line)) {
+        out << line << padding << "\n";
+    }
+    in.close();
+    out.close();
+    
+    const bool ok = out && rename(tmp.c_str(), filename_.c_str()) == 0;
+    if (!ok) {
+        std::cerr << "Error: No se pudo reescribir " << filename_ << std::endl;
+    }
+    file_ = fopen(filename_.c_str(), "a");
+    return ok && file_ != nullptr;
+}
+
+const std::vector<std::string>& resultColumns() {
+    static const char* const kNames[] = {
+        "timestamp", "benchmark", "N", "cpu_freq_MHz", "cpu_governor", "cpu_usage_pct",
+        "threads", "instructions", "cycles", "ipc", "cache_misses", "branch_misses",
+        "energy_uj", "energy_J", "time_s", "edp", "power_avg_W", "temperature_C",
+        "energy_per_iter_J", "power_peak_W", "freq_eff_MHz", "freq_min_MHz",
+        "throttle_count", "cstate_residency", "flags", "iterations", "items"
+    };
+    static const std::vector<std::string> columns(
+        kNames, kNames + sizeof(kNames) / sizeof(kNames[0]));
+    return columns;
+}
+
+CSVWriter::Row resultRow(const BenchmarkResult& result) {
+    // Residencia en C-states como "C1:2.0;C6:40.1"
+    std::string cstates;
+    for (size_t i = 0; i < result.activity.cstate_pct.size(); i++) {
+        if (i) cstates += ";";
+        cstates += result.activity.cstate_pct[i].first + ":" +
+                   formatNumber("%.1f", result.activity.cstate_pct[i].second);
+    }
+    
+    const std::string values[] = {
+        result.timestamp,
+        result.benchmark_name,
+        formatInt(result.data_size),
+        formatNumber("%.2f", result.cpu_info.freq_mhz),
+        result.cpu_info.governor,
+        formatNumber("%.1f", result.activity.usage_pct),
+        formatInt(result.cpu_info.num_threads),
+        formatUInt(result.perf.instructions),
+        formatUInt(result.perf.cycles),
+        formatNumber("%.3f", result.perf.ipc),
+        formatUInt(result.perf.cache_misses),
+        formatUInt(result.perf.branch_misses),
+        formatUInt(result.energy.energy_uj),
+        formatNumber("%.6f", result.energy.energy_j),
+        formatNumber("%.6f", result.time_s),
+        formatNumber("%.2e", result.edp),
+        formatNumber("%.3f", result.energy.power_avg_w),
+        formatNumber("%.1f", result.temperature_c),
+        formatNumber("%.3e", result.energy.energy_per_iter_j),
+        formatNumber("%.3f", result.energy.power_peak_w),
+        formatNumber("%.2f", result.activity.freq_eff_mhz),
+        formatNumber("%.2f", result.activity.freq_min_mhz),
+        formatUInt(result.activity.throttle_count),
+        cstates,
+        result.activity.flags,
+        formatInt(result.iterations),
+        formatNumber("%.6g", result.items)
+    };
+    const std::vector<std::string>& columns = resultColumns();
+    
+    CSVWriter::Row row;
+    row.reserve(columns.size() + result.counters.size());
+    for (size_t i = 0; i < columns.size(); i++) {
+        row.push_back(std::make_pair(columns[i], values[i]));
+    }
+    for (size_t i = 0; i < result.counters.size(); i++) {
+        row.push_back(std::make_pair(result.counters[i].first,
+                                     formatNumber("%.6g", result.counters[i].second)));
+    }
+    return row;
+}
+
+namespace {
+
+// Fila de pares (columna, valor) con los nombres de `columns`, en orden
+CSVWriter::Row makeRow(const std::vector<std::string>& columns,
+                       const std::string* values) {
+    CSVWriter::Row row;
+    row.reserve(columns.size());
+    for (size_t i = 0; i < columns.size(); i++) {
+        row.push_back(std::make_pair(columns[i], values[i]));
+    }
+    return row;
+}
+
+std::vector<std::string> columnList(const char* const* names, size_t count) {
+    return std::vector<std::string>(names, names + count);
+}
+
+} // namespace
+
+const std::vector<std::string>& powerSeriesColumns() {
+    static const char* const kNames[] = {
+        "benchmark", "t_s", "energy_J", "power_W", "temperature_C", "cpu_freq_MHz"
+    };
+    static const std::vector<std::string> columns =
+        columnList(kNames, sizeof(kNames) / sizeof(kNames[0]));
+    return columns;
+}
+
+std::vector<CSVWriter::Row> powerSeriesRows(const std::string& benchmark_name,
+                                            const PowerProfile& profile) {
+    std::vector<CSVWriter::Row> rows;
+    rows.reserve(profile.samples.size());
+    for (size_t i = 0; i < profile.samples.size(); i++) {
+        const PowerSample& s = profile.samples[i];
+        const std::string values[] = {
+            benchmark_name,
+            formatNumber("%.6f", s.t_s),
+            formatNumber("%.6f", s.energy_j),
+            formatNumber("%.3f", s.power_w),
+            formatNumber("%.1f", s.temperature_c),
+            formatNumber("%.2f", s.freq_mhz)
+        };
+        rows.push_back(makeRow(powerSeriesColumns(), values));
+    }
+    return rows;
+}
+
+const std::vector<std::string>& latencyCurveColumns() {
+    static const char* const kNames[] = {
+        "cpu_model", "benchmark", "working_set_bytes", "level", "pages", "latency_ns"
+    };
+    static const std::vector<std::string> columns =
+        columnList(kNames, sizeof(kNames) / sizeof(kNames[0]));
+    return columns;
+}
+
+CSVWriter::Row latencyPointRow(const std::string& cpu_model,
+                               const std::string& benchmark_name,
+                               int64_t working_set_bytes, const std::string& level,
+                               const std::string& pages, double latency_ns) {
+    const std::string values[] = {
+        cpu_model,
+        benchmark_name,
+        formatInt(working_set_bytes),
+        level,
+        pages,
+        formatNumber("%.3f", latency_ns)
+    };
+    return makeRow(latencyCurveColumns(), values);
+}
+
+const std::vector<std::string>& bandwidthCurveColumns() {
+    static const char* const kNames[] = {
+        "cpu_model", "benchmark", "threads", "array_bytes", "bandwidth_GBs"
+    };
+    static const std::vector<std::string> columns =
+        columnList(kNames, sizeof(kNames) / sizeof(kNames[0]));
+    return columns;
+}
+
+CSVWriter::Row bandwidthPointRow(const std::string& cpu_model,
+                                 const std::string& benchmark_name, int threads,
+                                 int64_t array_bytes, double bandwidth_gbs) {
+    const std::string values[] = {
+        cpu_model,
+        benchmark_name,
+        formatInt(threads),
+        formatInt(array_bytes),
+        formatNumber("%.3f", bandwidth_gbs)
+    };
+    return makeRow(bandwidthCurveColumns(), values);
+}
+
 } // namespace system_monitor
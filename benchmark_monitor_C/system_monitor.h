@@ -6,6 +6,12 @@
 #include <vector>
 #include <map>
 #include <cstdint>
+#include <cstdio>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 namespace system_monitor {
 
@@ -13,11 +19,20 @@ namespace system_monitor {
 // Estructuras de datos para métricas
 // ============================================================
 
+// Un nivel de caché de cpu0 (/sys/devices/system/cpu/cpu0/cache/index*)
+struct CacheLevel {
+    int level;               // 1, 2, 3
+    std::string type;        // Data, Instruction, Unified
+    int64_t size_bytes;
+    int num_sharing;         // CPUs que comparten esta caché
+};
+
 struct CPUInfo {
     double freq_mhz;
     std::string governor;
-    double usage_pct;
     int num_threads;
+    std::string model_name;          // "model name" de /proc/cpuinfo
+    std::vector<CacheLevel> caches;  // de datos y unificadas, por nivel
 };
 
 struct PerfMetrics {
@@ -26,12 +41,79 @@ struct PerfMetrics {
     uint64_t cache_misses;
     uint64_t branch_misses;
     double ipc;  // Instructions Per Cycle
+    // Tiempo en CPU de todos los hilos contados (el medido y los que creó
+    // durante la región), en ns
+    uint64_t task_clock_ns;
 };
 
 struct EnergyMetrics {
     uint64_t energy_uj;      // microjoules
     double energy_j;         // joules
     double power_avg_w;      // watts
+    double energy_per_iter_j;  // joules por iteración
+    double power_peak_w;       // máximo entre dos muestras consecutivas
+};
+
+// Contadores acumulados de una CPU en un instante
+struct CPUSnapshot {
+    uint64_t aperf;              // MSR 0xE8 (ciclos reales en C0)
+    uint64_t mperf;              // MSR 0xE7 (ciclos a frecuencia base en C0)
+    uint64_t busy_ticks;         // /proc/stat: user+nice+system+irq+softirq+steal
+    uint64_t total_ticks;        // /proc/stat: busy + idle + iowait
+    uint64_t throttle_count;     // thermal_throttle core + package
+    std::vector<uint64_t> cstate_time_us;  // cpuidle/state*/time
+};
+
+// Actividad de las CPUs en las que corrió el benchmark durante una región
+struct CPUActivity {
+    std::vector<int> cpus;       // CPUs visitadas por el hilo medido
+    double usage_pct;            // de /proc/stat
+    double freq_eff_mhz;         // APERF/MPERF × frecuencia base (0 sin MSR)
+    double freq_min_mhz;         // mínima muestreada de scaling_cur_freq
+    double freq_max_mhz;         // máxima muestreada de scaling_cur_freq
+    uint64_t throttle_count;     // eventos de thermal_throttle en la región
+    // Residencia en cada C-state, en % del tiempo de la región
+    std::vector<std::pair<std::string, double> > cstate_pct;
+    // THROTTLE y/o FREQ_DROP, separados por '|'; vacío si no pasó nada
+    std::string flags;
+};
+
+// Una muestra del PowerSampler
+struct PowerSample {
+    double t_s;              // segundos desde el inicio de la región medida
+    double energy_j;         // energía acumulada desde el inicio
+    double power_w;          // potencia media desde la muestra anterior
+    double temperature_c;
+    double freq_mhz;         // de la CPU en la que corre el hilo medido
+    int cpu;
+};
+
+// Resumen de una región medida por el PowerSampler
+struct PowerProfile {
+    double time_s;           // tiempo de pared exacto de la región
+    double energy_j;         // energía de la región (RAPL)
+    double power_avg_w;
+    double power_peak_w;
+    double temperature_avg_c;
+    double temperature_peak_c;
+    double freq_avg_mhz;
+    CPUActivity activity;
+    std::vector<PowerSample> samples;
+};
+
+// Un dominio de RAPL (powercap), descubierto al arrancar
+struct RAPLDomain {
+    std::string name;        // package-0, core, uncore, dram, psys
+    std::string zone;        // directorio en powercap, p. ej. intel-rapl:0:1
+    uint64_t max_range_uj;   // el contador vuelve a 0 al llegar aquí
+    bool is_package;         // los dominios package suman la energía total
+    int fd;                  // energy_uj, abierto
+};
+
+// Una zona térmica (thermal_zone* o sensor hwmon), descubierta al arrancar
+struct ThermalZone {
+    std::string type;        // x86_pkg_temp, acpitz, coretemp, ...
+    int fd;                  // temp / temp*_input, en miligrados, abierto
 };
 
 struct BenchmarkResult {
@@ -42,10 +124,17 @@ struct BenchmarkResult {
     CPUInfo cpu_info;
     PerfMetrics perf;
     EnergyMetrics energy;
+    CPUActivity activity;
     
     double time_s;
     double temperature_c;
     double edp;  // Energy Delay Product
+    int64_t iterations;  // de la región medida (time_s / iterations por iteración)
+    double items;        // elementos procesados en la región (SetItemsProcessed)
+    
+    // Contadores propios del benchmark (GFLOPS, latency_ns, ...): una
+    // columna más del CSV cada uno
+    std::vector<std::pair<std::string, double> > counters;
 };
 
 // ============================================================
@@ -60,53 +149,271 @@ public:
     // Obtener información de CPU
     CPUInfo getCPUInfo();
     
-    // Leer energía de RAPL (Intel)
+    // Dominios de RAPL descubiertos (vacío si RAPL no está disponible)
+    const std::vector<RAPLDomain>& getRAPLDomains() const { return rapl_domains_; }
+    
+    // Leer el contador de cada dominio, en el orden de getRAPLDomains(), en
+    // `values_uj` (que debe tener sitio para todos)
+    void readRAPLDomains(uint64_t* values_uj);
+    
+    // Leer energía de RAPL: suma de los contadores de los dominios package.
+    // No corrige vueltas del contador; para medir intervalos usa
+    // readRAPLDomains() con counterDelta()
     uint64_t readRAPLEnergy();
     
-    // Obtener temperatura de CPU
+    // Obtener frecuencia actual de una CPU en MHz (scaling_cur_freq)
+    double getCPUFreqMHz(int cpu = 0);
+    
+    // Frecuencia base en MHz (la de MPERF), 0 si no se conoce
+    double getBaseFreqMHz() const { return base_freq_mhz_; }
+    
+    // Nombres de los C-states de cpuidle (POLL, C1, C1E, C6, ...)
+    const std::vector<std::string>& getCStateNames() const { return cstate_names_; }
+    
+    // Tomar los contadores acumulados de las CPUs `cpus`. (*snapshots)[i]
+    // corresponde a cpus[i]; los contadores no disponibles quedan en 0.
+    void snapshotCPUs(const std::vector<int>& cpus, std::vector<CPUSnapshot>* snapshots);
+    
+    // Obtener temperatura de CPU (de la zona del paquete si existe)
     double getTemperature();
     
+    // Zonas térmicas descubiertas
+    const std::vector<ThermalZone>& getThermalZones() const { return thermal_zones_; }
+    
     // Verificar disponibilidad de características
     bool isRAPLAvailable();
     bool isPerfAvailable();
     
+    // Contadores de rendimiento en proceso (perf_event_open).
+    // Cuentan instructions, cycles, cache-misses, branch-misses y task-clock
+    // del hilo que llama a startPerfCounters() y de los hilos que este cree
+    // hasta stopPerfCounters() (los de trabajo de los benchmarks
+    // multihilo), solo en espacio de usuario. El grupo se abre en cada
+    // start y se cierra en cada stop, para no heredarlo a hilos creados
+    // fuera de la región (p. ej. el del PowerSampler); los eventos que el
+    // sistema no soporte quedan en 0.
+    void startPerfCounters();
+    PerfMetrics stopPerfCounters();
+    
     // Calcular métricas derivadas
     static double calculateIPC(uint64_t instructions, uint64_t cycles);
     static double calculateEDP(double energy_j, double time_s);
     static double calculatePowerAvg(double energy_j, double time_s);
     
+    // Incremento de un contador que cuenta módulo `range` (da como mucho
+    // una vuelta entre `start` y `end`)
+    static uint64_t counterDelta(uint64_t start, uint64_t end, uint64_t range);
+    
     // Parsear métricas de perf desde archivo
     static PerfMetrics parsePerfMetrics(const std::string& perf_output);
     
 private:
+    // Orden de los eventos en perf_fds_
+    enum PerfEvent { kInstructions = 0, kCycles, kCacheMisses, kBranchMisses,
+                     kTaskClock, kNumPerfEvents };
+    
     std::string rapl_path_;
     bool rapl_available_;
+    
+    // Descubiertos una vez en el constructor; los fds quedan abiertos y se
+    // leen con pread, sin reservar memoria
+    std::vector<RAPLDomain> rapl_domains_;
+    std::vector<ThermalZone> thermal_zones_;
+    int temperature_fd_;              // zona usada por getTemperature()
+    std::vector<int> cpufreq_fds_;    // scaling_cur_freq, índice = CPU
+    int governor_fd_;
+    int num_cpus_;
+    std::vector<CacheLevel> caches_;
+    
+    // Ficheros por CPU para snapshotCPUs(), índice = CPU
+    struct CPUFiles {
+        int msr_fd;                   // /dev/cpu/N/msr (root + módulo msr)
+        int core_throttle_fd;
+        int package_throttle_fd;
+        std::vector<int> cstate_fds;  // cpuidle/stateK/time
+    };
+    std::vector<CPUFiles> cpu_files_;
+    std::vector<std::string> cstate_names_;
+    double base_freq_mhz_;
+    std::string model_name_;
+    int proc_stat_fd_;
+    std::vector<char> proc_stat_buf_;  // reservado una vez
     bool perf_available_;
+    bool perf_opened_;                // ya se intentó abrir una vez
+    int perf_leader_fd_;
+    int perf_fds_[kNumPerfEvents];
+    
+    // Abrir el grupo de contadores si no está abierto (sin reintentar si el
+    // primer intento falló)
+    void openPerfCounters();
+    void closePerfCounters();
+    
+    // Descubrimiento de ficheros del sistema
+    void discoverRAPL();
+    void discoverThermalZones();
+    void discoverCPUFreq();
+    void discoverCPUActivity();
+    void discoverCaches();
     
     // Helper para leer archivos del sistema
     std::string readSysFile(const std::string& path);
     uint64_t readSysFileUInt64(const std::string& path);
 };
 
+// ============================================================
+// Muestreador de potencia, temperatura, frecuencia y actividad
+// ============================================================
+
+// Hilo en segundo plano que, entre start() y stop(), lee cada `interval_ms`
+// la energía de RAPL, la temperatura, la CPU en la que corre el hilo medido
+// y su scaling_cur_freq. Las lecturas de start() y stop() se hacen en el
+// hilo que llama, de modo que la energía y el tiempo cubren exactamente la
+// región medida; las muestras intermedias dan la potencia pico, la serie
+// temporal y las CPUs visitadas. Para estas CPUs se calcula además la
+// actividad (uso, frecuencia efectiva, C-states, throttling) entre start()
+// y stop().
+class PowerSampler {
+public:
+    // Se marca FREQ_DROP si la frecuencia mínima muestreada cae por debajo
+    // de este porcentaje de la máxima
+    static const double kFreqDropThreshold;
+    
+    explicit PowerSampler(SystemMonitor& monitor, int interval_ms = 10);
+    ~PowerSampler();
+    
+    void start();
+    PowerProfile stop();
+    
+    // Actividad de las CPUs `visited` entre dos snapshots de las CPUs
+    // `cpus` separados `time_s` segundos
+    static CPUActivity computeActivity(const std::vector<int>& cpus,
+                                       const std::vector<CPUSnapshot>& before,
+                                       const std::vector<CPUSnapshot>& after,
+                                       const std::vector<int>& visited,
+                                       const std::vector<std::string>& cstate_names,
+                                       double base_freq_mhz, double time_s);
+    
+private:
+    typedef std::chrono::steady_clock Clock;
+    
+    void run();
+    PowerSample takeSample();
+    
+    SystemMonitor& monitor_;
+    const std::chrono::milliseconds interval_;
+    int thread_stat_fd_;  // /proc/self/task/<tid>/stat del hilo medido
+    std::vector<int> cpus_;  // afinidad del hilo medido
+    std::vector<CPUSnapshot> cpu_start_;
+    std::vector<CPUSnapshot> cpu_end_;
+    
+    int currentCPU();
+    
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_;
+    
+    // Estado de la región actual (solo lo toca el hilo muestreador entre
+    // start() y stop())
+    Clock::time_point start_time_;
+    std::vector<uint64_t> energy_last_uj_;  // por dominio de RAPL
+    std::vector<uint64_t> energy_now_uj_;
+    uint64_t energy_accum_uj_;
+    std::vector<PowerSample> samples_;
+};
+
 // ============================================================
 // Utilidades para CSV
 // ============================================================
 
+// Escritor de CSV con búfer. writeRow() solo formatea y encola; un hilo
+// propio escribe en el fichero cada segundo (o antes si hay muchas filas),
+// así que reportar nunca bloquea al hilo del benchmark en E/S.
+//
+// El fichero empieza con "# schema_version=N" y la fila de columnas. Al
+// abrir uno existente solo se añade si la versión coincide y sus primeras
+// columnas son las de `columns`; si no, se renombra a
+// "<nombre>.<fecha>.csv" y se empieza uno nuevo. Las filas pueden traer
+// columnas nuevas (p. ej. contadores de un benchmark): se añaden al final
+// y el fichero se reescribe con las filas anteriores vacías en ellas.
 class CSVWriter {
 public:
-    CSVWriter(const std::string& filename);
+    typedef std::vector<std::pair<std::string, std::string> > Row;
+    
+    CSVWriter(const std::string& filename, int schema_version,
+              const std::vector<std::string>& columns);
     ~CSVWriter();
     
-    void writeHeader();
-    void writeResult(const BenchmarkResult& result);
+    // Encola una fila de pares (columna, valor ya formateado)
+    void writeRow(const Row& row);
+    // Espera a que todo lo encolado esté en el fichero
+    void flush();
     void close();
     
+    // Campo entre comillas si lleva comas, comillas o espacios en los
+    // extremos (RFC 4180). Los saltos de línea se cambian por espacios para
+    // que cada fila ocupe una línea.
+    static std::string quote(const std::string& field);
+    
 private:
-    std::string filename_;
-    bool header_written_;
+    bool adoptExisting();
+    void run();
+    void writePending(std::unique_lock<std::mutex>& lock);
+    bool rewriteFile(size_t old_columns, const std::string& header);
+    
+    const std::string filename_;
+    const int schema_version_;
     FILE* file_;
+    
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;       // despierta al hilo escritor
+    std::condition_variable flushed_;  // avisa a flush()
+    bool running_;
+    bool flush_requested_;
+    bool writing_;  // el hilo escritor tiene filas fuera de `pending_`
+    
+    // Protegidos por mutex_
+    std::vector<std::string> columns_;
+    std::map<std::string, size_t> column_index_;
+    size_t columns_in_file_;  // columnas de la cabecera ya escrita (0: ninguna)
+    std::vector<std::vector<std::string> > pending_;
 };
 
+// Versión del esquema de results_cpp.csv (3: iterations e items)
+const int kResultsSchemaVersion = 3;
+
+// Columnas fijas de results_cpp.csv, en orden
+const std::vector<std::string>& resultColumns();
+
+// Fila de results_cpp.csv para `result`: las columnas fijas y después
+// `result.counters`
+CSVWriter::Row resultRow(const BenchmarkResult& result);
+
+// Versión del esquema de las series y curvas de abajo
+const int kSeriesSchemaVersion = 1;
+
+// Columnas y filas de power_series_cpp.csv: una fila por muestra de
+// `profile` (benchmark,t_s,energy_J,power_W,temperature_C,cpu_freq_MHz)
+const std::vector<std::string>& powerSeriesColumns();
+std::vector<CSVWriter::Row> powerSeriesRows(const std::string& benchmark_name,
+                                            const PowerProfile& profile);
+
+// Un punto de la curva latencia / tamaño del conjunto de trabajo
+// (cpu_model,benchmark,working_set_bytes,level,pages,latency_ns)
+const std::vector<std::string>& latencyCurveColumns();
+CSVWriter::Row latencyPointRow(const std::string& cpu_model,
+                               const std::string& benchmark_name,
+                               int64_t working_set_bytes, const std::string& level,
+                               const std::string& pages, double latency_ns);
+
+// Un punto de la curva ancho de banda / hilos
+// (cpu_model,benchmark,threads,array_bytes,bandwidth_GBs)
+const std::vector<std::string>& bandwidthCurveColumns();
+CSVWriter::Row bandwidthPointRow(const std::string& cpu_model,
+                                 const std::string& benchmark_name, int threads,
+                                 int64_t array_bytes, double bandwidth_gbs);
+
 } // namespace system_monitor
 
 #endif // SYSTEM_MONITOR_H
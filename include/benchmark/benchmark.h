@@ -342,6 +342,13 @@ using IterationCount = int64_t;
 // Define alias of Setup/Teardown callback function type
 using callback_function = std::function<void(const benchmark::State&)>;
 
+// Completes an operation of State::RunAsync(). Call it exactly once, from any
+// thread.
+using AsyncDone = std::function<void()>;
+// Starts one operation of State::RunAsync(), which calls 'done' once it has
+// completed.
+using AsyncOperation = std::function<void(AsyncDone done)>;
+
 // Default number of minimum benchmark running time in seconds.
 const char kDefaultMinTimeStr[] = "0.5s";
 
@@ -677,13 +684,35 @@ class Counter {
     kIs1024 = 1024
   };
 
+  // How the values of the threads of a run are combined. kAvgThreads only
+  // applies to kSum, the other flags to every mode.
+  enum Aggregation {
+    // Added up.
+    kSum,
+    kMin,
+    kMax,
+    kMean,
+    // The value of the thread that finished last.
+    kLast,
+    // The values of the threads are kept as samples. The counter shows their
+    // mean, and "<name>_p50", "<name>_p90" and "<name>_p99" counters their
+    // percentiles. The mean and median aggregates of repetitions take the
+    // percentiles of the pooled samples.
+    kDistribution
+  };
+
   double value;
   Flags flags;
   OneK oneK;
+  Aggregation aggregation;
+  // The values combined into a kMean or kDistribution counter; empty while
+  // there is only 'value'.
+  std::vector<double> samples;
 
   BENCHMARK_ALWAYS_INLINE
-  Counter(double v = 0., Flags f = kDefaults, OneK k = kIs1000)
-      : value(v), flags(f), oneK(k) {}
+  Counter(double v = 0., Flags f = kDefaults, OneK k = kIs1000,
+          Aggregation a = kSum)
+      : value(v), flags(f), oneK(k), aggregation(a) {}
 
   BENCHMARK_ALWAYS_INLINE operator double const&() const { return value; }
   BENCHMARK_ALWAYS_INLINE operator double&() { return value; }
@@ -700,6 +729,52 @@ Counter::Flags inline operator|(const Counter::Flags& LHS,
 // This is the container for the user-defined counters.
 typedef std::map<std::string, Counter> UserCounters;
 
+// A counter name interned in the process-wide registry of counter names.
+// Interning once, e.g. at namespace scope next to the registration of the
+// benchmark, makes State::counter(id) a plain array access.
+class BENCHMARK_EXPORT CounterId {
+ public:
+  explicit CounterId(const std::string& name);
+
+  size_t index() const { return index_; }
+  const std::string& name() const;
+
+ private:
+  size_t index_;
+};
+
+// A counter of the running thread, as returned by State::counter().
+class CounterHandle {
+ public:
+  BENCHMARK_ALWAYS_INLINE CounterHandle& operator+=(double v) {
+    (*slots_)[index_].value += v;
+    return *this;
+  }
+  BENCHMARK_ALWAYS_INLINE CounterHandle& operator-=(double v) {
+    (*slots_)[index_].value -= v;
+    return *this;
+  }
+  BENCHMARK_ALWAYS_INLINE CounterHandle& operator=(double v) {
+    (*slots_)[index_].value = v;
+    return *this;
+  }
+  BENCHMARK_ALWAYS_INLINE CounterHandle& operator++() { return *this += 1; }
+
+  BENCHMARK_ALWAYS_INLINE double value() const {
+    return (*slots_)[index_].value;
+  }
+
+ private:
+  friend class State;
+  CounterHandle(std::vector<Counter>* slots, size_t index)
+      : slots_(slots), index_(index) {}
+
+  // The flat array of the thread's counters, which may grow while the
+  // handle is held.
+  std::vector<Counter>* slots_;
+  size_t index_;
+};
+
 // BigO is passed to a benchmark in order to specify the asymptotic
 // computational
 // complexity for the benchmark. In case oAuto is selected, complexity will be
@@ -729,10 +804,13 @@ struct Statistics {
       : name_(name), compute_(compute), unit_(unit) {}
 };
 
+class BenchmarkFilter;
 class BenchmarkInstance;
+class BenchmarkInstanceGenerator;
 class ThreadTimer;
 class ThreadManager;
 class PerfCountersMeasurement;
+class EnergyMeasurement;
 
 enum AggregationReportMode : unsigned {
   // The mode has not been manually specified
@@ -757,6 +835,62 @@ enum Skipped : unsigned {
 
 }  // namespace internal
 
+// How the memory returned by State::AllocateBuffer() is backed.
+struct BENCHMARK_EXPORT BufferPolicy {
+  enum PageSize {
+    // Whatever the kernel chooses for an anonymous mapping.
+    kDefaultPages,
+    // Transparent huge pages, requested with madvise(MADV_HUGEPAGE).
+    kTransparentHugePages,
+    // Reserved 2 MiB huge pages (MAP_HUGETLB); falls back to transparent
+    // huge pages if none are available.
+    kHugePages2M,
+    // Reserved 1 GiB huge pages (MAP_HUGETLB); falls back to 2 MiB pages,
+    // then to transparent huge pages.
+    kHugePages1G
+  };
+
+  PageSize pages = kDefaultPages;
+  // NUMA node the pages are bound to, or -1 to leave placement to the kernel.
+  int numa_node = -1;
+  // Alignment of the returned pointer. Must be a power of two.
+  size_t alignment = 64;
+  // Touch every page before returning, so that no page faults are taken
+  // inside the measured region.
+  bool prefault = true;
+};
+
+// The value of an argument of a benchmark instance. Arguments registered
+// with a typed axis (see Benchmark::DoubleAxis() and friends) stand for a
+// floating-point number, a string or an enumerator; others are integers.
+struct BENCHMARK_EXPORT TypedArg {
+  enum Type { kInt, kDouble, kString, kEnum };
+
+  std::string name;  // Empty if the argument is not named.
+  Type type = kInt;
+  int64_t int_value = 0;  // Also the value of an enumerator.
+  double double_value = 0;
+  std::string string_value;  // Also the name of an enumerator.
+
+  // The value as shown in benchmark names, e.g. "4096", "0.75" or "enwik8".
+  std::string ValueString() const;
+};
+
+namespace internal {
+// The values of a typed argument axis. The integer argument of an instance
+// is an index into 'doubles' or 'names', except for enums, where it is the
+// value of the enumerator and 'names' holds the names of 'args'.
+struct BENCHMARK_EXPORT ArgAxis {
+  TypedArg::Type type = TypedArg::kInt;
+  std::vector<int64_t> args;
+  std::vector<double> doubles;
+  std::vector<std::string> names;
+
+  // The value the integer argument 'arg' stands for.
+  TypedArg Decode(const std::string& name, int64_t arg) const;
+};
+}  // namespace internal
+
 #if defined(_MSC_VER)
 #pragma warning(push)
 // C4324: 'benchmark::State': structure was padded due to alignment specifier
@@ -796,6 +930,55 @@ class BENCHMARK_EXPORT BENCHMARK_INTERNAL_CACHELINE_ALIGNED State {
   //   }
   inline bool KeepRunningBatch(IterationCount n);
 
+  template <IterationCount N>
+  class BatchRange;
+  template <IterationCount N>
+  struct BatchIterator;
+
+  // Returns a range of batches of 'N' iterations each, for operations too
+  // short to time one at a time. The body of the loop runs one batch, which
+  // the compile-time size lets the compiler unroll, and the loop only checks
+  // whether to go on once per batch. Each batch is timed with the cycle
+  // clock; the "batch_p50", "batch_p90", "batch_p99" and "batch_max"
+  // counters report the distribution of the time of one batch, in seconds.
+  // Like KeepRunningBatch(), the run may overshoot by up to 'N' iterations.
+  //
+  // Intended usage:
+  //   for (auto batch : state.Batches<64>()) {
+  //     for (IterationCount i = 0; i < batch.size(); ++i) {
+  //       benchmark::DoNotOptimize(x += y);
+  //     }
+  //   }
+  //
+  // REQUIRES: 'N' > 0. Neither the timer is paused nor the batches left
+  // early, which the batch times would not see.
+  template <IterationCount N>
+  BatchRange<N> Batches() {
+    return BatchRange<N>(this);
+  }
+
+  // Runs the benchmark as 'operation'-s that complete asynchronously,
+  // instead of a loop: each iteration is one operation, and 'in_flight' of
+  // them are kept outstanding until all have completed. Operations are issued,
+  // and their completions handled, on a built-in executor of
+  // 'executor_threads' threads. Reports "ops_per_second", the percentiles of
+  // the time from issue to completion of one operation as "latency_p50",
+  // "latency_p90" and "latency_p99", in seconds, and the mean number of
+  // operations in flight as "in_flight".
+  //
+  // Register the benchmark with UseRealTime(): the waiting thread barely uses
+  // any CPU time.
+  //
+  // Intended usage:
+  //   state.RunAsync(state.range(0), [&](benchmark::AsyncDone done) {
+  //     client.Call(request, [done](const Response&) { done(); });
+  //   });
+  //
+  // REQUIRES: 'in_flight' > 0, and neither the ranged-for loop nor
+  // KeepRunning() is used by the benchmark.
+  void RunAsync(int in_flight, const AsyncOperation& operation,
+                int executor_threads = 1);
+
   // REQUIRES: timer is running and 'SkipWithMessage(...)' or
   //   'SkipWithError(...)' has not been called by the current thread.
   // Stop the benchmark timer.  If not called, the timer will be
@@ -945,6 +1128,55 @@ class BENCHMARK_EXPORT BENCHMARK_INTERNAL_CACHELINE_ALIGNED State {
   // REQUIRES: a benchmark has exited its benchmarking loop.
   void SetLabel(const std::string& label);
 
+  // A handle to the counter 'name' of this thread, cheap enough to update on
+  // every iteration: the handle counters live in a flat array indexed by
+  // interned name instead of in the 'counters' map, to which they are added
+  // with 'flags' once the benchmark function returns. Getting the handle
+  // interns 'name'; getting it by CounterId costs nothing.
+  // Example:
+  //  static void BM_Lookup(benchmark::State& state) {
+  //    auto misses = state.counter("misses", benchmark::Counter::kAvgIterations);
+  //    for (auto _ : state) {
+  //      if (!table.Find(NextKey())) misses += 1;
+  //    }
+  //  }
+  CounterHandle counter(const std::string& name,
+                        Counter::Flags flags = Counter::kDefaults,
+                        Counter::OneK one_k = Counter::kIs1000,
+                        Counter::Aggregation aggregation = Counter::kSum) {
+    return counter(CounterId(name), flags, one_k, aggregation);
+  }
+  CounterHandle counter(const CounterId& id,
+                        Counter::Flags flags = Counter::kDefaults,
+                        Counter::OneK one_k = Counter::kIs1000,
+                        Counter::Aggregation aggregation = Counter::kSum);
+
+  // Returns a buffer of at least `bytes` bytes, backed as `policy` asks. The
+  // buffers are owned by the library and cached across the runs of a
+  // benchmark family: the n-th buffer requested by a thread is the same
+  // memory (grown if needed) on every instance and repetition of the family,
+  // so mapping and prefaulting are paid once. Setup() and Teardown() count
+  // their buffers apart from those of the benchmark threads. Their contents are unspecified.
+  // They are released when a benchmark of another family starts. The policy
+  // and the pages actually obtained are recorded in the run report. If no
+  // memory can be mapped, the benchmark is skipped with an error and nullptr
+  // is returned.
+  // Example:
+  //  static void BM_Sum(benchmark::State& state) {
+  //    benchmark::BufferPolicy policy;
+  //    policy.pages = benchmark::BufferPolicy::kHugePages2M;
+  //    float* data = state.AllocateBuffer<float>(state.range(0), policy);
+  //    std::fill(data, data + state.range(0), 1.0f);
+  //    for (auto _ : state) { ... }
+  //  }
+  void* AllocateBuffer(size_t bytes,
+                       const BufferPolicy& policy = BufferPolicy());
+
+  template <class T>
+  T* AllocateBuffer(size_t count, const BufferPolicy& policy = BufferPolicy()) {
+    return static_cast<T*>(AllocateBuffer(count * sizeof(T), policy));
+  }
+
   // Range arguments for this run. CHECKs if the argument has been set.
   BENCHMARK_ALWAYS_INLINE
   int64_t range(std::size_t pos = 0) const {
@@ -952,6 +1184,30 @@ class BENCHMARK_EXPORT BENCHMARK_INTERNAL_CACHELINE_ALIGNED State {
     return range_[pos];
   }
 
+  // The argument at 'pos' as a T. For an argument of a typed axis this is
+  // the value it stands for: the number for a floating-point T, the
+  // enumerator for an enum T, and the value as shown in the benchmark name
+  // for std::string. Integral types get range(pos).
+  // Example:
+  //  BENCHMARK(BM_Probe)->DoubleAxis("load", {0.5, 0.75, 0.9});
+  //  static void BM_Probe(benchmark::State& state) {
+  //    HashTable table(kSize, state.range_as<double>(0));
+  //    ...
+  template <class T>
+  T range_as(std::size_t pos = 0) const;
+
+  // As range_as(), for the argument named 'name'. CHECKs that there is one.
+  template <class T>
+  T arg(const std::string& name) const {
+    return range_as<T>(arg_index(name));
+  }
+
+  // The position of the argument named 'name'. CHECKs that there is one.
+  std::size_t arg_index(const std::string& name) const;
+
+  // The argument at 'pos' with its name and typed value.
+  TypedArg typed_range(std::size_t pos) const;
+
   BENCHMARK_DEPRECATED_MSG("use 'range(0)' instead")
   int64_t range_x() const { return range(0); }
 
@@ -1012,6 +1268,7 @@ class BENCHMARK_EXPORT BENCHMARK_INTERNAL_CACHELINE_ALIGNED State {
         const std::vector<int64_t>& ranges, int thread_i, int n_threads,
         internal::ThreadTimer* timer, internal::ThreadManager* manager,
         internal::PerfCountersMeasurement* perf_counters_measurement,
+        internal::EnergyMeasurement* energy_measurement,
         ProfilerManager* profiler_manager);
 
   void StartKeepRunning();
@@ -1019,6 +1276,14 @@ class BENCHMARK_EXPORT BENCHMARK_INTERNAL_CACHELINE_ALIGNED State {
   // is_batch must be true unless n is 1.
   inline bool KeepRunningInternal(IterationCount n, bool is_batch);
   void FinishKeepRunning();
+  // Out-of-line steps of Batches(): start timing the first batch, time the
+  // batch that just ended and start the next, report the batch times.
+  void StartBatches();
+  void NextBatch();
+  void FinishBatches(IterationCount batch_size);
+  void AddEnergyCounters();
+  // Adds the counter() counters to 'counters'.
+  void FoldCounterSlots();
 
   const std::string name_;
   const int thread_index_;
@@ -1027,7 +1292,25 @@ class BENCHMARK_EXPORT BENCHMARK_INTERNAL_CACHELINE_ALIGNED State {
   internal::ThreadTimer* const timer_;
   internal::ThreadManager* const manager_;
   internal::PerfCountersMeasurement* const perf_counters_measurement_;
+  internal::EnergyMeasurement* const energy_measurement_;
   ProfilerManager* const profiler_manager_;
+  // One slot per perf counter, accumulated on every PauseTiming() and folded
+  // into `counters` once the run finishes.
+  std::vector<double> perf_counter_values_;
+  // Number of AllocateBuffer() calls so far; the cache key of the next one.
+  int num_buffers_;
+  // The names and axes of the arguments, null outside of a benchmark run.
+  const std::vector<std::string>* arg_names_;
+  const std::vector<internal::ArgAxis>* arg_axes_;
+  // The counter() counters by CounterId index, and the indices in use.
+  std::vector<Counter> counter_slots_;
+  std::vector<size_t> used_counter_slots_;
+  // The batch times of Batches() in cycle clock ticks, the tick at which the
+  // current batch started, and the ticks and wall time at the first batch.
+  std::vector<uint64_t> batch_histogram_;
+  int64_t batch_tick_;
+  int64_t batches_start_tick_;
+  double batches_start_time_;
 
   friend class internal::BenchmarkInstance;
 };
@@ -1035,6 +1318,39 @@ class BENCHMARK_EXPORT BENCHMARK_INTERNAL_CACHELINE_ALIGNED State {
 #pragma warning(pop)
 #endif  // _MSC_VER_
 
+namespace internal {
+// Converts the arguments for State::range_as(): integral and enum types.
+template <class T, class Enable = void>
+struct RangeAs {
+  static T Get(const State& state, std::size_t pos) {
+    return static_cast<T>(state.range(pos));
+  }
+};
+
+template <class T>
+struct RangeAs<T, typename std::enable_if<
+                      std::is_floating_point<T>::value>::type> {
+  static T Get(const State& state, std::size_t pos) {
+    const TypedArg arg = state.typed_range(pos);
+    return static_cast<T>(arg.type == TypedArg::kDouble
+                              ? arg.double_value
+                              : static_cast<double>(arg.int_value));
+  }
+};
+
+template <>
+struct RangeAs<std::string> {
+  static std::string Get(const State& state, std::size_t pos) {
+    return state.typed_range(pos).ValueString();
+  }
+};
+}  // namespace internal
+
+template <class T>
+T State::range_as(std::size_t pos) const {
+  return internal::RangeAs<T>::Get(*this, pos);
+}
+
 inline BENCHMARK_ALWAYS_INLINE bool State::KeepRunning() {
   return KeepRunningInternal(1, /*is_batch=*/false);
 }
@@ -1119,6 +1435,139 @@ inline BENCHMARK_ALWAYS_INLINE State::StateIterator State::end() {
   return StateIterator();
 }
 
+namespace internal {
+// The value of an iteration of State::Batches(): a batch of 'N' iterations.
+template <IterationCount N>
+struct Batch {
+  static constexpr IterationCount size() { return N; }
+};
+}  // namespace internal
+
+template <IterationCount N>
+struct State::BatchIterator {
+  typedef std::forward_iterator_tag iterator_category;
+  typedef internal::Batch<N> value_type;
+  typedef internal::Batch<N> reference;
+  typedef internal::Batch<N> pointer;
+  typedef std::ptrdiff_t difference_type;
+
+ private:
+  friend class BatchRange<N>;
+  BENCHMARK_ALWAYS_INLINE
+  BatchIterator() : cached_(0), parent_() {}
+
+  BENCHMARK_ALWAYS_INLINE
+  explicit BatchIterator(State* st)
+      : cached_(st->skipped() ? 0 : (st->max_iterations + N - 1) / N),
+        parent_(st) {}
+
+ public:
+  BENCHMARK_ALWAYS_INLINE
+  internal::Batch<N> operator*() const { return internal::Batch<N>(); }
+
+  BENCHMARK_ALWAYS_INLINE
+  BatchIterator& operator++() {
+    assert(cached_ > 0);
+    --cached_;
+    parent_->NextBatch();
+    return *this;
+  }
+
+  BENCHMARK_ALWAYS_INLINE
+  bool operator!=(BatchIterator const&) const {
+    if (BENCHMARK_BUILTIN_EXPECT(cached_ != 0, true)) return true;
+    parent_->FinishBatches(N);
+    return false;
+  }
+
+ private:
+  IterationCount cached_;
+  State* const parent_;
+};
+
+template <IterationCount N>
+class State::BatchRange {
+ public:
+  BENCHMARK_ALWAYS_INLINE
+  explicit BatchRange(State* st) : state_(st) {}
+
+  BENCHMARK_ALWAYS_INLINE
+  BatchIterator<N> begin() { return BatchIterator<N>(state_); }
+  BENCHMARK_ALWAYS_INLINE
+  BatchIterator<N> end() {
+    state_->StartKeepRunning();
+    state_->StartBatches();
+    return BatchIterator<N>();
+  }
+
+ private:
+  static_assert(N > 0, "a batch runs at least one iteration");
+  State* const state_;
+};
+
+// Statistics of the SharedData() cache since the start of the process.
+struct BENCHMARK_EXPORT SharedDataStats {
+  int64_t hits = 0;
+  int64_t misses = 0;  // Each of which built a dataset.
+  int64_t evictions = 0;
+  double build_seconds = 0;  // Wall time spent in the factories.
+  size_t entries = 0;        // Datasets currently cached.
+  size_t bytes = 0;          // Estimated size of the cached datasets.
+};
+
+BENCHMARK_EXPORT SharedDataStats GetSharedDataStats();
+
+namespace internal {
+// The size of a SharedData() dataset for the memory budget: its own size,
+// plus that of its elements for containers.
+template <class T, class Enable = void>
+struct SharedDataBytes {
+  static size_t Get(const T& /*data*/) { return sizeof(T); }
+};
+
+template <class T>
+struct SharedDataBytes<T, decltype(void(std::declval<const T&>().size()),
+                                   void(sizeof(typename T::value_type)))> {
+  static size_t Get(const T& data) {
+    return sizeof(T) +
+           static_cast<size_t>(data.size()) * sizeof(typename T::value_type);
+  }
+};
+
+typedef std::function<std::shared_ptr<const void>(size_t* bytes)>
+    SharedDataBuilder;
+
+BENCHMARK_EXPORT std::shared_ptr<const void> GetSharedData(
+    const std::string& key, const SharedDataBuilder& build);
+}  // namespace internal
+
+// Returns the dataset cached under 'key', building it with 'factory' (a
+// callable returning a T) if it is not cached. Each dataset is built once
+// and shared read-only by every benchmark instance, repetition and thread
+// asking for 'key'; concurrent callers wait for the one building it. When
+// the cached datasets outgrow --benchmark_shared_data_budget_mb, the least
+// recently used are evicted: they stay alive while still referenced and are
+// rebuilt when asked for again. The hit rate and build time are reported as
+// counters of the runs that use the cache.
+// Example:
+//  static void BM_Search(benchmark::State& state) {
+//    auto keys = benchmark::SharedData<std::vector<uint64_t>>(
+//        "keys/" + std::to_string(state.range(0)),
+//        [&] { return RandomKeys(state.range(0)); });
+//    for (auto _ : state) { ... }
+//  }
+// REQUIRES: All calls with the same 'key' ask for the same T.
+template <class T, class Factory>
+std::shared_ptr<const T> SharedData(const std::string& key,
+                                    Factory&& factory) {
+  return std::static_pointer_cast<const T>(internal::GetSharedData(
+      key, [&factory](size_t* bytes) -> std::shared_ptr<const void> {
+        std::shared_ptr<const T> data = std::make_shared<T>(factory());
+        *bytes = internal::SharedDataBytes<T>::Get(*data);
+        return data;
+      }));
+}
+
 // Base class for user-defined multi-threading
 struct ThreadRunnerBase {
   virtual ~ThreadRunnerBase() {}
@@ -1192,6 +1641,56 @@ class BENCHMARK_EXPORT Benchmark {
   // REQUIRES: The function passed to the constructor must accept arg1, arg2 ...
   Benchmark* ArgsProduct(const std::vector<std::vector<int64_t>>& arglists);
 
+  // Run this benchmark for values in [lo..hi] chosen while running: a coarse
+  // Range(lo, hi) grid is refined by bisecting wherever the time per item
+  // (the inverse of the items_per_second counter if set, otherwise the time
+  // per iteration over the argument) changes sharply between neighbouring
+  // values, for at most 'budget' values in total per thread count. The
+  // intervals that still bound a sharp change, i.e. the performance cliffs,
+  // are reported as "<name>/<from>..<to>_cliff" aggregates.
+  // REQUIRES: The function passed to the constructor must accept an arg1.
+  Benchmark* AdaptiveRange(int64_t lo, int64_t hi, int budget);
+
+  // Run this benchmark for working sets around the size of each data cache
+  // level of the host (0.5x, 0.9x and 1.5x of each) and in DRAM (4x and 16x
+  // the last level), with the argument being the working set in bytes divided
+  // by 'bytes_per_arg'. Unless the benchmark sets one, the report label of
+  // each run is the level its working set fits in: "L1", "L2", ... or "DRAM".
+  // REQUIRES: The function passed to the constructor must accept an arg1.
+  Benchmark* WorkingSetSweep(int64_t bytes_per_arg = 1);
+
+  // Run this benchmark for each of 'values' of the argument 'name', in
+  // product with the axes added before. The name of each instance shows the
+  // value ("load:0.75"), which State::range_as<double>() and
+  // State::arg<double>() return; range() is its index in 'values'.
+  // REQUIRES: The other arguments of the benchmark are axes too.
+  Benchmark* DoubleAxis(const std::string& name,
+                        const std::vector<double>& values);
+
+  // As DoubleAxis(), for strings such as the names of datasets.
+  Benchmark* StringAxis(const std::string& name,
+                        const std::vector<std::string>& values);
+
+  // As DoubleAxis(), for the enumerators of 'Enum' with their names:
+  //   EnumAxis<Probe>("probe", {{Probe::kLinear, "linear"},
+  //                             {Probe::kQuadratic, "quadratic"}});
+  // range() is the value of the enumerator.
+  template <class Enum>
+  Benchmark* EnumAxis(const std::string& name,
+                      const std::vector<std::pair<Enum, std::string>>& values) {
+    ArgAxis axis;
+    axis.type = TypedArg::kEnum;
+    for (const auto& value : values) {
+      axis.args.push_back(static_cast<int64_t>(value.first));
+      axis.names.push_back(value.second);
+    }
+    return AddAxis(name, std::move(axis));
+  }
+
+  // As DoubleAxis(), for integers, to combine them with other typed axes.
+  Benchmark* IntAxis(const std::string& name,
+                     const std::vector<int64_t>& values);
+
   // Equivalent to ArgNames({name})
   Benchmark* ArgName(const std::string& name);
 
@@ -1353,17 +1852,29 @@ class BENCHMARK_EXPORT Benchmark {
 
  private:
   friend class BenchmarkFamilies;
+  friend class BenchmarkFilter;
   friend class BenchmarkInstance;
+  friend class BenchmarkInstanceGenerator;
+
+  Benchmark* AddAxis(const std::string& name, ArgAxis axis);
 
   std::string name_;
   AggregationReportMode aggregation_report_mode_;
-  std::vector<std::string> arg_names_;      // Args for all benchmark runs
-  std::vector<std::vector<int64_t>> args_;  // Args for all benchmark runs
+  std::vector<std::string> arg_names_;  // Args for all benchmark runs
+  // The typed axes of the arguments, by position; empty without any.
+  std::vector<ArgAxis> arg_axes_;
+  // Args for all benchmark runs, as a sequence of cartesian products of
+  // per-argument value lists (Args() adds a product of single values). The
+  // products are only expanded when the instances are generated.
+  std::vector<std::vector<std::vector<int64_t>>> args_;
 
   TimeUnit time_unit_;
   bool use_default_time_unit_;
 
   int range_multiplier_;
+  int adaptive_budget_;  // Of the AdaptiveRange(), 0 if none.
+  // The default report labels of the WorkingSetSweep() arguments.
+  std::map<int64_t, std::string> working_set_labels_;
   double min_time_;
   double min_warmup_time_;
   IterationCount iterations_;
@@ -1839,6 +2350,11 @@ class BENCHMARK_EXPORT BenchmarkReporter {
     std::string aggregate_name;
     StatisticUnit aggregate_unit;
     std::string report_label;  // Empty if not set by benchmark.
+    // The arguments with their types, empty unless the benchmark has typed
+    // argument axes. Unnamed arguments are named "arg<position>".
+    std::vector<TypedArg> args;
+    // How the State::AllocateBuffer() buffers were backed; empty if none.
+    std::string buffer_policy;
     internal::Skipped skipped;
     std::string skip_message;
 
@@ -0,0 +1,180 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "adaptive_range.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <utility>
+
+#include "benchmark_register.h"
+#include "check.h"
+#include "string_util.h"
+
+namespace benchmark {
+namespace internal {
+
+constexpr double AdaptiveRangeExplorer::kCliffRatio;
+
+namespace {
+
+// How much larger the larger of two positive times is than the smaller one.
+double ChangeRatio(double a, double b) {
+  if (a <= 0 || b <= 0) {
+    return 1.0;
+  }
+  return std::max(a, b) / std::min(a, b);
+}
+
+// A point strictly inside (a, b), geometric for wide positive intervals so
+// that the exploration is even on the usual logarithmic scale.
+int64_t Midpoint(int64_t a, int64_t b) {
+  int64_t mid = a + (b - a) / 2;
+  if (a > 0 && b / a >= 4) {
+    mid = static_cast<int64_t>(std::llround(
+        std::sqrt(static_cast<double>(a) * static_cast<double>(b))));
+  }
+  return std::min(std::max(mid, a + 1), b - 1);
+}
+
+}  // namespace
+
+std::vector<int64_t> AdaptiveRangeExplorer::InitialPoints(int64_t lo,
+                                                          int64_t hi,
+                                                          int budget,
+                                                          int multiplier) {
+  std::vector<int64_t> grid;
+  AddRange(&grid, lo, hi, multiplier);
+  const size_t max_points =
+      std::max<size_t>(2, static_cast<size_t>(budget / 2));
+  if (grid.size() <= max_points) {
+    return grid;
+  }
+  // Keep both ends and spread the rest evenly.
+  std::vector<int64_t> points;
+  for (size_t i = 0; i < max_points; ++i) {
+    points.push_back(grid[i * (grid.size() - 1) / (max_points - 1)]);
+  }
+  return points;
+}
+
+void AdaptiveRangeExplorer::AddMeasurement(int64_t x, double time_per_item) {
+  if (time_per_item > 0) {
+    measurements_[x] = time_per_item;
+  }
+}
+
+std::vector<int64_t> AdaptiveRangeExplorer::NextPoints() {
+  // The splittable intervals with a sharp change, sharpest first.
+  std::vector<std::pair<double, int64_t>> candidates;
+  for (auto it = measurements_.begin(), next = std::next(it);
+       it != measurements_.end() && next != measurements_.end();
+       it = next++) {
+    const double ratio = ChangeRatio(it->second, next->second);
+    if (ratio >= kCliffRatio && next->first - it->first > 1) {
+      candidates.emplace_back(ratio, Midpoint(it->first, next->first));
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const std::pair<double, int64_t>& a,
+               const std::pair<double, int64_t>& b) {
+              return a.first > b.first;
+            });
+
+  // The initial grid counts against the budget too.
+  const int spent =
+      std::max(num_requested_, static_cast<int>(measurements_.size()));
+  std::vector<int64_t> points;
+  for (const auto& candidate : candidates) {
+    if (spent + static_cast<int>(points.size()) >= budget_) {
+      break;
+    }
+    points.push_back(candidate.second);
+  }
+  num_requested_ = spent + static_cast<int>(points.size());
+  return points;
+}
+
+std::vector<AdaptiveRangeExplorer::Cliff> AdaptiveRangeExplorer::Cliffs()
+    const {
+  std::vector<Cliff> cliffs;
+  for (auto it = measurements_.begin(), next = std::next(it);
+       it != measurements_.end() && next != measurements_.end();
+       it = next++) {
+    if (ChangeRatio(it->second, next->second) >= kCliffRatio) {
+      cliffs.push_back({it->first, next->first, it->second, next->second});
+    }
+  }
+  return cliffs;
+}
+
+double TimePerItem(const std::vector<BenchmarkReporter::Run>& runs, int64_t x,
+                   bool use_real_time) {
+  double total = 0;
+  int count = 0;
+  for (const BenchmarkReporter::Run& run : runs) {
+    if (run.skipped || run.iterations == 0) {
+      continue;
+    }
+    auto items = run.counters.find("items_per_second");
+    if (items != run.counters.end() && items->second.value > 0) {
+      total += 1.0 / items->second.value;
+    } else {
+      const double seconds =
+          use_real_time ? run.real_accumulated_time : run.cpu_accumulated_time;
+      total += seconds / static_cast<double>(run.iterations) /
+               static_cast<double>(std::max<int64_t>(x, 1));
+    }
+    ++count;
+  }
+  return count == 0 ? -1.0 : total / count;
+}
+
+std::vector<BenchmarkReporter::Run> ReportCliffs(
+    const AdaptiveRangeExplorer& explorer,
+    const BenchmarkReporter::Run& sample) {
+  typedef BenchmarkReporter::Run Run;
+  std::vector<Run> results;
+
+  // Keep the name of the argument, if any.
+  const size_t colon = sample.run_name.args.find(':');
+  const std::string arg_name = colon == std::string::npos
+                                   ? std::string()
+                                   : sample.run_name.args.substr(0, colon + 1);
+  for (const AdaptiveRangeExplorer::Cliff& cliff : explorer.Cliffs()) {
+    Run run;
+    run.run_name = sample.run_name;
+    run.run_name.args = StrFormat("%s%" PRId64 "..%" PRId64, arg_name.c_str(),
+                                  cliff.from, cliff.to);
+    run.family_index = sample.family_index;
+    run.per_family_instance_index = sample.per_family_instance_index;
+    run.run_type = Run::RT_Aggregate;
+    run.aggregate_name = "cliff";
+    run.aggregate_unit = StatisticUnit::kTime;
+    run.repetitions = sample.repetitions;
+    run.repetition_index = Run::no_repetition_index;
+    run.threads = sample.threads;
+    run.time_unit = sample.time_unit;
+    run.iterations = 0;
+    run.real_accumulated_time = cliff.time_after;
+    run.cpu_accumulated_time = cliff.time_after;
+    run.counters["ratio"] = Counter(cliff.time_after / cliff.time_before);
+    results.push_back(run);
+  }
+  return results;
+}
+
+}  // namespace internal
+}  // namespace benchmark
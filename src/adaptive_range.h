@@ -0,0 +1,96 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCHMARK_ADAPTIVE_RANGE_H_
+#define BENCHMARK_ADAPTIVE_RANGE_H_
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+// C4251: <symbol> needs to have dll-interface to be used by clients of class
+#pragma warning(disable : 4251)
+#endif
+
+namespace benchmark {
+namespace internal {
+
+// Explores the argument of a Benchmark::AdaptiveRange() family: starting from
+// a coarse grid, it bisects the intervals between neighbouring points where
+// the time per item changes sharply, until the budget of points is spent or
+// no such interval can be split, and reports the sharp changes left as
+// cliffs.
+class BENCHMARK_EXPORT AdaptiveRangeExplorer {
+ public:
+  // Neighbouring points whose times per item differ by at least this factor
+  // bound a cliff.
+  static constexpr double kCliffRatio = 1.25;
+
+  // The coarse grid measured first: the points of Range(lo, hi) with
+  // 'multiplier', thinned out to half of 'budget' if there are more.
+  static std::vector<int64_t> InitialPoints(int64_t lo, int64_t hi, int budget,
+                                            int multiplier);
+
+  explicit AdaptiveRangeExplorer(int budget) : budget_(budget) {}
+
+  // Records the time per item measured with the argument 'x'.
+  void AddMeasurement(int64_t x, double time_per_item);
+
+  // The points to measure next, sharpest changes first. Empty once the
+  // exploration is over.
+  std::vector<int64_t> NextPoints();
+
+  struct Cliff {
+    int64_t from;
+    int64_t to;
+    double time_before;  // Per item, at 'from'.
+    double time_after;   // Per item, at 'to'.
+  };
+  // The intervals between neighbouring points measured so far across which
+  // the time per item changes sharply.
+  std::vector<Cliff> Cliffs() const;
+
+ private:
+  int budget_;
+  int num_requested_ = 0;
+  std::map<int64_t, double> measurements_;
+};
+
+// The time per item of 'runs' of the instance with argument 'x': the inverse
+// of the items_per_second counter if the benchmark sets it, otherwise the
+// time per iteration over 'x'. The mean over repetitions, or a negative value
+// if none of the runs succeeded.
+BENCHMARK_EXPORT double TimePerItem(
+    const std::vector<BenchmarkReporter::Run>& runs, int64_t x,
+    bool use_real_time);
+
+// One aggregate run per cliff of 'explorer', named after 'sample', a run of
+// the explored instances, e.g. "BM_Copy/size:4096..8192_cliff". Their time is
+// the time per item after the cliff and the "ratio" counter its height.
+BENCHMARK_EXPORT std::vector<BenchmarkReporter::Run> ReportCliffs(
+    const AdaptiveRangeExplorer& explorer,
+    const BenchmarkReporter::Run& sample);
+
+}  // namespace internal
+}  // namespace benchmark
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif  // BENCHMARK_ADAPTIVE_RANGE_H_
@@ -0,0 +1,159 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "async_runner.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "batch_histogram.h"
+#include "check.h"
+#include "timers.h"
+
+namespace benchmark {
+namespace internal {
+
+AsyncExecutor::AsyncExecutor(int num_threads) {
+  BM_CHECK_GT(num_threads, 0);
+  threads_.reserve(static_cast<size_t>(num_threads));
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.emplace_back(&AsyncExecutor::Work, this);
+  }
+}
+
+AsyncExecutor::~AsyncExecutor() {
+  {
+    MutexLock l(mutex_);
+    stopping_ = true;
+  }
+  cond_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void AsyncExecutor::Post(std::function<void()> task) {
+  // Notify under the lock: as soon as it is released the task may run and
+  // the executor be destroyed.
+  MutexLock l(mutex_);
+  tasks_.push_back(std::move(task));
+  cond_.notify_one();
+}
+
+void AsyncExecutor::Work() {
+  for (;;) {
+    std::function<void()> task;
+    {
+      MutexLock l(mutex_);
+      cond_.wait(l.native_handle(),
+                 [this]() REQUIRES(mutex_) {
+                   return stopping_ || !tasks_.empty();
+                 });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+namespace {
+
+// The bookkeeping of one RunAsyncOperations(), shared by the executor
+// threads.
+class AsyncRun {
+ public:
+  AsyncRun(IterationCount operations, const AsyncOperation& operation,
+           AsyncExecutor& executor)
+      : operations_(operations), operation_(operation), executor_(executor) {}
+
+  AsyncResult Run(int in_flight) {
+    const IterationCount first =
+        std::min<IterationCount>(in_flight, operations_);
+    const double start = ChronoClockNow();
+    {
+      MutexLock l(mutex_);
+      issued_ = first;
+    }
+    for (IterationCount i = 0; i < first; ++i) {
+      executor_.Post([this]() { Issue(); });
+    }
+    MutexLock l(mutex_);
+    // The executor must outlive every done() too, wherever they run.
+    done_.wait(l.native_handle(), [this]() REQUIRES(mutex_) {
+      return result_.completed == operations_ && returned_ == operations_;
+    });
+    result_.seconds = ChronoClockNow() - start;
+    return result_;
+  }
+
+ private:
+  void Issue() {
+    const double start = ChronoClockNow();
+    operation_([this, start]() {
+      executor_.Post([this, start]() { Complete(start); });
+      MutexLock l(mutex_);
+      if (++returned_ == operations_) {
+        done_.notify_one();
+      }
+    });
+  }
+
+  void Complete(double start) {
+    const double latency = ChronoClockNow() - start;
+    bool issue = false;
+    {
+      MutexLock l(mutex_);
+      AddBatchTicks(&result_.latency_histogram,
+                    static_cast<uint64_t>(latency * 1e9));
+      result_.total_latency += latency;
+      if (issued_ < operations_) {
+        ++issued_;
+        issue = true;
+      }
+      if (++result_.completed == operations_ && returned_ == operations_) {
+        done_.notify_one();
+      }
+    }
+    if (issue) {
+      Issue();
+    }
+  }
+
+  const IterationCount operations_;
+  const AsyncOperation& operation_;
+  AsyncExecutor& executor_;
+
+  Mutex mutex_;
+  Condition done_;
+  IterationCount issued_ GUARDED_BY(mutex_) = 0;
+  // The done() calls that have returned.
+  IterationCount returned_ GUARDED_BY(mutex_) = 0;
+  AsyncResult result_ GUARDED_BY(mutex_);
+};
+
+}  // namespace
+
+AsyncResult RunAsyncOperations(IterationCount operations, int in_flight,
+                               const AsyncOperation& operation,
+                               AsyncExecutor& executor) {
+  BM_CHECK_GT(in_flight, 0);
+  AsyncRun run(operations, operation, executor);
+  return run.Run(in_flight);
+}
+
+}  // namespace internal
+}  // namespace benchmark
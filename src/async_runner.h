@@ -0,0 +1,82 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCHMARK_ASYNC_RUNNER_H_
+#define BENCHMARK_ASYNC_RUNNER_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "mutex.h"
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+// C4251: <symbol> needs to have dll-interface to be used by clients of class
+#pragma warning(disable : 4251)
+#endif
+
+namespace benchmark {
+namespace internal {
+
+// A pool of threads running the tasks posted to it in order.
+class BENCHMARK_EXPORT AsyncExecutor {
+ public:
+  explicit AsyncExecutor(int num_threads);
+  // Runs the tasks still queued, then joins the threads.
+  ~AsyncExecutor();
+
+  AsyncExecutor(const AsyncExecutor&) = delete;
+  AsyncExecutor& operator=(const AsyncExecutor&) = delete;
+
+  void Post(std::function<void()> task);
+
+ private:
+  void Work();
+
+  Mutex mutex_;
+  Condition cond_;
+  std::deque<std::function<void()>> tasks_ GUARDED_BY(mutex_);
+  bool stopping_ GUARDED_BY(mutex_) = false;
+  std::vector<std::thread> threads_;
+};
+
+// What State::RunAsync() measured.
+struct AsyncResult {
+  IterationCount completed = 0;
+  double seconds = 0;  // From the first issue to the last completion.
+  // The latencies of the operations, in nanoseconds, in the buckets of
+  // AddBatchTicks().
+  std::vector<uint64_t> latency_histogram;
+  double total_latency = 0;  // In seconds.
+};
+
+// Runs 'operations' operations, 'in_flight' of them at a time, on
+// 'executor'. Returns once every operation has completed and every done()
+// has returned.
+BENCHMARK_EXPORT AsyncResult RunAsyncOperations(
+    IterationCount operations, int in_flight, const AsyncOperation& operation,
+    AsyncExecutor& executor);
+
+}  // namespace internal
+}  // namespace benchmark
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif  // BENCHMARK_ASYNC_RUNNER_H_
@@ -0,0 +1,93 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "batch_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "check.h"
+
+namespace benchmark {
+namespace internal {
+
+namespace {
+
+constexpr int kSubBits = 4;
+constexpr uint64_t kSubBuckets = uint64_t{1} << kSubBits;
+
+size_t BucketOf(uint64_t ticks) {
+  if (ticks < kSubBuckets) {
+    return static_cast<size_t>(ticks);
+  }
+  int msb = 63;
+  while ((ticks >> msb) == 0) {
+    --msb;
+  }
+  const int shift = msb - kSubBits;
+  return static_cast<size_t>(
+      static_cast<uint64_t>(shift + 1) * kSubBuckets +
+      ((ticks >> shift) & (kSubBuckets - 1)));
+}
+
+double BucketMiddle(size_t bucket) {
+  if (bucket < kSubBuckets) {
+    return static_cast<double>(bucket);
+  }
+  const int shift = static_cast<int>(bucket / kSubBuckets) - 1;
+  const double width = std::ldexp(1.0, shift);
+  const double lo = static_cast<double>(kSubBuckets + bucket % kSubBuckets) *
+                    width;
+  return lo + (width - 1) / 2;
+}
+
+}  // namespace
+
+void AddBatchTicks(std::vector<uint64_t>* buckets, uint64_t ticks) {
+  if (buckets->empty()) {
+    buckets->assign(kBatchHistogramBuckets, 0);
+  }
+  ++(*buckets)[BucketOf(ticks)];
+}
+
+double BatchTicksPercentile(const std::vector<uint64_t>& buckets, double q) {
+  const uint64_t count =
+      std::accumulate(buckets.begin(), buckets.end(), uint64_t{0});
+  BM_CHECK_GT(count, 0u);
+  // The rank of the quantile, counting from 1.
+  const uint64_t rank =
+      std::max<uint64_t>(1, static_cast<uint64_t>(
+                                std::ceil(q * static_cast<double>(count))));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return BucketMiddle(i);
+    }
+  }
+  return BatchTicksMax(buckets);
+}
+
+double BatchTicksMax(const std::vector<uint64_t>& buckets) {
+  for (size_t i = buckets.size(); i > 0; --i) {
+    if (buckets[i - 1] != 0) {
+      return BucketMiddle(i - 1);
+    }
+  }
+  return 0;
+}
+
+}  // namespace internal
+}  // namespace benchmark
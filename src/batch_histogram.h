@@ -0,0 +1,47 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCHMARK_BATCH_HISTOGRAM_H_
+#define BENCHMARK_BATCH_HISTOGRAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+namespace benchmark {
+namespace internal {
+
+// The cycle clock times of the batches of State::Batches(), kept in
+// log-linear buckets: the values below 16 exactly, then 16 buckets per power
+// of two, so that a bucket is within 1/16th of the values it holds.
+constexpr size_t kBatchHistogramBuckets = 61 * 16;
+
+// Counts 'ticks' in 'buckets', which it sizes on first use.
+BENCHMARK_EXPORT void AddBatchTicks(std::vector<uint64_t>* buckets,
+                                    uint64_t ticks);
+
+// The q-th quantile of the counted ticks, at the middle of its bucket.
+// REQUIRES: At least one value was counted.
+BENCHMARK_EXPORT double BatchTicksPercentile(
+    const std::vector<uint64_t>& buckets, double q);
+
+// The middle of the bucket of the largest counted value.
+BENCHMARK_EXPORT double BatchTicksMax(const std::vector<uint64_t>& buckets);
+
+}  // namespace internal
+}  // namespace benchmark
+
+#endif  // BENCHMARK_BATCH_HISTOGRAM_H_
@@ -14,9 +14,15 @@
 
 #include "benchmark/benchmark.h"
 
+#include "adaptive_range.h"
+#include "async_runner.h"
+#include "batch_histogram.h"
 #include "benchmark_api_internal.h"
+#include "benchmark_filter.h"
 #include "benchmark_runner.h"
+#include "buffer_allocator.h"
 #include "internal_macros.h"
+#include "shared_data.h"
 
 #ifndef BENCHMARK_OS_WINDOWS
 #if !defined(BENCHMARK_OS_FUCHSIA) && !defined(BENCHMARK_OS_QURT)
@@ -50,6 +56,8 @@
 #include "commandlineflags.h"
 #include "complexity.h"
 #include "counter.h"
+#include "cycleclock.h"
+#include "energy.h"
 #include "log.h"
 #include "mutex.h"
 #include "perf_counters.h"
@@ -58,6 +66,7 @@
 #include "string_util.h"
 #include "thread_manager.h"
 #include "thread_timer.h"
+#include "timers.h"
 
 namespace benchmark {
 // Print a list of benchmarks. This option overrides all other options.
@@ -68,6 +77,14 @@ BM_DEFINE_bool(benchmark_list_tests, false);
 // linked into the binary are run.
 BM_DEFINE_string(benchmark_filter, "");
 
+// A structured selection of the benchmarks to execute, in addition to
+// --benchmark_filter: family name globs and comparisons of named arguments
+// (or argN, or threads) with integers, combined with &&, || and !, and
+// optionally followed by 'except' and a comma-separated list of family globs.
+// E.g. "BM_Copy* && size>=4096 except BM_CopySlow". It is compiled once and
+// evaluated on the arguments, before the names of the instances are built.
+BM_DEFINE_string(benchmark_select, "");
+
 // Specification of how long to run the benchmark.
 //
 // It can be either an exact number of iterations (specified as `<integer>x`),
@@ -137,10 +154,31 @@ BM_DEFINE_string(benchmark_color, "auto");
 // Valid values: 'true'/'yes'/1, 'false'/'no'/0.  Defaults to false.
 BM_DEFINE_bool(benchmark_counters_tabular, false);
 
-// List of additional perf counters to collect, in libpfm format. For more
-// information about libpfm: https://man7.org/linux/man-pages/man3/libpfm.3.html
+// List of additional perf counters to collect, in libpfm format when built with
+// libpfm, otherwise by their perf(1) generic event names or as raw `rNNNN`
+// encodings. For more information about libpfm:
+// https://man7.org/linux/man-pages/man3/libpfm.3.html
 BM_DEFINE_string(benchmark_perf_counters, "");
 
+// Directory to write a sampled CPU profile of every benchmark to, one file of
+// folded stacks per benchmark run, ready to be turned into a flamegraph. The
+// profile is taken during an additional run of each benchmark. Linux only.
+BM_DEFINE_string(benchmark_profile, "");
+
+// Whether --benchmark_profile also records precise memory access samples
+// (Intel PEBS load latency or AMD IBS) and writes, per benchmark run, a report
+// of load latencies, data sources and the hottest cache lines.
+BM_DEFINE_bool(benchmark_profile_memory, false);
+
+// Whether to measure the energy consumed by each benchmark through the RAPL
+// counters of the processor, reported per iteration and as average power.
+// Linux only, and usually requires root privileges.
+BM_DEFINE_bool(benchmark_energy, false);
+
+// Memory budget in MiB of the datasets cached by SharedData(), beyond which
+// the least recently used are evicted. 0 for no limit.
+BM_DEFINE_int32(benchmark_shared_data_budget_mb, 0);
+
 // Extra context to include in the output formatted as comma-separated key-value
 // pairs. Kept internal as it's only used for parsing from env/command line.
 BM_DEFINE_kvpairs(benchmark_context, {});
@@ -181,6 +219,7 @@ State::State(std::string name, IterationCount max_iters,
              const std::vector<int64_t>& ranges, int thread_i, int n_threads,
              internal::ThreadTimer* timer, internal::ThreadManager* manager,
              internal::PerfCountersMeasurement* perf_counters_measurement,
+             internal::EnergyMeasurement* energy_measurement,
              ProfilerManager* profiler_manager)
     : total_iterations_(0),
       batch_leftover_(0),
@@ -196,20 +235,23 @@ State::State(std::string name, IterationCount max_iters,
       timer_(timer),
       manager_(manager),
       perf_counters_measurement_(perf_counters_measurement),
-      profiler_manager_(profiler_manager) {
+      energy_measurement_(energy_measurement),
+      profiler_manager_(profiler_manager),
+      num_buffers_(0),
+      arg_names_(nullptr),
+      arg_axes_(nullptr),
+      batch_tick_(0),
+      batches_start_tick_(0),
+      batches_start_time_(0) {
   BM_CHECK(max_iterations != 0) << "At least one iteration must be run";
   BM_CHECK_LT(thread_index_, threads_)
       << "thread_index must be less than threads";
 
-  // Add counters with correct flag now.  If added with `counters[name]` in
-  // `PauseTiming`, a new `Counter` will be inserted the first time, which
-  // won't have the flag.  Inserting them now also reduces the allocations
-  // during the benchmark.
+  // Resolve the perf counter slots now, so that `PauseTiming` neither
+  // allocates nor looks counters up by name inside the measured region.
   if (perf_counters_measurement_ != nullptr) {
-    for (const std::string& counter_name :
-         perf_counters_measurement_->names()) {
-      counters[counter_name] = Counter(0.0, Counter::kAvgIterations);
-    }
+    perf_counter_values_.assign(perf_counters_measurement_->num_counters(),
+                                0.0);
   }
 
   // Note: The use of offsetof below is technically undefined until C++17
@@ -255,17 +297,9 @@ void State::PauseTiming() {
   BM_CHECK(started_ && !finished_ && !skipped());
   timer_->StopTimer();
   if (perf_counters_measurement_ != nullptr) {
-    std::vector<std::pair<std::string, double>> measurements;
-    if (!perf_counters_measurement_->Stop(measurements)) {
+    if (!perf_counters_measurement_->Stop(perf_counter_values_.data())) {
       BM_CHECK(false) << "Perf counters read the value failed.";
     }
-    for (const auto& name_and_measurement : measurements) {
-      const std::string& name = name_and_measurement.first;
-      const double measurement = name_and_measurement.second;
-      // Counter was inserted with `kAvgIterations` flag by the constructor.
-      assert(counters.find(name) != counters.end());
-      counters[name].value += measurement;
-    }
   }
 }
 
@@ -316,6 +350,90 @@ void State::SetLabel(const std::string& label) {
   manager_->results.report_label_ = label;
 }
 
+CounterHandle State::counter(const CounterId& id, Counter::Flags flags,
+                             Counter::OneK one_k,
+                             Counter::Aggregation aggregation) {
+  const size_t index = id.index();
+  if (index >= counter_slots_.size()) {
+    counter_slots_.resize(index + 1);
+  }
+  Counter& slot = counter_slots_[index];
+  slot.flags = flags;
+  slot.oneK = one_k;
+  slot.aggregation = aggregation;
+  if (std::find(used_counter_slots_.begin(), used_counter_slots_.end(),
+                index) == used_counter_slots_.end()) {
+    used_counter_slots_.push_back(index);
+  }
+  return CounterHandle(&counter_slots_, index);
+}
+
+void State::FoldCounterSlots() {
+  for (size_t index : used_counter_slots_) {
+    const Counter& slot = counter_slots_[index];
+    Counter& counter = counters[internal::CounterName(index)];
+    counter.value += slot.value;
+    counter.flags = slot.flags;
+    counter.oneK = slot.oneK;
+    counter.aggregation = slot.aggregation;
+  }
+  used_counter_slots_.clear();
+  counter_slots_.clear();
+}
+
+std::size_t State::arg_index(const std::string& name) const {
+  if (arg_names_ != nullptr) {
+    for (std::size_t pos = 0; pos < arg_names_->size(); ++pos) {
+      if ((*arg_names_)[pos] == name) {
+        return pos;
+      }
+    }
+  }
+  BM_CHECK(false) << "benchmark '" << name_ << "' has no argument named '"
+                  << name << "'";
+  return 0;
+}
+
+TypedArg State::typed_range(std::size_t pos) const {
+  BM_CHECK_LT(pos, range_.size());
+  static const std::string kUnnamed;
+  const std::string& name = arg_names_ != nullptr && pos < arg_names_->size()
+                                ? (*arg_names_)[pos]
+                                : kUnnamed;
+  if (arg_axes_ != nullptr && pos < arg_axes_->size()) {
+    return (*arg_axes_)[pos].Decode(name, range_[pos]);
+  }
+  return internal::ArgAxis().Decode(name, range_[pos]);
+}
+
+void* State::AllocateBuffer(size_t bytes, const BufferPolicy& policy) {
+  std::string description;
+  // Setup() and Teardown() states have no manager, and a thread index of 0.
+  const int thread_index = manager_ == nullptr
+                               ? internal::kSetupTeardownThreadIndex
+                               : thread_index_;
+  void* data = internal::GetBufferCache().Acquire(
+      name_, thread_index, num_buffers_++, bytes, policy, &description);
+  if (data == nullptr) {
+    SkipWithError("Could not allocate a buffer of " + std::to_string(bytes) +
+                  " bytes");
+    return nullptr;
+  }
+  // Setup() and Teardown() states have no manager to report to.
+  if (manager_ == nullptr) {
+    return data;
+  }
+  MutexLock l(manager_->GetBenchmarkMutex());
+  std::string& policies = manager_->results.buffer_policy_;
+  if (policies.find(description) == std::string::npos) {
+    if (!policies.empty()) {
+      policies += "; ";
+    }
+    policies += description;
+  }
+  return data;
+}
+
 void State::StartKeepRunning() {
   BM_CHECK(!started_ && !finished_);
   started_ = true;
@@ -323,26 +441,136 @@ void State::StartKeepRunning() {
   if (BENCHMARK_BUILTIN_EXPECT(profiler_manager_ != nullptr, false)) {
     profiler_manager_->AfterSetupStart();
   }
+  // Energy is measured for the whole machine, so a single thread takes the
+  // snapshots; this one before the barrier releases the measured region.
+  if (energy_measurement_ != nullptr && thread_index_ == 0 && !skipped()) {
+    energy_measurement_->Start();
+  }
   manager_->StartStopBarrier();
   if (!skipped()) {
     ResumeTiming();
   }
 }
 
+void State::StartBatches() {
+  batches_start_time_ = ChronoClockNow();
+  batch_tick_ = batches_start_tick_ = cycleclock::Now();
+}
+
+void State::NextBatch() {
+  const int64_t now = cycleclock::Now();
+  internal::AddBatchTicks(&batch_histogram_,
+                          static_cast<uint64_t>(now - batch_tick_));
+  batch_tick_ = now;
+}
+
+void State::FinishBatches(IterationCount batch_size) {
+  if (!skipped()) {
+    batch_leftover_ = (max_iterations + batch_size - 1) / batch_size *
+                          batch_size -
+                      max_iterations;
+  }
+  FinishKeepRunning();
+  if (batch_histogram_.empty()) {
+    return;
+  }
+  // The cycle clock need not count cycles, nor at a known rate: calibrate it
+  // against the wall time of the batches.
+  const int64_t ticks = cycleclock::Now() - batches_start_tick_;
+  const double seconds_per_tick =
+      ticks > 0 ? (ChronoClockNow() - batches_start_time_) /
+                      static_cast<double>(ticks)
+                : 0.0;
+  auto batch_counter = [&](double batch_ticks, Counter::Aggregation a) {
+    return Counter(batch_ticks * seconds_per_tick, Counter::kDefaults,
+                   Counter::kIs1000, a);
+  };
+  // Each thread times its own batches: report the mean of their percentiles
+  // and the slowest batch of all.
+  counters["batch_p50"] = batch_counter(
+      internal::BatchTicksPercentile(batch_histogram_, 0.5), Counter::kMean);
+  counters["batch_p90"] = batch_counter(
+      internal::BatchTicksPercentile(batch_histogram_, 0.9), Counter::kMean);
+  counters["batch_p99"] = batch_counter(
+      internal::BatchTicksPercentile(batch_histogram_, 0.99), Counter::kMean);
+  counters["batch_max"] = batch_counter(
+      internal::BatchTicksMax(batch_histogram_), Counter::kMax);
+  batch_histogram_.clear();
+}
+
+void State::RunAsync(int in_flight, const AsyncOperation& operation,
+                     int executor_threads) {
+  // Started and joined outside the measured region, which then only covers
+  // the operations, as 'result.seconds' does.
+  internal::AsyncExecutor executor(executor_threads);
+  StartKeepRunning();
+  internal::AsyncResult result;
+  if (!skipped()) {
+    result = internal::RunAsyncOperations(max_iterations, in_flight, operation,
+                                          executor);
+  }
+  FinishKeepRunning();
+  if (result.completed == 0) {
+    return;
+  }
+  const std::vector<uint64_t>& latencies = result.latency_histogram;
+  auto latency = [&](double q) {
+    return Counter(internal::BatchTicksPercentile(latencies, q) * 1e-9,
+                   Counter::kDefaults, Counter::kIs1000, Counter::kMean);
+  };
+  counters["ops_per_second"] =
+      static_cast<double>(result.completed) / result.seconds;
+  counters["latency_p50"] = latency(0.5);
+  counters["latency_p90"] = latency(0.9);
+  counters["latency_p99"] = latency(0.99);
+  // By Little's law, the mean number of operations in flight.
+  counters["in_flight"] = result.total_latency / result.seconds;
+}
+
 void State::FinishKeepRunning() {
   BM_CHECK(started_ && (!finished_ || skipped()));
   if (!skipped()) {
     PauseTiming();
   }
+  if (perf_counters_measurement_ != nullptr) {
+    const std::vector<std::string>& names = perf_counters_measurement_->names();
+    for (size_t i = 0; i < names.size(); ++i) {
+      Counter& counter = counters[names[i]];
+      counter.value += perf_counter_values_[i];
+      counter.flags = Counter::kAvgIterations;
+      perf_counter_values_[i] = 0.0;
+    }
+  }
   // Total iterations has now wrapped around past 0. Fix this.
   total_iterations_ = 0;
   finished_ = true;
   manager_->StartStopBarrier();
+  // And this one once every thread has left the measured region.
+  if (energy_measurement_ != nullptr && thread_index_ == 0 && !skipped()) {
+    AddEnergyCounters();
+  }
   if (BENCHMARK_BUILTIN_EXPECT(profiler_manager_ != nullptr, false)) {
     profiler_manager_->BeforeTeardownStop();
   }
 }
 
+void State::AddEnergyCounters() {
+  const size_t num_domains = energy_measurement_->num_domains();
+  std::vector<double> joules(num_domains);
+  double seconds = 0;
+  if (!energy_measurement_->Stop(joules.data(), &seconds)) {
+    return;
+  }
+  for (size_t i = 0; i < num_domains; ++i) {
+    const std::string& domain = energy_measurement_->names()[i];
+    // Joules per iteration, and the average power over the measured region.
+    counters["energy_" + domain + "_J"] =
+        Counter(joules[i], Counter::kAvgIterations);
+    counters["power_" + domain + "_W"] =
+        Counter(seconds > 0 ? joules[i] / seconds : 0.0);
+  }
+}
+
 namespace internal {
 namespace {
 
@@ -356,6 +584,9 @@ void FlushStreams(BenchmarkReporter* reporter) {
   std::flush(reporter->GetErrorStream());
 }
 
+// The number of instances generated and run at a time.
+constexpr size_t kInstanceBatchSize = 1 << 14;
+
 // Reports in both display and file reporters.
 void Report(BenchmarkReporter* display_reporter,
             BenchmarkReporter* file_reporter, const RunResults& run_results) {
@@ -383,24 +614,43 @@ void Report(BenchmarkReporter* display_reporter,
   FlushStreams(file_reporter);
 }
 
-void RunBenchmarks(const std::vector<BenchmarkInstance>& benchmarks,
-                   BenchmarkReporter* display_reporter,
-                   BenchmarkReporter* file_reporter) {
+size_t RunBenchmarks(BenchmarkInstanceGenerator* generator,
+                     BenchmarkReporter* display_reporter,
+                     BenchmarkReporter* file_reporter) {
   // Note the file_reporter can be null.
   BM_CHECK(display_reporter != nullptr);
 
+  std::vector<BenchmarkInstance> benchmarks;
+  size_t num_benchmarks = generator->Next(kInstanceBatchSize, &benchmarks);
+  if (num_benchmarks == 0) {
+    return 0;
+  }
+
   // Determine the width of the name field using a minimum width of 10.
   bool might_have_aggregates = FLAGS_benchmark_repetitions > 1;
   size_t name_field_width = 10;
   size_t stat_field_width = 0;
   for (const BenchmarkInstance& benchmark : benchmarks) {
-    name_field_width =
-        std::max<size_t>(name_field_width, benchmark.name().str().size());
+    const std::string name = benchmark.name().str();
+    name_field_width = std::max<size_t>(name_field_width, name.size());
     might_have_aggregates |= benchmark.repetitions() > 1;
 
     for (const auto& Stat : benchmark.statistics()) {
       stat_field_width = std::max<size_t>(stat_field_width, Stat.name_.size());
     }
+    // Room for the "<from>..<to>_cliff" aggregates.
+    if (benchmark.adaptive_budget() > 0) {
+      name_field_width = std::max<size_t>(
+          name_field_width, name.size() + benchmark.name().args.size() + 8);
+    }
+  }
+  // The instances of later batches don't exist yet, bound them instead.
+  if (!generator->Done()) {
+    const BenchmarkInstanceGenerator::Bounds bounds =
+        generator->RemainingBounds();
+    name_field_width = std::max(name_field_width, bounds.name_width);
+    stat_field_width = std::max(stat_field_width, bounds.stat_width);
+    might_have_aggregates |= bounds.might_have_aggregates;
   }
   if (might_have_aggregates) {
     name_field_width += 1 + stat_field_width;
@@ -414,102 +664,255 @@ void RunBenchmarks(const std::vector<BenchmarkInstance>& benchmarks,
   std::map<int /*family_index*/, BenchmarkReporter::PerFamilyRunReports>
       per_family_reports;
 
+  // Reports the complexity of a family whose runs are all done.
+  auto report_complexity = [&](int family_index) {
+    auto it = per_family_reports.find(family_index);
+    if (it == per_family_reports.end()) {
+      return;
+    }
+    RunResults run_results;
+    run_results.aggregates_only = ComputeBigO(it->second.Runs);
+    run_results.display_report_aggregates_only = true;
+    run_results.file_report_aggregates_only = true;
+    per_family_reports.erase(it);
+    Report(display_reporter, file_reporter, run_results);
+  };
+
+  // The exploration of the AdaptiveRange() of each family and thread count.
+  struct AdaptiveRangeState {
+    explicit AdaptiveRangeState(const BenchmarkInstance& instance)
+        : explorer(instance.adaptive_budget()), prototype(instance) {}
+
+    AdaptiveRangeExplorer explorer;
+    BenchmarkInstance prototype;
+    BenchmarkReporter::Run sample;
+  };
+  std::map<std::pair<int /*family_index*/, int /*threads*/>,
+           AdaptiveRangeState>
+      adaptive_ranges;
+  // The next per-family instance index for the points added by them.
+  std::map<int /*family_index*/, int> next_instance_index;
+
   if (display_reporter->ReportContext(context) &&
       ((file_reporter == nullptr) || file_reporter->ReportContext(context))) {
     FlushStreams(display_reporter);
     FlushStreams(file_reporter);
-
-    size_t num_repetitions_total = 0;
+    GetSharedDataCache().SetBudget(
+        static_cast<size_t>(std::max(FLAGS_benchmark_shared_data_budget_mb, 0))
+        << 20);
+    const SharedDataStats shared_data_before = GetSharedDataStats();
 
     // This perfcounters object needs to be created before the runners vector
     // below so it outlasts their lifetime.
     PerfCountersMeasurement perfcounters(
         StrSplit(FLAGS_benchmark_perf_counters, ','));
-
-    // Vector of benchmarks to run
-    std::vector<internal::BenchmarkRunner> runners;
-    runners.reserve(benchmarks.size());
+    EnergyMeasurement energy(FLAGS_benchmark_energy);
 
     // Count the number of benchmarks with threads to warn the user in case
     // performance counters are used.
     int benchmarks_with_threads = 0;
+    bool warned_about_threads = false;
+
+    // The family the last batch ended in, which may continue in the next
+    // one: its complexity can only be computed once it is seen to end.
+    int open_family_index = -1;
+
+    // Runs a batch of instances. The points added by adaptive ranges don't
+    // take part in the complexity of their family.
+    auto run_batch = [&](const std::vector<BenchmarkInstance>& batch,
+                         bool track_complexity) {
+      size_t num_repetitions_total = 0;
+
+      // Vector of benchmarks to run
+      std::vector<internal::BenchmarkRunner> runners;
+      runners.reserve(batch.size());
+
+      // Loop through all benchmarks
+      for (const BenchmarkInstance& benchmark : batch) {
+        BenchmarkReporter::PerFamilyRunReports* reports_for_family = nullptr;
+        if (track_complexity && benchmark.complexity() != oNone) {
+          reports_for_family = &per_family_reports[benchmark.family_index()];
+        }
+        benchmarks_with_threads += static_cast<int>(benchmark.threads() > 1);
+        runners.emplace_back(benchmark, &perfcounters,
+                             energy.num_domains() > 0 ? &energy : nullptr,
+                             reports_for_family);
+        int num_repeats_of_this_instance = runners.back().GetNumRepeats();
+        num_repetitions_total +=
+            static_cast<size_t>(num_repeats_of_this_instance);
+        if (reports_for_family != nullptr) {
+          reports_for_family->num_runs_total += num_repeats_of_this_instance;
+        }
+        int& next_index = next_instance_index[benchmark.family_index()];
+        next_index =
+            std::max(next_index, benchmark.per_family_instance_index() + 1);
+      }
+      assert(runners.size() == batch.size() && "Unexpected runner count.");
+
+      // The use of performance counters with threads would be unintuitive for
+      // the average user so we need to warn them about this case
+      if (!warned_about_threads && (benchmarks_with_threads > 0) &&
+          (perfcounters.num_counters() > 0)) {
+        GetErrorLogInstance()
+            << "***WARNING*** There are " << benchmarks_with_threads
+            << " benchmarks with threads and " << perfcounters.num_counters()
+            << " performance counters were requested. Beware counters will "
+               "reflect the combined usage across all "
+               "threads.\n";
+        warned_about_threads = true;
+      }
 
-    // Loop through all benchmarks
-    for (const BenchmarkInstance& benchmark : benchmarks) {
-      BenchmarkReporter::PerFamilyRunReports* reports_for_family = nullptr;
-      if (benchmark.complexity() != oNone) {
-        reports_for_family = &per_family_reports[benchmark.family_index()];
+      std::vector<size_t> repetition_indices;
+      repetition_indices.reserve(num_repetitions_total);
+      for (size_t runner_index = 0, num_runners = runners.size();
+           runner_index != num_runners; ++runner_index) {
+        const internal::BenchmarkRunner& runner = runners[runner_index];
+        std::fill_n(std::back_inserter(repetition_indices),
+                    runner.GetNumRepeats(), runner_index);
       }
-      benchmarks_with_threads += static_cast<int>(benchmark.threads() > 1);
-      runners.emplace_back(benchmark, &perfcounters, reports_for_family);
-      int num_repeats_of_this_instance = runners.back().GetNumRepeats();
-      num_repetitions_total +=
-          static_cast<size_t>(num_repeats_of_this_instance);
-      if (reports_for_family != nullptr) {
-        reports_for_family->num_runs_total += num_repeats_of_this_instance;
+      assert(repetition_indices.size() == num_repetitions_total &&
+             "Unexpected number of repetition indexes.");
+
+      if (FLAGS_benchmark_enable_random_interleaving) {
+        std::random_device rd;
+        std::mt19937 g(rd());
+        std::shuffle(repetition_indices.begin(), repetition_indices.end(), g);
       }
-    }
-    assert(runners.size() == benchmarks.size() && "Unexpected runner count.");
 
-    // The use of performance counters with threads would be unintuitive for
-    // the average user so we need to warn them about this case
-    if ((benchmarks_with_threads > 0) && (perfcounters.num_counters() > 0)) {
-      GetErrorLogInstance()
-          << "***WARNING*** There are " << benchmarks_with_threads
-          << " benchmarks with threads and " << perfcounters.num_counters()
-          << " performance counters were requested. Beware counters will "
-             "reflect the combined usage across all "
-             "threads.\n";
-    }
+      for (size_t repetition_index : repetition_indices) {
+        internal::BenchmarkRunner& runner = runners[repetition_index];
+        runner.DoOneRepetition();
+        if (runner.HasRepeatsRemaining()) {
+          continue;
+        }
+        // FIXME: report each repetition separately, not all of them in bulk.
 
-    std::vector<size_t> repetition_indices;
-    repetition_indices.reserve(num_repetitions_total);
-    for (size_t runner_index = 0, num_runners = runners.size();
-         runner_index != num_runners; ++runner_index) {
-      const internal::BenchmarkRunner& runner = runners[runner_index];
-      std::fill_n(std::back_inserter(repetition_indices),
-                  runner.GetNumRepeats(), runner_index);
-    }
-    assert(repetition_indices.size() == num_repetitions_total &&
-           "Unexpected number of repetition indexes.");
+        display_reporter->ReportRunsConfig(
+            runner.GetMinTime(), runner.HasExplicitIters(), runner.GetIters());
+        if (file_reporter != nullptr) {
+          file_reporter->ReportRunsConfig(runner.GetMinTime(),
+                                          runner.HasExplicitIters(),
+                                          runner.GetIters());
+        }
 
-    if (FLAGS_benchmark_enable_random_interleaving) {
-      std::random_device rd;
-      std::mt19937 g(rd());
-      std::shuffle(repetition_indices.begin(), repetition_indices.end(), g);
-    }
+        RunResults run_results = runner.GetResults();
+        const BenchmarkInstance& benchmark = batch[repetition_index];
+
+        // Maybe calculate complexity report
+        if (const auto* reports_for_family = runner.GetReportsForFamily()) {
+          const int family_index = benchmark.family_index();
+          if (reports_for_family->num_runs_done ==
+                  reports_for_family->num_runs_total &&
+              family_index != open_family_index) {
+            auto additional_run_stats = ComputeBigO(reports_for_family->Runs);
+            run_results.aggregates_only.insert(
+                run_results.aggregates_only.end(), additional_run_stats.begin(),
+                additional_run_stats.end());
+            per_family_reports.erase(family_index);
+          }
+        }
+
+        // Feed the exploration of the adaptive range.
+        if (benchmark.adaptive_budget() > 0 &&
+            !run_results.non_aggregates.empty()) {
+          auto it = adaptive_ranges
+                        .emplace(std::make_pair(benchmark.family_index(),
+                                                benchmark.threads()),
+                                 AdaptiveRangeState(benchmark))
+                        .first;
+          const int64_t x = benchmark.args().front();
+          it->second.explorer.AddMeasurement(
+              x, TimePerItem(run_results.non_aggregates, x,
+                             benchmark.use_real_time() ||
+                                 benchmark.use_manual_time()));
+          it->second.sample = run_results.non_aggregates.front();
+        }
 
-    for (size_t repetition_index : repetition_indices) {
-      internal::BenchmarkRunner& runner = runners[repetition_index];
-      runner.DoOneRepetition();
-      if (runner.HasRepeatsRemaining()) {
-        continue;
+        Report(display_reporter, file_reporter, run_results);
+      }
+    };
+
+    // Refines the adaptive ranges of the families that are done, then
+    // reports their cliffs.
+    auto explore_adaptive_ranges = [&]() {
+      for (auto it = adaptive_ranges.begin(); it != adaptive_ranges.end();) {
+        if (it->first.first == open_family_index) {
+          ++it;
+          continue;
+        }
+        AdaptiveRangeState& state = it->second;
+        for (std::vector<int64_t> points = state.explorer.NextPoints();
+             !points.empty(); points = state.explorer.NextPoints()) {
+          std::vector<BenchmarkInstance> refinements;
+          for (int64_t x : points) {
+            refinements.push_back(state.prototype.WithArgs(
+                next_instance_index[it->first.first]++, {x}));
+          }
+          num_benchmarks += refinements.size();
+          run_batch(refinements, /*track_complexity=*/false);
+        }
+        RunResults run_results;
+        run_results.aggregates_only =
+            ReportCliffs(state.explorer, state.sample);
+        run_results.display_report_aggregates_only = true;
+        run_results.file_report_aggregates_only = true;
+        Report(display_reporter, file_reporter, run_results);
+        it = adaptive_ranges.erase(it);
       }
-      // FIXME: report each repetition separately, not all of them in bulk.
+    };
 
-      display_reporter->ReportRunsConfig(
-          runner.GetMinTime(), runner.HasExplicitIters(), runner.GetIters());
-      if (file_reporter != nullptr) {
-        file_reporter->ReportRunsConfig(
-            runner.GetMinTime(), runner.HasExplicitIters(), runner.GetIters());
+    // Run the instances a batch at a time.
+    do {
+      if (open_family_index != -1 &&
+          benchmarks.front().family_index() != open_family_index) {
+        report_complexity(open_family_index);
       }
+      open_family_index =
+          generator->Done() ? -1 : benchmarks.back().family_index();
 
-      RunResults run_results = runner.GetResults();
-
-      // Maybe calculate complexity report
-      if (const auto* reports_for_family = runner.GetReportsForFamily()) {
-        if (reports_for_family->num_runs_done ==
-            reports_for_family->num_runs_total) {
-          auto additional_run_stats = ComputeBigO(reports_for_family->Runs);
-          run_results.aggregates_only.insert(run_results.aggregates_only.end(),
-                                             additional_run_stats.begin(),
-                                             additional_run_stats.end());
-          per_family_reports.erase(
-              static_cast<int>(reports_for_family->Runs.front().family_index));
-        }
+      run_batch(benchmarks, /*track_complexity=*/true);
+      explore_adaptive_ranges();
+
+      benchmarks.clear();
+      if (!generator->Done()) {
+        num_benchmarks += generator->Next(kInstanceBatchSize, &benchmarks);
       }
+    } while (!benchmarks.empty());
 
-      Report(display_reporter, file_reporter, run_results);
+    if (open_family_index != -1) {
+      report_complexity(open_family_index);
+      open_family_index = -1;
+      explore_adaptive_ranges();
+    }
+
+    // The State::AllocateBuffer() buffers of the last family.
+    GetBufferCache().Clear();
+
+    const SharedDataStats shared_data = GetSharedDataStats();
+    const int64_t hits = shared_data.hits - shared_data_before.hits;
+    const int64_t misses = shared_data.misses - shared_data_before.misses;
+    if (hits + misses > 0) {
+      GetErrorLogInstance()
+          << "Shared data: " << misses << " datasets built in "
+          << StrFormat("%.3f",
+                       shared_data.build_seconds -
+                           shared_data_before.build_seconds)
+          << " s, " << hits << " of " << hits + misses << " requests hit ("
+          << StrFormat("%.1f", 100.0 * static_cast<double>(hits) /
+                                   static_cast<double>(hits + misses))
+          << "%), "
+          << HumanReadableNumber(static_cast<double>(shared_data.bytes),
+                                 Counter::kIs1024)
+          << "B cached, "
+          << shared_data.evictions - shared_data_before.evictions
+          << " evicted\n";
+    }
+  } else {
+    // Nothing runs, but report how many instances matched.
+    benchmarks.clear();
+    while (!generator->Done()) {
+      num_benchmarks += generator->Next(kInstanceBatchSize, &benchmarks);
+      benchmarks.clear();
     }
   }
   display_reporter->Finalize();
@@ -518,6 +921,7 @@ void RunBenchmarks(const std::vector<BenchmarkInstance>& benchmarks,
   }
   FlushStreams(display_reporter);
   FlushStreams(file_reporter);
+  return num_benchmarks;
 }
 
 // Disable deprecated warnings temporarily because we need to reference
@@ -652,31 +1056,45 @@ size_t RunSpecifiedBenchmarks(BenchmarkReporter* display_reporter,
     file_reporter->SetErrorStream(&output_file);
   }
 
-  std::vector<internal::BenchmarkInstance> benchmarks;
-  if (!FindBenchmarksInternal(spec, &benchmarks, &Err)) {
-    Out.flush();
-    Err.flush();
-    return 0;
-  }
-
-  if (benchmarks.empty()) {
-    Err << "Failed to match any benchmarks against regex: " << spec << "\n";
+  std::string error_msg;
+  std::unique_ptr<internal::BenchmarkFilter> filter =
+      internal::BenchmarkFilter::Create(spec, FLAGS_benchmark_select,
+                                        &error_msg);
+  if (filter == nullptr) {
+    Err << error_msg << '\n';
     Out.flush();
     Err.flush();
     return 0;
   }
+  internal::BenchmarkInstanceGenerator generator(filter.get());
 
+  size_t num_benchmarks = 0;
   if (FLAGS_benchmark_list_tests) {
-    for (auto const& benchmark : benchmarks) {
-      Out << benchmark.name().str() << "\n";
+    std::vector<internal::BenchmarkInstance> benchmarks;
+    while (!generator.Done()) {
+      num_benchmarks +=
+          generator.Next(internal::kInstanceBatchSize, &benchmarks);
+      for (auto const& benchmark : benchmarks) {
+        Out << benchmark.name().str() << "\n";
+      }
+      benchmarks.clear();
     }
   } else {
-    internal::RunBenchmarks(benchmarks, display_reporter, file_reporter);
+    num_benchmarks =
+        internal::RunBenchmarks(&generator, display_reporter, file_reporter);
+  }
+
+  if (num_benchmarks == 0) {
+    Err << "Failed to match any benchmarks against regex: " << spec;
+    if (!FLAGS_benchmark_select.empty()) {
+      Err << " and selection: " << FLAGS_benchmark_select;
+    }
+    Err << "\n";
   }
 
   Out.flush();
   Err.flush();
-  return benchmarks.size();
+  return num_benchmarks;
 }
 
 namespace {
@@ -757,6 +1175,7 @@ void ParseCommandLineFlags(int* argc, char** argv) {
     if (ParseBoolFlag(argv[i], "benchmark_list_tests",
                       &FLAGS_benchmark_list_tests) ||
         ParseStringFlag(argv[i], "benchmark_filter", &FLAGS_benchmark_filter) ||
+        ParseStringFlag(argv[i], "benchmark_select", &FLAGS_benchmark_select) ||
         ParseStringFlag(argv[i], "benchmark_min_time",
                         &FLAGS_benchmark_min_time) ||
         ParseDoubleFlag(argv[i], "benchmark_min_warmup_time",
@@ -779,6 +1198,13 @@ void ParseCommandLineFlags(int* argc, char** argv) {
                       &FLAGS_benchmark_counters_tabular) ||
         ParseStringFlag(argv[i], "benchmark_perf_counters",
                         &FLAGS_benchmark_perf_counters) ||
+        ParseStringFlag(argv[i], "benchmark_profile",
+                        &FLAGS_benchmark_profile) ||
+        ParseBoolFlag(argv[i], "benchmark_profile_memory",
+                      &FLAGS_benchmark_profile_memory) ||
+        ParseBoolFlag(argv[i], "benchmark_energy", &FLAGS_benchmark_energy) ||
+        ParseInt32Flag(argv[i], "benchmark_shared_data_budget_mb",
+                       &FLAGS_benchmark_shared_data_budget_mb) ||
         ParseKeyValueFlag(argv[i], "benchmark_context",
                           &FLAGS_benchmark_context) ||
         ParseStringFlag(argv[i], "benchmark_time_unit",
@@ -877,6 +1303,7 @@ void PrintDefaultHelp() {
           "benchmark"
           " [--benchmark_list_tests={true|false}]\n"
           "          [--benchmark_filter=<regex>]\n"
+          "          [--benchmark_select=<expression>]\n"
           "          [--benchmark_min_time=`<integer>x` OR `<float>s` ]\n"
           "          [--benchmark_min_warmup_time=<min_warmup_time>]\n"
           "          [--benchmark_repetitions=<num_repetitions>]\n"
@@ -889,9 +1316,15 @@ void PrintDefaultHelp() {
           "          [--benchmark_out_format=<json|console|csv>]\n"
           "          [--benchmark_color={auto|true|false}]\n"
           "          [--benchmark_counters_tabular={true|false}]\n"
-#if defined HAVE_LIBPFM
+#if defined HAVE_LIBPFM || defined BENCHMARK_OS_LINUX
           "          [--benchmark_perf_counters=<counter>,...]\n"
 #endif
+#ifdef BENCHMARK_OS_LINUX
+          "          [--benchmark_profile=<dir>]\n"
+          "          [--benchmark_profile_memory={true|false}]\n"
+          "          [--benchmark_energy={true|false}]\n"
+#endif
+          "          [--benchmark_shared_data_budget_mb=<MiB>]\n"
           "          [--benchmark_context=<key>=<value>,...]\n"
           "          [--benchmark_time_unit={ns|us|ms|s}]\n"
           "          [--v=<verbosity>]\n");
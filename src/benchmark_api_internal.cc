@@ -1,21 +1,72 @@
 #include "benchmark_api_internal.h"
 
+#include <algorithm>
 #include <cinttypes>
+#include <cstdlib>
+#include <utility>
 
 #include "string_util.h"
 
 namespace benchmark {
+
+std::string TypedArg::ValueString() const {
+  switch (type) {
+    case kInt:
+      break;
+    case kDouble:
+      // The shortest form that reads back as the same value, so that
+      // distinct values never share an instance name.
+      for (int precision = 6; precision < 17; ++precision) {
+        std::string s = StrFormat("%.*g", precision, double_value);
+        const double parsed = std::strtod(s.c_str(), nullptr);
+        if (!(parsed < double_value) && !(double_value < parsed)) {
+          return s;
+        }
+      }
+      return StrFormat("%.17g", double_value);
+    case kString:
+    case kEnum:
+      return string_value;
+  }
+  return StrFormat("%" PRId64, int_value);
+}
+
 namespace internal {
 
+TypedArg ArgAxis::Decode(const std::string& name, int64_t arg) const {
+  TypedArg typed;
+  typed.name = name;
+  typed.int_value = arg;
+  size_t index = static_cast<size_t>(arg);
+  if (type == TypedArg::kEnum) {
+    index = static_cast<size_t>(std::find(args.begin(), args.end(), arg) -
+                                args.begin());
+  }
+  // Arguments that don't belong to the axis stay integers.
+  const size_t num_values =
+      type == TypedArg::kDouble ? doubles.size() : names.size();
+  if (type == TypedArg::kInt || arg < 0 || index >= num_values) {
+    return typed;
+  }
+  typed.type = type;
+  if (type == TypedArg::kDouble) {
+    typed.double_value = doubles[index];
+  } else {
+    typed.string_value = names[index];
+  }
+  return typed;
+}
+
 BenchmarkInstance::BenchmarkInstance(Benchmark* benchmark, int family_idx,
                                      int per_family_instance_idx,
-                                     const std::vector<int64_t>& args,
+                                     std::vector<int64_t> args,
                                      int thread_count)
-    : benchmark_(*benchmark),
+    : name_(MakeName(*benchmark, args, thread_count)),
+      benchmark_(*benchmark),
       family_index_(family_idx),
       per_family_instance_index_(per_family_instance_idx),
       aggregation_report_mode_(benchmark_.aggregation_report_mode_),
-      args_(args),
+      args_(std::move(args)),
       time_unit_(benchmark_.GetTimeUnit()),
       measure_process_cpu_time_(benchmark_.measure_process_cpu_time_),
       use_real_time_(benchmark_.use_real_time_),
@@ -29,80 +80,131 @@ BenchmarkInstance::BenchmarkInstance(Benchmark* benchmark, int family_idx,
       iterations_(benchmark_.iterations_),
       threads_(thread_count),
       setup_(benchmark_.setup_),
-      teardown_(benchmark_.teardown_) {
-  name_.function_name = benchmark_.name_;
+      teardown_(benchmark_.teardown_) {}
+
+BenchmarkName BenchmarkInstance::MakeName(const Benchmark& benchmark,
+                                          const std::vector<int64_t>& args,
+                                          int thread_count) {
+  BenchmarkName name;
+  name.function_name = benchmark.name_;
 
   size_t arg_i = 0;
   for (const auto& arg : args) {
-    if (!name_.args.empty()) {
-      name_.args += '/';
+    if (!name.args.empty()) {
+      name.args += '/';
     }
 
-    if (arg_i < benchmark->arg_names_.size()) {
-      const auto& arg_name = benchmark_.arg_names_[arg_i];
+    if (arg_i < benchmark.arg_names_.size()) {
+      const auto& arg_name = benchmark.arg_names_[arg_i];
       if (!arg_name.empty()) {
-        name_.args += StrFormat("%s:", arg_name.c_str());
+        name.args += StrFormat("%s:", arg_name.c_str());
       }
     }
 
-    name_.args += StrFormat("%" PRId64, arg);
+    name.args += FormatArg(benchmark, arg_i, arg);
     ++arg_i;
   }
 
-  if (!IsZero(benchmark->min_time_)) {
-    name_.min_time = StrFormat("min_time:%0.3f", benchmark_.min_time_);
+  if (!IsZero(benchmark.min_time_)) {
+    name.min_time = StrFormat("min_time:%0.3f", benchmark.min_time_);
   }
 
-  if (!IsZero(benchmark->min_warmup_time_)) {
-    name_.min_warmup_time =
-        StrFormat("min_warmup_time:%0.3f", benchmark_.min_warmup_time_);
+  if (!IsZero(benchmark.min_warmup_time_)) {
+    name.min_warmup_time =
+        StrFormat("min_warmup_time:%0.3f", benchmark.min_warmup_time_);
   }
 
-  if (benchmark_.iterations_ != 0) {
-    name_.iterations = StrFormat(
-        "iterations:%lu", static_cast<unsigned long>(benchmark_.iterations_));
+  if (benchmark.iterations_ != 0) {
+    name.iterations = StrFormat(
+        "iterations:%lu", static_cast<unsigned long>(benchmark.iterations_));
   }
 
-  if (benchmark_.repetitions_ != 0) {
-    name_.repetitions = StrFormat("repeats:%d", benchmark_.repetitions_);
+  if (benchmark.repetitions_ != 0) {
+    name.repetitions = StrFormat("repeats:%d", benchmark.repetitions_);
   }
 
-  if (benchmark_.measure_process_cpu_time_) {
-    name_.time_type = "process_time";
+  if (benchmark.measure_process_cpu_time_) {
+    name.time_type = "process_time";
   }
 
-  if (benchmark_.use_manual_time_) {
-    if (!name_.time_type.empty()) {
-      name_.time_type += '/';
+  if (benchmark.use_manual_time_) {
+    if (!name.time_type.empty()) {
+      name.time_type += '/';
     }
-    name_.time_type += "manual_time";
-  } else if (benchmark_.use_real_time_) {
-    if (!name_.time_type.empty()) {
-      name_.time_type += '/';
+    name.time_type += "manual_time";
+  } else if (benchmark.use_real_time_) {
+    if (!name.time_type.empty()) {
+      name.time_type += '/';
     }
-    name_.time_type += "real_time";
+    name.time_type += "real_time";
   }
 
-  if (!benchmark_.thread_counts_.empty()) {
-    name_.threads = StrFormat("threads:%d", threads_);
+  if (!benchmark.thread_counts_.empty()) {
+    name.threads = StrFormat("threads:%d", thread_count);
+  }
+  return name;
+}
+
+std::string BenchmarkInstance::FormatArg(const Benchmark& benchmark,
+                                         size_t pos, int64_t arg) {
+  if (pos < benchmark.arg_axes_.size() &&
+      benchmark.arg_axes_[pos].type != TypedArg::kInt) {
+    return benchmark.arg_axes_[pos].Decode("", arg).ValueString();
+  }
+  return StrFormat("%" PRId64, arg);
+}
+
+std::vector<TypedArg> BenchmarkInstance::typed_args() const {
+  std::vector<TypedArg> typed;
+  const auto& axes = benchmark_.arg_axes_;
+  if (std::none_of(axes.begin(), axes.end(), [](const ArgAxis& axis) {
+        return axis.type != TypedArg::kInt;
+      })) {
+    return typed;
+  }
+  const auto& names = benchmark_.arg_names_;
+  for (size_t pos = 0; pos < args_.size(); ++pos) {
+    std::string name = pos < names.size() ? names[pos] : std::string();
+    if (name.empty()) {
+      name = StrFormat("arg%zu", pos);
+    }
+    typed.push_back(pos < axes.size() ? axes[pos].Decode(name, args_[pos])
+                                      : ArgAxis().Decode(name, args_[pos]));
+  }
+  return typed;
+}
+
+std::string BenchmarkInstance::arg_label() const {
+  if (args_.empty()) {
+    return std::string();
   }
+  auto it = benchmark_.working_set_labels_.find(args_.front());
+  return it == benchmark_.working_set_labels_.end() ? std::string()
+                                                    : it->second;
 }
 
 State BenchmarkInstance::Run(
     IterationCount iters, int thread_id, internal::ThreadTimer* timer,
     internal::ThreadManager* manager,
     internal::PerfCountersMeasurement* perf_counters_measurement,
+    internal::EnergyMeasurement* energy_measurement,
     ProfilerManager* profiler_manager) const {
   State st(name_.function_name, iters, args_, thread_id, threads_, timer,
-           manager, perf_counters_measurement, profiler_manager);
+           manager, perf_counters_measurement, energy_measurement,
+           profiler_manager);
+  st.arg_names_ = &benchmark_.arg_names_;
+  st.arg_axes_ = &benchmark_.arg_axes_;
   benchmark_.Run(st);
+  st.FoldCounterSlots();
   return st;
 }
 
 void BenchmarkInstance::Setup() const {
   if (setup_ != nullptr) {
     State st(name_.function_name, /*iters*/ 1, args_, /*thread_id*/ 0, threads_,
-             nullptr, nullptr, nullptr, nullptr);
+             nullptr, nullptr, nullptr, nullptr, nullptr);
+    st.arg_names_ = &benchmark_.arg_names_;
+    st.arg_axes_ = &benchmark_.arg_axes_;
     setup_(st);
   }
 }
@@ -110,7 +212,9 @@ void BenchmarkInstance::Setup() const {
 void BenchmarkInstance::Teardown() const {
   if (teardown_ != nullptr) {
     State st(name_.function_name, /*iters*/ 1, args_, /*thread_id*/ 0, threads_,
-             nullptr, nullptr, nullptr, nullptr);
+             nullptr, nullptr, nullptr, nullptr, nullptr);
+    st.arg_names_ = &benchmark_.arg_names_;
+    st.arg_axes_ = &benchmark_.arg_axes_;
     teardown_(st);
   }
 }
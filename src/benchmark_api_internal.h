@@ -6,6 +6,7 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "benchmark/benchmark.h"
@@ -19,9 +20,27 @@ class BenchmarkInstance {
  public:
   BenchmarkInstance(Benchmark* benchmark, int family_idx,
                     int per_family_instance_idx,
-                    const std::vector<int64_t>& args, int thread_count);
+                    std::vector<int64_t> args, int thread_count);
+
+  // Another instance of the same benchmark and thread count, with 'args'.
+  BenchmarkInstance WithArgs(int per_family_instance_idx,
+                             std::vector<int64_t> args) const {
+    return BenchmarkInstance(&benchmark_, family_index_,
+                             per_family_instance_idx, std::move(args),
+                             threads_);
+  }
+
+  // The name of the instance of 'benchmark' with 'args' and 'thread_count'.
+  static BenchmarkName MakeName(const Benchmark& benchmark,
+                                const std::vector<int64_t>& args,
+                                int thread_count);
+
+  // 'arg' as shown in the names of instances of 'benchmark' at 'pos'.
+  static std::string FormatArg(const Benchmark& benchmark, size_t pos,
+                               int64_t arg);
 
   const BenchmarkName& name() const { return name_; }
+  const std::vector<int64_t>& args() const { return args_; }
   int family_index() const { return family_index_; }
   int per_family_instance_index() const { return per_family_instance_index_; }
   AggregationReportMode aggregation_report_mode() const {
@@ -39,6 +58,11 @@ class BenchmarkInstance {
   double min_warmup_time() const { return min_warmup_time_; }
   IterationCount iterations() const { return iterations_; }
   int threads() const { return threads_; }
+  int adaptive_budget() const { return benchmark_.adaptive_budget_; }
+  // The arguments with their types, empty without typed argument axes.
+  std::vector<TypedArg> typed_args() const;
+  // The report label given to the arguments at registration, if any.
+  std::string arg_label() const;
   void Setup() const;
   void Teardown() const;
   const auto& GetUserThreadRunnerFactory() const {
@@ -48,6 +72,7 @@ class BenchmarkInstance {
   State Run(IterationCount iters, int thread_id, internal::ThreadTimer* timer,
             internal::ThreadManager* manager,
             internal::PerfCountersMeasurement* perf_counters_measurement,
+            internal::EnergyMeasurement* energy_measurement,
             ProfilerManager* profiler_manager) const;
 
  private:
@@ -56,7 +81,7 @@ class BenchmarkInstance {
   const int family_index_;
   const int per_family_instance_index_;
   AggregationReportMode aggregation_report_mode_;
-  const std::vector<int64_t>& args_;
+  std::vector<int64_t> args_;
   TimeUnit time_unit_;
   bool measure_process_cpu_time_;
   bool use_real_time_;
@@ -75,9 +100,53 @@ class BenchmarkInstance {
   callback_function teardown_;
 };
 
-bool FindBenchmarksInternal(const std::string& re,
-                            std::vector<BenchmarkInstance>* benchmarks,
-                            std::ostream* Err);
+class BenchmarkFilter;
+
+// Enumerates the instances of the registered benchmark families that pass a
+// filter, in registration order, a batch at a time. Argument products are
+// decoded one combination at a time (first argument varying fastest, thread
+// counts innermost), and the filter sees the arguments before any name is
+// built, so huge families cost neither memory nor time up front.
+class BENCHMARK_EXPORT BenchmarkInstanceGenerator {
+ public:
+  explicit BenchmarkInstanceGenerator(BenchmarkFilter* filter);
+
+  // Appends up to 'max' further matching instances to 'out' and returns how
+  // many were appended. Fewer than 'max' means the enumeration is done.
+  size_t Next(size_t max, std::vector<BenchmarkInstance>* out);
+
+  bool Done() const { return done_; }
+
+  // Bounds on the report layout of the instances not yet generated.
+  struct Bounds {
+    size_t name_width = 0;
+    size_t stat_width = 0;
+    bool might_have_aggregates = false;
+  };
+  Bounds RemainingBounds() const;
+
+ private:
+  // Moves to the next family that may match; false once there is none left.
+  // Called with the registry locked.
+  bool EnterNextFamily();
+
+  BenchmarkFilter* filter_;
+  bool done_ = false;
+
+  Benchmark* family_ = nullptr;
+  size_t next_family_ = 0;  // Position in the registry.
+  int family_index_ = 0;    // Index reported for 'family_'.
+  int next_family_index_ = 0;
+  int per_family_instance_index_ = 0;
+
+  // Cursor within 'family_': the args_ block, the combination within the
+  // block and the thread count.
+  size_t block_ = 0;
+  size_t combination_ = 0;
+  size_t num_combinations_ = 0;
+  size_t thread_ = 0;
+  std::vector<int64_t> args_;
+};
 
 bool IsZero(double n);
 
@@ -0,0 +1,574 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark_filter.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <utility>
+
+namespace benchmark {
+namespace internal {
+
+struct BenchmarkFilter::Node {
+  enum Kind { kAnd, kOr, kNot, kGlob, kCompare };
+  enum Compare { kEq, kNe, kLt, kLe, kGt, kGe };
+
+  Kind kind;
+  std::unique_ptr<Node> lhs;  // The operand of kNot.
+  std::unique_ptr<Node> rhs;
+  std::string glob;
+  size_t variable = 0;  // Index into BenchmarkFilter::variables_.
+  Compare compare = kEq;
+  // The value compared with, as written and, if it is a number, as one.
+  std::string text;
+  bool is_number = false;
+  bool is_integer = false;
+  int64_t value = 0;
+  double number = 0;
+};
+
+namespace {
+
+using Node = BenchmarkFilter::Node;
+
+// Where a compared name is found in an instance, when not an argument.
+constexpr int kThreadsSlot = -1;
+constexpr int kMissingSlot = -2;
+
+// The result of evaluating a selection before everything it depends on is
+// known, e.g. on the family name alone.
+enum class Tri { kFalse, kTrue, kUnknown };
+
+Tri And(Tri a, Tri b) {
+  if (a == Tri::kFalse || b == Tri::kFalse) return Tri::kFalse;
+  if (a == Tri::kTrue && b == Tri::kTrue) return Tri::kTrue;
+  return Tri::kUnknown;
+}
+
+Tri Or(Tri a, Tri b) {
+  if (a == Tri::kTrue || b == Tri::kTrue) return Tri::kTrue;
+  if (a == Tri::kFalse && b == Tri::kFalse) return Tri::kFalse;
+  return Tri::kUnknown;
+}
+
+Tri Not(Tri a) {
+  if (a == Tri::kUnknown) return a;
+  return a == Tri::kTrue ? Tri::kFalse : Tri::kTrue;
+}
+
+Tri FromBool(bool b) { return b ? Tri::kTrue : Tri::kFalse; }
+
+// Compares by '<' alone, so that doubles need no equality test.
+template <class T>
+bool Compare(Node::Compare compare, T lhs, T rhs) {
+  switch (compare) {
+    case Node::kEq:
+      return !(lhs < rhs) && !(rhs < lhs);
+    case Node::kNe:
+      return lhs < rhs || rhs < lhs;
+    case Node::kLt:
+      return lhs < rhs;
+    case Node::kLe:
+      return !(rhs < lhs);
+    case Node::kGt:
+      return rhs < lhs;
+    case Node::kGe:
+      return !(lhs < rhs);
+  }
+  return false;
+}
+
+// Compares the argument 'arg' with the value of 'node': numbers by value,
+// and the names of string and enum axes as strings, which have no order.
+bool Compare(const Node& node, const TypedArg& arg) {
+  switch (arg.type) {
+    case TypedArg::kInt:
+      if (node.is_integer) {
+        return Compare(node.compare, arg.int_value, node.value);
+      }
+      if (node.is_number) {
+        return Compare(node.compare, static_cast<double>(arg.int_value),
+                       node.number);
+      }
+      break;
+    case TypedArg::kDouble:
+      if (node.is_number) {
+        return Compare(node.compare, arg.double_value, node.number);
+      }
+      break;
+    case TypedArg::kString:
+    case TypedArg::kEnum:
+      if (node.compare == Node::kEq || node.compare == Node::kNe) {
+        return (arg.string_value == node.text) == (node.compare == Node::kEq);
+      }
+      return false;
+  }
+  // A name is never equal to a number.
+  return node.compare == Node::kNe;
+}
+
+// The arguments of an instance, as seen by the comparisons of a selection.
+struct Operands {
+  const std::vector<int>* slots;  // Where each compared name is found.
+  const std::vector<ArgAxis>* axes;
+  const std::vector<int64_t>* args;
+  int threads;
+};
+
+// Evaluates 'node' for the family 'family_name'. Comparisons are unknown
+// when 'operands' is null.
+Tri Evaluate(const Node& node, const std::string& family_name,
+             const Operands* operands) {
+  switch (node.kind) {
+    case Node::kAnd: {
+      const Tri lhs = Evaluate(*node.lhs, family_name, operands);
+      if (lhs == Tri::kFalse) return lhs;
+      return And(lhs, Evaluate(*node.rhs, family_name, operands));
+    }
+    case Node::kOr: {
+      const Tri lhs = Evaluate(*node.lhs, family_name, operands);
+      if (lhs == Tri::kTrue) return lhs;
+      return Or(lhs, Evaluate(*node.rhs, family_name, operands));
+    }
+    case Node::kNot:
+      return Not(Evaluate(*node.lhs, family_name, operands));
+    case Node::kGlob:
+      return FromBool(GlobMatch(node.glob, family_name));
+    case Node::kCompare: {
+      if (operands == nullptr) return Tri::kUnknown;
+      const int slot = (*operands->slots)[node.variable];
+      if (slot == kThreadsSlot) {
+        return FromBool(
+            Compare(node, ArgAxis().Decode(std::string(), operands->threads)));
+      }
+      // Instances without the argument don't match a comparison on it.
+      const size_t pos = static_cast<size_t>(slot);
+      if (slot < 0 || pos >= operands->args->size()) {
+        return Tri::kFalse;
+      }
+      const int64_t arg = (*operands->args)[pos];
+      return FromBool(Compare(
+          node, pos < operands->axes->size()
+                    ? (*operands->axes)[pos].Decode(std::string(), arg)
+                    : ArgAxis().Decode(std::string(), arg)));
+    }
+  }
+  return Tri::kFalse;
+}
+
+struct Token {
+  enum Kind {
+    kEnd,
+    kWord,
+    kQuoted,
+    kLParen,
+    kRParen,
+    kComma,
+    kAnd,
+    kOr,
+    kNot,
+    kExcept,
+    kCompare
+  };
+  Kind kind;
+  std::string text;
+  size_t offset;
+};
+
+bool IsWordChar(char c) {
+  return std::isspace(static_cast<unsigned char>(c)) == 0 &&
+         std::string("()',!=<>&|").find(c) == std::string::npos;
+}
+
+bool Tokenize(const std::string& text, std::vector<Token>* tokens,
+              std::string* error) {
+  size_t i = 0;
+  while (i < text.size()) {
+    const char c = text[i];
+    const size_t start = i;
+    if (std::isspace(static_cast<unsigned char>(c)) != 0) {
+      ++i;
+      continue;
+    }
+    auto starts_with = [&](const char* op) {
+      return text.compare(i, std::char_traits<char>::length(op), op) == 0;
+    };
+    if (c == '(' || c == ')' || c == ',') {
+      tokens->push_back({c == '(' ? Token::kLParen
+                         : c == ')' ? Token::kRParen
+                                    : Token::kComma,
+                         std::string(1, c), start});
+      ++i;
+    } else if (starts_with("&&") || starts_with("||")) {
+      tokens->push_back({c == '&' ? Token::kAnd : Token::kOr,
+                         text.substr(i, 2), start});
+      i += 2;
+    } else if (starts_with("==") || starts_with("!=") || starts_with("<=") ||
+               starts_with(">=")) {
+      tokens->push_back({Token::kCompare, text.substr(i, 2), start});
+      i += 2;
+    } else if (c == '<' || c == '>' || c == '=') {
+      tokens->push_back({Token::kCompare, c == '=' ? "==" : std::string(1, c),
+                         start});
+      ++i;
+    } else if (c == '!') {
+      tokens->push_back({Token::kNot, "!", start});
+      ++i;
+    } else if (c == '\'') {
+      const size_t end = text.find('\'', i + 1);
+      if (end == std::string::npos) {
+        *error = "unterminated quote at offset " + std::to_string(start);
+        return false;
+      }
+      tokens->push_back(
+          {Token::kQuoted, text.substr(i + 1, end - i - 1), start});
+      i = end + 1;
+    } else if (IsWordChar(c)) {
+      while (i < text.size() && IsWordChar(text[i])) {
+        ++i;
+      }
+      std::string word = text.substr(start, i - start);
+      Token::Kind kind = Token::kWord;
+      if (word == "and") {
+        kind = Token::kAnd;
+      } else if (word == "or") {
+        kind = Token::kOr;
+      } else if (word == "not") {
+        kind = Token::kNot;
+      } else if (word == "except") {
+        kind = Token::kExcept;
+      }
+      tokens->push_back({kind, std::move(word), start});
+    } else {
+      *error = std::string("unexpected '") + c + "' at offset " +
+               std::to_string(start);
+      return false;
+    }
+  }
+  tokens->push_back({Token::kEnd, "", text.size()});
+  return true;
+}
+
+bool IsIdentifier(const std::string& word) {
+  if (word.empty() ||
+      (std::isalpha(static_cast<unsigned char>(word[0])) == 0 &&
+       word[0] != '_')) {
+    return false;
+  }
+  for (char c : word) {
+    if (std::isalnum(static_cast<unsigned char>(c)) == 0 && c != '_') {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Recursive descent parser of the selection grammar:
+//
+//   selection := [expression] ['except' glob {',' glob}]
+//   expression := conjunction {('||' | 'or') conjunction}
+//   conjunction := unary {('&&' | 'and') unary}
+//   unary := ('!' | 'not') unary | '(' expression ')' | comparison | glob
+//   comparison := name ('==' | '=' | '!=') value
+//               | name ('<' | '<=' | '>' | '>=') number
+//   value := number | name | "'" any characters "'"
+//   glob := word | "'" any characters "'"
+class Parser {
+ public:
+  Parser(std::vector<Token> tokens, std::vector<std::string>* variables)
+      : tokens_(std::move(tokens)), variables_(variables) {}
+
+  bool ParseSelection(std::unique_ptr<Node>* select,
+                      std::vector<std::string>* excluded) {
+    if (Peek().kind != Token::kExcept && Peek().kind != Token::kEnd) {
+      *select = ParseExpression();
+      if (*select == nullptr) return false;
+    }
+    if (Peek().kind == Token::kExcept) {
+      Take();
+      for (;;) {
+        const Token& glob = Take();
+        if (glob.kind != Token::kWord && glob.kind != Token::kQuoted) {
+          return Fail(glob, "expected a family name after 'except'");
+        }
+        excluded->push_back(glob.text);
+        if (Peek().kind != Token::kComma) break;
+        Take();
+      }
+    }
+    if (Peek().kind != Token::kEnd) {
+      return Fail(Peek(), "unexpected '" + Peek().text + "'");
+    }
+    return true;
+  }
+
+  const std::string& error() const { return error_; }
+
+ private:
+  const Token& Peek() const { return tokens_[pos_]; }
+  const Token& Take() {
+    const Token& token = tokens_[pos_];
+    if (token.kind != Token::kEnd) ++pos_;
+    return token;
+  }
+
+  bool Fail(const Token& token, const std::string& what) {
+    if (error_.empty()) {
+      error_ = what + " at offset " + std::to_string(token.offset);
+    }
+    return false;
+  }
+
+  std::unique_ptr<Node> MakeBinary(Node::Kind kind, std::unique_ptr<Node> lhs,
+                                   std::unique_ptr<Node> rhs) {
+    std::unique_ptr<Node> node(new Node());
+    node->kind = kind;
+    node->lhs = std::move(lhs);
+    node->rhs = std::move(rhs);
+    return node;
+  }
+
+  std::unique_ptr<Node> ParseExpression() {
+    std::unique_ptr<Node> lhs = ParseConjunction();
+    while (lhs != nullptr && Peek().kind == Token::kOr) {
+      Take();
+      std::unique_ptr<Node> rhs = ParseConjunction();
+      if (rhs == nullptr) return nullptr;
+      lhs = MakeBinary(Node::kOr, std::move(lhs), std::move(rhs));
+    }
+    return lhs;
+  }
+
+  std::unique_ptr<Node> ParseConjunction() {
+    std::unique_ptr<Node> lhs = ParseUnary();
+    while (lhs != nullptr && Peek().kind == Token::kAnd) {
+      Take();
+      std::unique_ptr<Node> rhs = ParseUnary();
+      if (rhs == nullptr) return nullptr;
+      lhs = MakeBinary(Node::kAnd, std::move(lhs), std::move(rhs));
+    }
+    return lhs;
+  }
+
+  std::unique_ptr<Node> ParseUnary() {
+    const Token& token = Take();
+    switch (token.kind) {
+      case Token::kNot: {
+        std::unique_ptr<Node> operand = ParseUnary();
+        if (operand == nullptr) return nullptr;
+        return MakeBinary(Node::kNot, std::move(operand), nullptr);
+      }
+      case Token::kLParen: {
+        std::unique_ptr<Node> inner = ParseExpression();
+        if (inner == nullptr) return nullptr;
+        if (Take().kind != Token::kRParen) {
+          Fail(token, "unbalanced '('");
+          return nullptr;
+        }
+        return inner;
+      }
+      case Token::kWord:
+        if (Peek().kind == Token::kCompare) {
+          return ParseComparison(token);
+        }
+        [[fallthrough]];
+      case Token::kQuoted: {
+        std::unique_ptr<Node> node(new Node());
+        node->kind = Node::kGlob;
+        node->glob = token.text;
+        return node;
+      }
+      default:
+        Fail(token, token.kind == Token::kEnd
+                        ? std::string("unexpected end")
+                        : "unexpected '" + token.text + "'");
+        return nullptr;
+    }
+  }
+
+  std::unique_ptr<Node> ParseComparison(const Token& name) {
+    if (!IsIdentifier(name.text)) {
+      Fail(name, "'" + name.text + "' is not an argument name");
+      return nullptr;
+    }
+    const Token& op = Take();
+    const Token& value = Take();
+    std::unique_ptr<Node> node(new Node());
+    node->kind = Node::kCompare;
+    static const std::pair<const char*, Node::Compare> kOps[] = {
+        {"==", Node::kEq}, {"!=", Node::kNe}, {"<", Node::kLt},
+        {"<=", Node::kLe}, {">", Node::kGt},  {">=", Node::kGe}};
+    for (const auto& entry : kOps) {
+      if (op.text == entry.first) node->compare = entry.second;
+    }
+    node->text = value.text;
+    if (value.kind == Token::kWord && !value.text.empty()) {
+      errno = 0;
+      char* end = nullptr;
+      node->value = std::strtoll(value.text.c_str(), &end, 10);
+      node->is_integer = *end == '\0' && errno == 0;
+      errno = 0;
+      node->number = std::strtod(value.text.c_str(), &end);
+      node->is_number = *end == '\0' && errno == 0;
+    }
+    const bool ordered = node->compare != Node::kEq &&
+                         node->compare != Node::kNe;
+    if (ordered && !node->is_number) {
+      Fail(value, "expected a number after '" + op.text + "'");
+      return nullptr;
+    }
+    if (!node->is_number && value.kind != Token::kQuoted &&
+        !IsIdentifier(value.text)) {
+      Fail(value, "expected a number or a name after '" + op.text + "'");
+      return nullptr;
+    }
+    for (node->variable = 0; node->variable < variables_->size();
+         ++node->variable) {
+      if ((*variables_)[node->variable] == name.text) break;
+    }
+    if (node->variable == variables_->size()) {
+      variables_->push_back(name.text);
+    }
+    return node;
+  }
+
+  std::vector<Token> tokens_;
+  size_t pos_ = 0;
+  std::vector<std::string>* variables_;
+  std::string error_;
+};
+
+}  // namespace
+
+bool GlobMatch(const std::string& pattern, const std::string& str) {
+  size_t p = 0;
+  size_t s = 0;
+  // Where to resume after the last '*' when the rest fails to match.
+  size_t star = std::string::npos;
+  size_t star_s = 0;
+  while (s < str.size()) {
+    if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == str[s])) {
+      ++p;
+      ++s;
+    } else if (p < pattern.size() && pattern[p] == '*') {
+      star = p++;
+      star_s = s;
+    } else if (star != std::string::npos) {
+      p = star + 1;
+      s = ++star_s;
+    } else {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*') {
+    ++p;
+  }
+  return p == pattern.size();
+}
+
+BenchmarkFilter::BenchmarkFilter() = default;
+BenchmarkFilter::~BenchmarkFilter() = default;
+
+std::unique_ptr<BenchmarkFilter> BenchmarkFilter::Create(
+    const std::string& spec, const std::string& select, std::string* error) {
+  std::unique_ptr<BenchmarkFilter> filter(new BenchmarkFilter());
+  std::string pattern = spec;
+  if (pattern.empty() || pattern == "all") {
+    pattern = ".";
+  }
+  if (pattern[0] == '-') {
+    pattern.erase(0, 1);
+    filter->negative_ = true;
+  }
+  std::string re_error;
+  if (!filter->re_.Init(pattern, &re_error)) {
+    *error = "Could not compile benchmark re: " + re_error;
+    return nullptr;
+  }
+  // "." matches every (non-empty) name, don't bother the regex engine.
+  filter->match_all_ = pattern == "." && !filter->negative_;
+
+  std::vector<Token> tokens;
+  std::string select_error;
+  if (!Tokenize(select, &tokens, &select_error)) {
+    *error = "Could not parse benchmark selection: " + select_error;
+    return nullptr;
+  }
+  Parser parser(std::move(tokens), &filter->variables_);
+  if (!parser.ParseSelection(&filter->select_, &filter->excluded_)) {
+    *error = "Could not parse benchmark selection: " + parser.error();
+    return nullptr;
+  }
+  return filter;
+}
+
+bool BenchmarkFilter::MatchesFamily(const std::string& family_name) const {
+  for (const std::string& excluded : excluded_) {
+    if (GlobMatch(excluded, family_name)) {
+      return false;
+    }
+  }
+  // Comparisons are undecided, but globs on the family name may already
+  // rule the whole family out.
+  return select_ == nullptr ||
+         Evaluate(*select_, family_name, nullptr) != Tri::kFalse;
+}
+
+bool BenchmarkFilter::MatchesArgs(const Benchmark& family,
+                                  const std::vector<int64_t>& args,
+                                  int threads) {
+  if (select_ == nullptr) {
+    return true;
+  }
+  // Look the compared names up once per family.
+  if (&family != resolved_family_) {
+    resolved_family_ = &family;
+    slots_.assign(variables_.size(), kMissingSlot);
+    for (size_t i = 0; i < variables_.size(); ++i) {
+      const std::string& variable = variables_[i];
+      const auto& arg_names = family.arg_names_;
+      for (size_t arg = 0; arg < arg_names.size(); ++arg) {
+        if (arg_names[arg] == variable) {
+          slots_[i] = static_cast<int>(arg);
+          break;
+        }
+      }
+      if (slots_[i] != kMissingSlot) {
+        continue;
+      }
+      if (variable == "threads") {
+        slots_[i] = kThreadsSlot;
+      } else if (variable.size() > 3 && variable.size() <= 12 &&
+                 variable.compare(0, 3, "arg") == 0 &&
+                 variable.find_first_not_of("0123456789", 3) ==
+                     std::string::npos) {
+        slots_[i] = std::atoi(variable.c_str() + 3);
+      }
+    }
+  }
+  const Operands operands = {&slots_, &family.arg_axes_, &args, threads};
+  return Evaluate(*select_, family.name_, &operands) == Tri::kTrue;
+}
+
+bool BenchmarkFilter::MatchesName(const std::string& full_name) {
+  if (match_all_) {
+    return true;
+  }
+  return re_.Match(full_name) != negative_;
+}
+
+}  // namespace internal
+}  // namespace benchmark
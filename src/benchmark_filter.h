@@ -0,0 +1,96 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCHMARK_FILTER_H_
+#define BENCHMARK_FILTER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "re.h"
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+// C4251: <symbol> needs to have dll-interface to be used by clients of class
+#pragma warning(disable : 4251)
+#endif
+
+namespace benchmark {
+namespace internal {
+
+// Returns whether 'str' matches the shell-style 'pattern', in which '*'
+// matches any sequence of characters and '?' any single character.
+BENCHMARK_EXPORT bool GlobMatch(const std::string& pattern,
+                                const std::string& str);
+
+// Decides which benchmark instances run, as selected by --benchmark_filter
+// (a regular expression on the full name) and --benchmark_select (a
+// structured expression on the family name, the arguments and the thread
+// count, e.g. "BM_Copy* && size>=4096 except BM_CopySlow").
+//
+// The checks are staged so that instances can be rejected as early as
+// possible while they are generated: first on the family name, then on the
+// structured arguments and thread count, and only then on the full name,
+// which is the only stage that needs the name to be built.
+class BENCHMARK_EXPORT BenchmarkFilter {
+ public:
+  ~BenchmarkFilter();
+
+  // Compiles 'spec' and 'select', either of which may be empty to select
+  // everything. Returns null and sets 'error' if either is not valid.
+  static std::unique_ptr<BenchmarkFilter> Create(const std::string& spec,
+                                                 const std::string& select,
+                                                 std::string* error);
+
+  // Whether any instance of the family named 'family_name' may match.
+  bool MatchesFamily(const std::string& family_name) const;
+
+  // Whether the instance of 'family' with 'args' and 'threads' may match.
+  bool MatchesArgs(const Benchmark& family, const std::vector<int64_t>& args,
+                   int threads);
+
+  // Whether the instance named 'full_name' matches.
+  bool MatchesName(const std::string& full_name);
+
+  // A node of the compiled selection.
+  struct Node;
+
+ private:
+  BenchmarkFilter();
+
+  Regex re_;
+  bool negative_ = false;
+  bool match_all_ = false;
+
+  // The compiled --benchmark_select expression, null when it is empty.
+  std::unique_ptr<Node> select_;
+  std::vector<std::string> excluded_;
+  // The names compared in 'select_', and where to find them in the instances
+  // of 'resolved_family_': an argument index, or one of the slots below.
+  std::vector<std::string> variables_;
+  const Benchmark* resolved_family_ = nullptr;
+  std::vector<int> slots_;
+};
+
+}  // namespace internal
+}  // namespace benchmark
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif  // BENCHMARK_FILTER_H_
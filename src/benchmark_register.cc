@@ -31,13 +31,16 @@
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <numeric>
 #include <sstream>
 #include <thread>
 
+#include "adaptive_range.h"
 #include "benchmark/benchmark.h"
 #include "benchmark_api_internal.h"
+#include "benchmark_filter.h"
 #include "check.h"
 #include "commandlineflags.h"
 #include "complexity.h"
@@ -55,10 +58,6 @@ namespace {
 // For non-dense Range, intermediate values are powers of kRangeMultiplier.
 constexpr int kRangeMultiplier = 8;
 
-// The size of a benchmark family determines is the number of inputs to repeat
-// the benchmark on. If this is "large" then warn the user during configuration.
-constexpr size_t kMaxFamilySize = 100;
-
 constexpr char kDisabledPrefix[] = "DISABLED_";
 }  // end namespace
 
@@ -80,13 +79,9 @@ class BenchmarkFamilies {
   // Clear all registered benchmark families.
   void ClearBenchmarks();
 
-  // Extract the list of benchmark instances that match the specified
-  // regular expression.
-  bool FindBenchmarks(std::string spec,
-                      std::vector<BenchmarkInstance>* benchmarks,
-                      std::ostream* Err);
-
  private:
+  friend class BenchmarkInstanceGenerator;
+
   BenchmarkFamilies() {}
 
   std::vector<std::unique_ptr<Benchmark>> families_;
@@ -111,84 +106,144 @@ void BenchmarkFamilies::ClearBenchmarks() {
   families_.shrink_to_fit();
 }
 
-bool BenchmarkFamilies::FindBenchmarks(
-    std::string spec, std::vector<BenchmarkInstance>* benchmarks,
-    std::ostream* ErrStream) {
-  BM_CHECK(ErrStream);
-  auto& Err = *ErrStream;
-  // Make regular expression out of command-line flag
-  std::string error_msg;
-  Regex re;
-  bool is_negative_filter = false;
-  if (spec[0] == '-') {
-    spec.replace(0, 1, "");
-    is_negative_filter = true;
-  }
-  if (!re.Init(spec, &error_msg)) {
-    Err << "Could not compile benchmark re: " << error_msg << '\n';
-    return false;
-  }
-
-  // Special list of thread counts to use when none are specified
-  const std::vector<int> one_thread = {1};
-
-  int next_family_index = 0;
+//=============================================================================//
+//                         BenchmarkInstanceGenerator
+//=============================================================================//
 
-  MutexLock l(mutex_);
-  for (std::unique_ptr<Benchmark>& family : families_) {
-    int family_index = next_family_index;
-    int per_family_instance_index = 0;
+BenchmarkInstanceGenerator::BenchmarkInstanceGenerator(BenchmarkFilter* filter)
+    : filter_(filter) {
+  BM_CHECK(filter_ != nullptr);
+}
 
-    // Family was deleted or benchmark doesn't match
-    if (!family) {
+bool BenchmarkInstanceGenerator::EnterNextFamily() {
+  const auto& families = BenchmarkFamilies::GetInstance()->families_;
+  while (next_family_ < families.size()) {
+    Benchmark* family = families[next_family_++].get();
+    // Family was deleted, is disabled or doesn't match
+    if (family == nullptr || family->name_.rfind(kDisabledPrefix, 0) == 0 ||
+        !filter_->MatchesFamily(family->name_)) {
       continue;
     }
-
     if (family->ArgsCnt() == -1) {
       family->Args({});
     }
-    const std::vector<int>* thread_counts =
-        (family->thread_counts_.empty()
-             ? &one_thread
-             : &static_cast<const std::vector<int>&>(family->thread_counts_));
-    const size_t family_size = family->args_.size() * thread_counts->size();
-    // The benchmark will be run at least 'family_size' different inputs.
-    // If 'family_size' is very large warn the user.
-    if (family_size > kMaxFamilySize) {
-      Err << "The number of inputs is very large. " << family->name_
-          << " will be repeated at least " << family_size << " times.\n";
+    if (family->args_.empty()) {
+      continue;
     }
-    // reserve in the special case the regex ".", since we know the final
-    // family size.  this doesn't take into account any disabled benchmarks
-    // so worst case we reserve more than we need.
-    if (spec == ".") {
-      benchmarks->reserve(benchmarks->size() + family_size);
+    family_ = family;
+    family_index_ = next_family_index_;
+    per_family_instance_index_ = 0;
+    block_ = 0;
+    combination_ = 0;
+    num_combinations_ = NumArgCombinations(family->args_.front());
+    thread_ = 0;
+    return true;
+  }
+  family_ = nullptr;
+  return false;
+}
+
+size_t BenchmarkInstanceGenerator::Next(size_t max,
+                                        std::vector<BenchmarkInstance>* out) {
+  // Special list of thread counts to use when none are specified
+  static const std::vector<int> one_thread = {1};
+
+  BenchmarkFamilies* registry = BenchmarkFamilies::GetInstance();
+  MutexLock l(registry->mutex_);
+  size_t appended = 0;
+  while (appended < max && !done_) {
+    if (family_ == nullptr && !EnterNextFamily()) {
+      done_ = true;
+      break;
+    }
+    const std::vector<int>& thread_counts =
+        family_->thread_counts_.empty() ? one_thread : family_->thread_counts_;
+
+    // Decode the combination, the first argument varying fastest.
+    if (thread_ == 0) {
+      const auto& arglists = family_->args_[block_];
+      args_.resize(arglists.size());
+      size_t rest = combination_;
+      for (size_t arg = 0; arg < arglists.size(); ++arg) {
+        args_[arg] = arglists[arg][rest % arglists[arg].size()];
+        rest /= arglists[arg].size();
+      }
+    }
+    const int num_threads = thread_counts[thread_];
+
+    if (filter_->MatchesArgs(*family_, args_, num_threads) &&
+        filter_->MatchesName(
+            BenchmarkInstance::MakeName(*family_, args_, num_threads).str())) {
+      out->emplace_back(family_, family_index_, per_family_instance_index_,
+                        args_, num_threads);
+      ++appended;
+      ++per_family_instance_index_;
+
+      // Only bump the next family index once we've estabilished that
+      // at least one instance of this family will be run.
+      if (next_family_index_ == family_index_) {
+        ++next_family_index_;
+      }
     }
 
-    for (auto const& args : family->args_) {
-      for (int num_threads : *thread_counts) {
-        BenchmarkInstance instance(family.get(), family_index,
-                                   per_family_instance_index, args,
-                                   num_threads);
-
-        const auto full_name = instance.name().str();
-        if (full_name.rfind(kDisabledPrefix, 0) != 0 &&
-            ((re.Match(full_name) && !is_negative_filter) ||
-             (!re.Match(full_name) && is_negative_filter))) {
-          benchmarks->push_back(std::move(instance));
-
-          ++per_family_instance_index;
-
-          // Only bump the next family index once we've estabilished that
-          // at least one instance of this family will be run.
-          if (next_family_index == family_index) {
-            ++next_family_index;
-          }
-        }
+    // Advance the cursor.
+    if (++thread_ < thread_counts.size()) {
+      continue;
+    }
+    thread_ = 0;
+    if (++combination_ < num_combinations_) {
+      continue;
+    }
+    combination_ = 0;
+    if (++block_ < family_->args_.size()) {
+      num_combinations_ = NumArgCombinations(family_->args_[block_]);
+      continue;
+    }
+    family_ = nullptr;
+  }
+  return appended;
+}
+
+BenchmarkInstanceGenerator::Bounds
+BenchmarkInstanceGenerator::RemainingBounds() const {
+  Bounds bounds;
+  BenchmarkFamilies* registry = BenchmarkFamilies::GetInstance();
+  MutexLock l(registry->mutex_);
+  const auto& families = registry->families_;
+  // The current family, if any, was already taken from the registry.
+  const size_t first = family_ != nullptr ? next_family_ - 1 : next_family_;
+  for (size_t i = first; !done_ && i < families.size(); ++i) {
+    const Benchmark* family = families[i].get();
+    if (family == nullptr || family->name_.rfind(kDisabledPrefix, 0) == 0 ||
+        !filter_->MatchesFamily(family->name_)) {
+      continue;
+    }
+    // The widest name takes the widest value at each argument position and
+    // the widest thread count.
+    int threads = 1;
+    for (int num_threads : family->thread_counts_) {
+      threads = std::max(threads, num_threads);
+    }
+    for (const auto& arglists : family->args_) {
+      std::vector<int64_t> widest;
+      for (const auto& arglist : arglists) {
+        const size_t pos = widest.size();
+        widest.push_back(*std::max_element(
+            arglist.begin(), arglist.end(), [&](int64_t a, int64_t b) {
+              return BenchmarkInstance::FormatArg(*family, pos, a).size() <
+                     BenchmarkInstance::FormatArg(*family, pos, b).size();
+            }));
       }
+      bounds.name_width = std::max(
+          bounds.name_width,
+          BenchmarkInstance::MakeName(*family, widest, threads).str().size());
+    }
+    bounds.might_have_aggregates |= family->repetitions_ > 1;
+    for (const auto& stat : family->statistics_) {
+      bounds.stat_width = std::max(bounds.stat_width, stat.name_.size());
     }
   }
-  return true;
+  return bounds;
 }
 
 Benchmark* RegisterBenchmarkInternal(std::unique_ptr<Benchmark> bench) {
@@ -198,12 +253,51 @@ Benchmark* RegisterBenchmarkInternal(std::unique_ptr<Benchmark> bench) {
   return bench_ptr;
 }
 
-// FIXME: This function is a hack so that benchmark.cc can access
-// `BenchmarkFamilies`
-bool FindBenchmarksInternal(const std::string& re,
-                            std::vector<BenchmarkInstance>* benchmarks,
-                            std::ostream* Err) {
-  return BenchmarkFamilies::GetInstance()->FindBenchmarks(re, benchmarks, Err);
+std::vector<std::pair<int64_t, std::string>> WorkingSetPoints(
+    const std::vector<CPUInfo::CacheInfo>& caches, int64_t bytes_per_arg) {
+  BM_CHECK_GT(bytes_per_arg, 0);
+  // The size of each level of data cache.
+  std::map<int, int64_t> levels;
+  for (const CPUInfo::CacheInfo& cache : caches) {
+    if (cache.type == "Instruction" || cache.size <= 0) {
+      continue;
+    }
+    int64_t& size = levels[cache.level];
+    size = std::max<int64_t>(size, cache.size);
+  }
+  if (levels.empty()) {
+    // Without cache information, assume a common hierarchy.
+    levels = {{1, int64_t{32} << 10}, {2, int64_t{1} << 20},
+              {3, int64_t{32} << 20}};
+  }
+
+  std::vector<int64_t> sizes;
+  for (const auto& level : levels) {
+    sizes.push_back(level.second / 2);
+    sizes.push_back(level.second * 9 / 10);
+    sizes.push_back(level.second * 3 / 2);
+  }
+  const int64_t last_level = levels.rbegin()->second;
+  sizes.push_back(4 * last_level);
+  sizes.push_back(16 * last_level);
+  std::sort(sizes.begin(), sizes.end());
+
+  std::vector<std::pair<int64_t, std::string>> points;
+  for (int64_t size : sizes) {
+    const int64_t arg = std::max<int64_t>(1, size / bytes_per_arg);
+    if (!points.empty() && points.back().first == arg) {
+      continue;
+    }
+    std::string label = "DRAM";
+    for (const auto& level : levels) {
+      if (size <= level.second) {
+        label = "L" + std::to_string(level.first);
+        break;
+      }
+    }
+    points.emplace_back(arg, std::move(label));
+  }
+  return points;
 }
 
 //=============================================================================//
@@ -216,6 +310,7 @@ Benchmark::Benchmark(const std::string& name)
       time_unit_(GetDefaultTimeUnit()),
       use_default_time_unit_(true),
       range_multiplier_(kRangeMultiplier),
+      adaptive_budget_(0),
       min_time_(0),
       min_warmup_time_(0),
       iterations_(0),
@@ -240,7 +335,7 @@ Benchmark* Benchmark::Name(const std::string& name) {
 
 Benchmark* Benchmark::Arg(int64_t x) {
   BM_CHECK(ArgsCnt() == -1 || ArgsCnt() == 1);
-  args_.push_back({x});
+  args_.push_back({{x}});
   return this;
 }
 
@@ -255,9 +350,7 @@ Benchmark* Benchmark::Range(int64_t start, int64_t limit) {
   std::vector<int64_t> arglist;
   AddRange(&arglist, start, limit, range_multiplier_);
 
-  for (int64_t i : arglist) {
-    args_.push_back({i});
-  }
+  args_.push_back({std::move(arglist)});
   return this;
 }
 
@@ -279,27 +372,80 @@ Benchmark* Benchmark::ArgsProduct(
     const std::vector<std::vector<int64_t>>& arglists) {
   BM_CHECK(ArgsCnt() == -1 || ArgsCnt() == static_cast<int>(arglists.size()));
 
-  std::vector<std::size_t> indices(arglists.size());
-  const std::size_t total = std::accumulate(
-      std::begin(arglists), std::end(arglists), std::size_t{1},
-      [](const std::size_t res, const std::vector<int64_t>& arglist) {
-        return res * arglist.size();
-      });
-  std::vector<int64_t> args;
-  args.reserve(arglists.size());
-  for (std::size_t i = 0; i < total; i++) {
-    for (std::size_t arg = 0; arg < arglists.size(); arg++) {
-      args.push_back(arglists[arg][indices[arg]]);
-    }
-    args_.push_back(args);
-    args.clear();
+  // Kept as is: the combinations are enumerated lazily by
+  // BenchmarkInstanceGenerator, with the first argument varying fastest.
+  if (NumArgCombinations(arglists) != 0) {
+    args_.push_back(arglists);
+  }
+  return this;
+}
 
-    std::size_t arg = 0;
-    do {
-      indices[arg] = (indices[arg] + 1) % arglists[arg].size();
-    } while (indices[arg++] == 0 && arg < arglists.size());
+Benchmark* Benchmark::AdaptiveRange(int64_t lo, int64_t hi, int budget) {
+  BM_CHECK(ArgsCnt() == -1 || ArgsCnt() == 1);
+  BM_CHECK_LE(lo, hi);
+  BM_CHECK_GE(budget, 2);
+  BM_CHECK_EQ(adaptive_budget_, 0) << "Only one AdaptiveRange per benchmark";
+  adaptive_budget_ = budget;
+  // Only the coarse grid is known up front, the rest is added while running.
+  args_.push_back({AdaptiveRangeExplorer::InitialPoints(lo, hi, budget,
+                                                        range_multiplier_)});
+  return this;
+}
+
+Benchmark* Benchmark::WorkingSetSweep(int64_t bytes_per_arg) {
+  BM_CHECK(ArgsCnt() == -1 || ArgsCnt() == 1);
+  std::vector<int64_t> arglist;
+  for (const auto& point :
+       WorkingSetPoints(CPUInfo::Get().caches, bytes_per_arg)) {
+    arglist.push_back(point.first);
+    working_set_labels_[point.first] = point.second;
   }
+  args_.push_back({std::move(arglist)});
+  return this;
+}
 
+Benchmark* Benchmark::DoubleAxis(const std::string& name,
+                                 const std::vector<double>& values) {
+  ArgAxis axis;
+  axis.type = TypedArg::kDouble;
+  axis.doubles = values;
+  for (size_t i = 0; i < values.size(); ++i) {
+    axis.args.push_back(static_cast<int64_t>(i));
+  }
+  return AddAxis(name, std::move(axis));
+}
+
+Benchmark* Benchmark::StringAxis(const std::string& name,
+                                 const std::vector<std::string>& values) {
+  ArgAxis axis;
+  axis.type = TypedArg::kString;
+  axis.names = values;
+  for (size_t i = 0; i < values.size(); ++i) {
+    axis.args.push_back(static_cast<int64_t>(i));
+  }
+  return AddAxis(name, std::move(axis));
+}
+
+Benchmark* Benchmark::IntAxis(const std::string& name,
+                              const std::vector<int64_t>& values) {
+  ArgAxis axis;
+  axis.args = values;
+  return AddAxis(name, std::move(axis));
+}
+
+Benchmark* Benchmark::AddAxis(const std::string& name, ArgAxis axis) {
+  BM_CHECK(args_.size() <= 1 &&
+           static_cast<int>(arg_axes_.size()) == std::max(ArgsCnt(), 0))
+      << "the arguments of '" << name_
+      << "' must all be axes to add the axis '" << name << "'";
+  BM_CHECK(!axis.args.empty()) << "axis '" << name << "' has no values";
+  if (args_.empty()) {
+    args_.emplace_back();
+  }
+  args_.front().push_back(axis.args);
+  arg_names_.resize(arg_axes_.size());
+  arg_names_.push_back(name);
+  arg_axes_.push_back(std::move(axis));
   return this;
 }
 
@@ -318,15 +464,22 @@ Benchmark* Benchmark::ArgNames(const std::vector<std::string>& names) {
 Benchmark* Benchmark::DenseRange(int64_t start, int64_t limit, int step) {
   BM_CHECK(ArgsCnt() == -1 || ArgsCnt() == 1);
   BM_CHECK_LE(start, limit);
+  std::vector<int64_t> arglist;
   for (int64_t arg = start; arg <= limit; arg += step) {
-    args_.push_back({arg});
+    arglist.push_back(arg);
   }
+  args_.push_back({std::move(arglist)});
   return this;
 }
 
 Benchmark* Benchmark::Args(const std::vector<int64_t>& args) {
   BM_CHECK(ArgsCnt() == -1 || ArgsCnt() == static_cast<int>(args.size()));
-  args_.push_back(args);
+  std::vector<std::vector<int64_t>> arglists;
+  arglists.reserve(args.size());
+  for (int64_t arg : args) {
+    arglists.push_back({arg});
+  }
+  args_.push_back(std::move(arglists));
   return this;
 }
 
@@ -2,9 +2,14 @@
 #define BENCHMARK_REGISTER_H
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "benchmark/benchmark.h"
 #include "check.h"
 
 namespace benchmark {
@@ -103,6 +108,24 @@ void AddRange(std::vector<T>* dst, T lo, T hi, int mult) {
   }
 }
 
+// Returns the number of combinations in the cartesian product of 'arglists'.
+// The product of no lists has a single, empty, combination.
+inline size_t NumArgCombinations(
+    const std::vector<std::vector<int64_t>>& arglists) {
+  size_t total = 1;
+  for (const auto& arglist : arglists) {
+    total *= arglist.size();
+  }
+  return total;
+}
+
+// The arguments of Benchmark::WorkingSetSweep() for the data 'caches', each
+// with the level its working set fits in ("L1", ..., "DRAM"): 0.5, 0.9 and
+// 1.5 times the size of each level, and 4 and 16 times the size of the last
+// one, divided by 'bytes_per_arg'.
+BENCHMARK_EXPORT std::vector<std::pair<int64_t, std::string>> WorkingSetPoints(
+    const std::vector<CPUInfo::CacheInfo>& caches, int64_t bytes_per_arg);
+
 }  // namespace internal
 }  // namespace benchmark
 
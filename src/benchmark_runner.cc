@@ -51,6 +51,7 @@
 #include "mutex.h"
 #include "perf_counters.h"
 #include "re.h"
+#include "sampling_profiler.h"
 #include "statistics.h"
 #include "string_util.h"
 #include "thread_manager.h"
@@ -65,6 +66,8 @@ BM_DECLARE_int32(benchmark_repetitions);
 BM_DECLARE_bool(benchmark_report_aggregates_only);
 BM_DECLARE_bool(benchmark_display_aggregates_only);
 BM_DECLARE_string(benchmark_perf_counters);
+BM_DECLARE_string(benchmark_profile);
+BM_DECLARE_bool(benchmark_profile_memory);
 
 namespace internal {
 
@@ -78,6 +81,22 @@ constexpr IterationCount kMaxIterations = 1000000000000;
 const double kDefaultMinTime =
     std::strtod(::benchmark::kDefaultMinTimeStr, /*p_end*/ nullptr);
 
+// Reports the use of the SharedData() cache since 'before', if any: the
+// share of the requests that hit and the time spent building datasets.
+void AddSharedDataCounters(const SharedDataStats& before,
+                           BenchmarkReporter::Run* report) {
+  const SharedDataStats after = GetSharedDataStats();
+  const int64_t hits = after.hits - before.hits;
+  const int64_t requests = hits + after.misses - before.misses;
+  if (requests == 0) {
+    return;
+  }
+  report->counters["shared_data_hit_rate"] =
+      Counter(static_cast<double>(hits) / static_cast<double>(requests));
+  report->counters["shared_data_build_time"] =
+      Counter(after.build_seconds - before.build_seconds);
+}
+
 BenchmarkReporter::Run CreateRunReport(
     const benchmark::internal::BenchmarkInstance& b,
     const internal::ThreadManager::Result& results,
@@ -92,7 +111,10 @@ BenchmarkReporter::Run CreateRunReport(
   report.per_family_instance_index = b.per_family_instance_index();
   report.skipped = results.skipped_;
   report.skip_message = results.skip_message_;
-  report.report_label = results.report_label_;
+  report.report_label = results.report_label_.empty() ? b.arg_label()
+                                                      : results.report_label_;
+  report.buffer_policy = results.buffer_policy_;
+  report.args = b.typed_args();
   // This is the total iterations across all threads.
   report.iterations = results.iterations;
   report.time_unit = b.time_unit();
@@ -134,6 +156,7 @@ BenchmarkReporter::Run CreateRunReport(
 void RunInThread(const BenchmarkInstance* b, IterationCount iters,
                  int thread_id, ThreadManager* manager,
                  PerfCountersMeasurement* perf_counters_measurement,
+                 EnergyMeasurement* energy_measurement,
                  ProfilerManager* profiler_manager_) {
   internal::ThreadTimer timer(
       b->measure_process_cpu_time()
@@ -141,7 +164,8 @@ void RunInThread(const BenchmarkInstance* b, IterationCount iters,
           : internal::ThreadTimer::Create());
 
   State st = b->Run(iters, thread_id, &timer, manager,
-                    perf_counters_measurement, profiler_manager_);
+                    perf_counters_measurement, energy_measurement,
+                    profiler_manager_);
   if (!(st.skipped() || st.iterations() >= st.max_iterations)) {
     st.SkipWithError(
         "The benchmark didn't run, nor was it explicitly skipped. Please call "
@@ -272,7 +296,7 @@ BenchTimeType ParseBenchMinTime(const std::string& value) {
 
 BenchmarkRunner::BenchmarkRunner(
     const benchmark::internal::BenchmarkInstance& b_,
-    PerfCountersMeasurement* pcm_,
+    PerfCountersMeasurement* pcm_, EnergyMeasurement* em_,
     BenchmarkReporter::PerFamilyRunReports* reports_for_family_)
     : b(b_),
       reports_for_family(reports_for_family_),
@@ -301,7 +325,8 @@ BenchmarkRunner::BenchmarkRunner(
                 : (has_explicit_iteration_count
                        ? ComputeIters(b_, parsed_benchtime_flag)
                        : 1)),
-      perf_counters_measurement_ptr(pcm_) {
+      perf_counters_measurement_ptr(pcm_),
+      energy_measurement_ptr(em_) {
   run_results.display_report_aggregates_only =
       (FLAGS_benchmark_report_aggregates_only ||
        FLAGS_benchmark_display_aggregates_only);
@@ -328,7 +353,8 @@ BenchmarkRunner::IterationResults BenchmarkRunner::DoNIterations() {
 
   thread_runner->RunThreads([&](int thread_idx) {
     RunInThread(&b, iters, thread_idx, manager.get(),
-                perf_counters_measurement_ptr, /*profiler_manager=*/nullptr);
+                perf_counters_measurement_ptr, energy_measurement_ptr,
+                /*profiler_manager=*/nullptr);
   });
 
   IterationResults i;
@@ -457,6 +483,7 @@ MemoryManager::Result BenchmarkRunner::RunMemoryManager(
   b.Setup();
   RunInThread(&b, memory_iterations, 0, manager.get(),
               perf_counters_measurement_ptr,
+              /*energy_measurement=*/nullptr,
               /*profiler_manager=*/nullptr);
   manager.reset();
   b.Teardown();
@@ -467,20 +494,49 @@ MemoryManager::Result BenchmarkRunner::RunMemoryManager(
 }
 
 void BenchmarkRunner::RunProfilerManager(IterationCount profile_iterations) {
+  // The built-in sampling profilers wrap the registered manager, if any, so
+  // that all of them observe the same run.
+  std::unique_ptr<MemoryAccessProfiler> memory_profiler;
+  std::unique_ptr<SamplingProfiler> sampling_profiler;
+  ProfilerManager* run_profiler_manager = profiler_manager;
+  if (!FLAGS_benchmark_profile.empty()) {
+    if (FLAGS_benchmark_profile_memory) {
+      memory_profiler.reset(new MemoryAccessProfiler(run_profiler_manager));
+      run_profiler_manager = memory_profiler.get();
+    }
+    sampling_profiler.reset(new SamplingProfiler(run_profiler_manager));
+    run_profiler_manager = sampling_profiler.get();
+  }
+
   std::unique_ptr<internal::ThreadManager> manager;
   manager.reset(new internal::ThreadManager(1));
   b.Setup();
   RunInThread(&b, profile_iterations, 0, manager.get(),
               /*perf_counters_measurement_ptr=*/nullptr,
-              /*profiler_manager=*/profiler_manager);
+              /*energy_measurement=*/nullptr,
+              /*profiler_manager=*/run_profiler_manager);
   manager.reset();
   b.Teardown();
+
+  if (sampling_profiler) {
+    sampling_profiler->WriteFoldedStacks(SamplingProfiler::OutputPath(
+        FLAGS_benchmark_profile, b.name().str(), num_repetitions_done,
+        repeats));
+  }
+  if (memory_profiler) {
+    memory_profiler->WriteReport(
+        SamplingProfiler::OutputPath(FLAGS_benchmark_profile, b.name().str(),
+                                     num_repetitions_done, repeats,
+                                     ".memory.txt"),
+        b.name().str());
+  }
 }
 
 void BenchmarkRunner::DoOneRepetition() {
   assert(HasRepeatsRemaining() && "Already done all repetitions?");
 
   const bool is_the_first_repetition = num_repetitions_done == 0;
+  const SharedDataStats shared_data_before = GetSharedDataStats();
 
   // In case a warmup phase is requested by the benchmark, run it now.
   // After running the warmup phase the BenchmarkRunner should be in a state as
@@ -535,7 +591,7 @@ void BenchmarkRunner::DoOneRepetition() {
     memory_result = RunMemoryManager(memory_iterations);
   }
 
-  if (profiler_manager != nullptr) {
+  if (profiler_manager != nullptr || !FLAGS_benchmark_profile.empty()) {
     // We want to externally profile the benchmark for the same number of
     // iterations because, for example, if we're tracing the benchmark then we
     // want trace data to reasonably match PMU data.
@@ -546,6 +602,7 @@ void BenchmarkRunner::DoOneRepetition() {
   BenchmarkReporter::Run report =
       CreateRunReport(b, i.results, memory_iterations, memory_result, i.seconds,
                       num_repetitions_done, repeats);
+  AddSharedDataCounters(shared_data_before, &report);
 
   if (reports_for_family != nullptr) {
     ++reports_for_family->num_runs_done;
@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "benchmark_api_internal.h"
+#include "energy.h"
 #include "perf_counters.h"
 #include "thread_manager.h"
 
@@ -53,6 +54,7 @@ class BenchmarkRunner {
  public:
   BenchmarkRunner(const benchmark::internal::BenchmarkInstance& b_,
                   benchmark::internal::PerfCountersMeasurement* pcm_,
+                  benchmark::internal::EnergyMeasurement* em_,
                   BenchmarkReporter::PerFamilyRunReports* reports_for_family);
 
   int GetNumRepeats() const { return repeats; }
@@ -97,6 +99,7 @@ class BenchmarkRunner {
   // the other repetitions will just use that precomputed iteration count.
 
   PerfCountersMeasurement* const perf_counters_measurement_ptr = nullptr;
+  EnergyMeasurement* const energy_measurement_ptr = nullptr;
 
   struct IterationResults {
     internal::ThreadManager::Result results;
@@ -0,0 +1,280 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "buffer_allocator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#include "check.h"
+#include "internal_macros.h"
+
+#ifdef BENCHMARK_OS_LINUX
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace benchmark {
+namespace internal {
+
+namespace {
+
+size_t RoundUp(size_t value, size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+const char* PagesName(BufferPolicy::PageSize pages) {
+  switch (pages) {
+    case BufferPolicy::kDefaultPages:
+      return "default";
+    case BufferPolicy::kTransparentHugePages:
+      return "THP";
+    case BufferPolicy::kHugePages2M:
+      return "2M";
+    case BufferPolicy::kHugePages1G:
+      return "1G";
+  }
+  return "";
+}
+
+bool SamePolicy(const BufferPolicy& a, const BufferPolicy& b) {
+  return a.pages == b.pages && a.numa_node == b.numa_node &&
+         a.alignment == b.alignment && a.prefault == b.prefault;
+}
+
+// Points `buffer` at the first `alignment`-aligned byte of the mapping.
+void AlignInto(void* base, size_t mapped, size_t alignment,
+               MappedBuffer* buffer) {
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(base);
+  const uintptr_t aligned = RoundUp(begin, alignment);
+  buffer->base = base;
+  buffer->mapped = mapped;
+  buffer->data = reinterpret_cast<void*>(aligned);
+  buffer->capacity = mapped - (aligned - begin);
+}
+
+#ifdef BENCHMARK_OS_LINUX
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+constexpr size_t k2M = size_t{1} << 21;
+constexpr size_t k1G = size_t{1} << 30;
+
+// Maps `bytes` bytes in pages of `page_size` with extra `flags`, leaving
+// room to align the start to `alignment`.
+void* MapAnonymous(size_t bytes, size_t page_size, size_t alignment, int flags,
+                   size_t* mapped) {
+  *mapped = RoundUp(bytes + (alignment > page_size ? alignment : 0), page_size);
+  return mmap(nullptr, *mapped, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+}
+
+bool BindToNode(void* base, size_t mapped, int node) {
+#ifdef SYS_mbind
+  constexpr int kMpolBind = 2;
+  constexpr size_t kBitsPerWord = sizeof(unsigned long) * 8;
+  std::vector<unsigned long> mask(static_cast<size_t>(node) / kBitsPerWord + 1,
+                                  0);
+  mask[static_cast<size_t>(node) / kBitsPerWord] |=
+      1UL << (static_cast<size_t>(node) % kBitsPerWord);
+  return syscall(SYS_mbind, base, mapped, kMpolBind, mask.data(),
+                 mask.size() * kBitsPerWord + 1, 0) == 0;
+#else
+  (void)base;
+  (void)mapped;
+  (void)node;
+  return false;
+#endif
+}
+
+#endif  // BENCHMARK_OS_LINUX
+
+}  // namespace
+
+std::string MappedBuffer::Describe(const BufferPolicy& requested) const {
+  std::stringstream ss;
+  ss << "pages=" << PagesName(obtained.pages);
+  if (obtained.pages != requested.pages) {
+    ss << "(wanted " << PagesName(requested.pages) << ")";
+  }
+  ss << " node=";
+  if (requested.numa_node < 0) {
+    ss << "any";
+  } else {
+    ss << requested.numa_node << (numa_bound ? "" : "(not bound)");
+  }
+  ss << " align=" << requested.alignment;
+  if (requested.prefault) {
+    ss << " prefault";
+  }
+  return ss.str();
+}
+
+#ifdef BENCHMARK_OS_LINUX
+
+bool MapBuffer(size_t bytes, const BufferPolicy& policy,
+               MappedBuffer* buffer) {
+  BM_CHECK(policy.alignment != 0 &&
+           (policy.alignment & (policy.alignment - 1)) == 0)
+      << "BufferPolicy::alignment must be a power of two";
+  *buffer = MappedBuffer();
+  buffer->obtained = policy;
+  bytes = std::max<size_t>(bytes, 1);
+
+  BufferPolicy::PageSize pages = policy.pages;
+  size_t mapped = 0;
+  void* base = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (pages == BufferPolicy::kHugePages1G) {
+    base = MapAnonymous(bytes, k1G, policy.alignment,
+                        MAP_HUGETLB | (30 << MAP_HUGE_SHIFT), &mapped);
+    if (base == MAP_FAILED) {
+      pages = BufferPolicy::kHugePages2M;
+    }
+  }
+  if (pages == BufferPolicy::kHugePages2M) {
+    base = MapAnonymous(bytes, k2M, policy.alignment,
+                        MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), &mapped);
+    if (base == MAP_FAILED) {
+      pages = BufferPolicy::kTransparentHugePages;
+    }
+  }
+#else
+  if (pages == BufferPolicy::kHugePages1G ||
+      pages == BufferPolicy::kHugePages2M) {
+    pages = BufferPolicy::kTransparentHugePages;
+  }
+#endif
+  size_t alignment = policy.alignment;
+  if (base == MAP_FAILED) {
+    // Transparent huge pages only back 2 MiB aligned ranges.
+    if (pages == BufferPolicy::kTransparentHugePages) {
+      alignment = std::max(alignment, k2M);
+    }
+    const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    base = MapAnonymous(bytes, page_size, alignment, 0, &mapped);
+    if (base == MAP_FAILED) {
+      return false;
+    }
+    if (pages == BufferPolicy::kTransparentHugePages) {
+      madvise(base, mapped, MADV_HUGEPAGE);
+    }
+  }
+  buffer->obtained.pages = pages;
+  AlignInto(base, mapped, alignment, buffer);
+
+  // The binding only affects pages faulted in afterwards.
+  if (policy.numa_node >= 0) {
+    buffer->numa_bound = BindToNode(base, mapped, policy.numa_node);
+  }
+  if (policy.prefault) {
+    std::memset(buffer->data, 0, buffer->capacity);
+  }
+  return true;
+}
+
+void UnmapBuffer(MappedBuffer* buffer) {
+  if (buffer->base != nullptr) {
+    munmap(buffer->base, buffer->mapped);
+  }
+  *buffer = MappedBuffer();
+}
+
+#else  // BENCHMARK_OS_LINUX
+
+bool MapBuffer(size_t bytes, const BufferPolicy& policy,
+               MappedBuffer* buffer) {
+  BM_CHECK(policy.alignment != 0 &&
+           (policy.alignment & (policy.alignment - 1)) == 0)
+      << "BufferPolicy::alignment must be a power of two";
+  *buffer = MappedBuffer();
+  buffer->obtained = policy;
+  buffer->obtained.pages = BufferPolicy::kDefaultPages;
+  const size_t mapped = std::max<size_t>(bytes, 1) + policy.alignment;
+  void* base = std::malloc(mapped);
+  if (base == nullptr) {
+    return false;
+  }
+  AlignInto(base, mapped, policy.alignment, buffer);
+  if (policy.prefault) {
+    std::memset(buffer->data, 0, buffer->capacity);
+  }
+  return true;
+}
+
+void UnmapBuffer(MappedBuffer* buffer) {
+  std::free(buffer->base);
+  *buffer = MappedBuffer();
+}
+
+#endif  // BENCHMARK_OS_LINUX
+
+BufferCache::~BufferCache() { Clear(); }
+
+void* BufferCache::Acquire(const std::string& family, int thread_index,
+                           int slot, size_t bytes, const BufferPolicy& policy,
+                           std::string* description) {
+  MutexLock l(mutex_);
+  if (family != family_) {
+    ClearLocked();
+    family_ = family;
+  }
+  Entry& entry = entries_[std::make_pair(thread_index, slot)];
+  const bool reusable = entry.buffer.data != nullptr &&
+                        entry.buffer.capacity >= bytes &&
+                        SamePolicy(entry.policy, policy);
+  if (!reusable) {
+    UnmapBuffer(&entry.buffer);
+    entry.policy = policy;
+    if (!MapBuffer(bytes, policy, &entry.buffer)) {
+      entries_.erase(std::make_pair(thread_index, slot));
+      return nullptr;
+    }
+  }
+  *description = entry.buffer.Describe(entry.policy);
+  return entry.buffer.data;
+}
+
+void BufferCache::Clear() {
+  MutexLock l(mutex_);
+  ClearLocked();
+  family_.clear();
+}
+
+size_t BufferCache::size() {
+  MutexLock l(mutex_);
+  return entries_.size();
+}
+
+void BufferCache::ClearLocked() {
+  for (auto& entry : entries_) {
+    UnmapBuffer(&entry.second.buffer);
+  }
+  entries_.clear();
+}
+
+BufferCache& GetBufferCache() {
+  static BufferCache* cache = new BufferCache();
+  return *cache;
+}
+
+}  // namespace internal
+}  // namespace benchmark
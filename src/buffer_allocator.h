@@ -0,0 +1,108 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCHMARK_BUFFER_ALLOCATOR_H_
+#define BENCHMARK_BUFFER_ALLOCATOR_H_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "benchmark/benchmark.h"
+#include "mutex.h"
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+// C4251: <symbol> needs to have dll-interface to be used by clients of class
+#pragma warning(disable : 4251)
+#endif
+
+namespace benchmark {
+namespace internal {
+
+// A block of memory mapped according to a BufferPolicy.
+struct BENCHMARK_EXPORT MappedBuffer {
+  void* data = nullptr;   // aligned as the policy asks
+  size_t capacity = 0;    // usable bytes from `data`
+  void* base = nullptr;   // what to unmap
+  size_t mapped = 0;
+  // The policy, with `pages` set to what was actually obtained.
+  BufferPolicy obtained;
+  bool numa_bound = false;
+
+  // E.g. "pages=THP(wanted 1G) node=any align=64 prefault": the requested
+  // page size is noted when a fallback was taken.
+  std::string Describe(const BufferPolicy& requested) const;
+};
+
+// Maps at least `bytes` bytes as `policy` asks, falling back to smaller
+// pages when huge pages are not available. Returns false only if no memory
+// could be mapped at all.
+BENCHMARK_EXPORT bool MapBuffer(size_t bytes, const BufferPolicy& policy,
+                                MappedBuffer* buffer);
+BENCHMARK_EXPORT void UnmapBuffer(MappedBuffer* buffer);
+
+// The buffers handed out by State::AllocateBuffer(), keyed by thread index
+// and call order within the run. All buffers belong to one benchmark family
+// at a time; requesting one for another family releases them.
+class BENCHMARK_EXPORT BufferCache {
+ public:
+  BufferCache() = default;
+  ~BufferCache();
+
+  BufferCache(const BufferCache&) = delete;
+  BufferCache& operator=(const BufferCache&) = delete;
+
+  // The `slot`-th buffer of thread `thread_index` of `family`, at least
+  // `bytes` bytes. Stores its description into `description`. Returns
+  // nullptr if the memory could not be mapped.
+  void* Acquire(const std::string& family, int thread_index, int slot,
+                size_t bytes, const BufferPolicy& policy,
+                std::string* description);
+
+  // Release every buffer.
+  void Clear();
+
+  // Number of buffers currently held.
+  size_t size();
+
+ private:
+  struct Entry {
+    MappedBuffer buffer;
+    BufferPolicy policy;  // as requested
+  };
+
+  void ClearLocked() REQUIRES(mutex_);
+
+  Mutex mutex_;
+  std::string family_ GUARDED_BY(mutex_);
+  std::map<std::pair<int, int>, Entry> entries_ GUARDED_BY(mutex_);
+};
+
+// The cache used by State::AllocateBuffer().
+BENCHMARK_EXPORT BufferCache& GetBufferCache();
+
+// The thread index under which the states of Setup() and Teardown() keep
+// their buffers, apart from those of the benchmark threads.
+constexpr int kSetupTeardownThreadIndex = -1;
+
+}  // namespace internal
+}  // namespace benchmark
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif  // BENCHMARK_BUFFER_ALLOCATOR_H_
@@ -14,18 +14,29 @@
 
 #include "counter.h"
 
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mutex.h"
+
 namespace benchmark {
 namespace internal {
 
 namespace {
 
-double Finish(Counter const& c, IterationCount iterations, double cpu_time,
-              double num_threads) {
-  double v = c.value;
+double Finish(Counter const& c, double v, IterationCount iterations,
+              double cpu_time, double num_threads) {
   if ((c.flags & Counter::kIsRate) != 0) {
     v /= cpu_time;
   }
-  if ((c.flags & Counter::kAvgThreads) != 0) {
+  // Only a sum grows with the number of threads.
+  if ((c.flags & Counter::kAvgThreads) != 0 &&
+      c.aggregation == Counter::kSum) {
     v /= num_threads;
   }
   if ((c.flags & Counter::kIsIterationInvariant) != 0) {
@@ -41,28 +52,107 @@ double Finish(Counter const& c, IterationCount iterations, double cpu_time,
   return v;
 }
 
+double Mean(std::vector<double> const& v) {
+  return std::accumulate(v.begin(), v.end(), 0.0) /
+         static_cast<double>(v.size());
+}
+
+// The q-th quantile of 'sorted', interpolated between the closest ranks.
+double Percentile(std::vector<double> const& sorted, double q) {
+  const double rank = q * static_cast<double>(sorted.size() - 1);
+  const size_t lo = static_cast<size_t>(rank);
+  const size_t hi = std::min(lo + 1, sorted.size() - 1);
+  const double frac = rank - static_cast<double>(lo);
+  return sorted[lo] + (sorted[hi] - sorted[lo]) * frac;
+}
+
+// The percentile counters of a distribution: name suffix and quantile.
+constexpr std::pair<const char*, double> kPercentiles[] = {
+    {"_p50", 0.5}, {"_p90", 0.9}, {"_p99", 0.99}};
+
+// The values a counter stands for: its samples, or its value if it has none.
+void AppendSamples(Counter const& c, std::vector<double>* out) {
+  if (c.samples.empty()) {
+    out->push_back(c.value);
+  } else {
+    out->insert(out->end(), c.samples.begin(), c.samples.end());
+  }
+}
+
+// Combines the value of one more thread 'r' into 'l'.
+void Merge(Counter* l, Counter const& r) {
+  switch (l->aggregation) {
+    case Counter::kSum:
+      l->value += r.value;
+      break;
+    case Counter::kMin:
+      l->value = std::min(l->value, r.value);
+      break;
+    case Counter::kMax:
+      l->value = std::max(l->value, r.value);
+      break;
+    case Counter::kLast:
+      l->value = r.value;
+      break;
+    case Counter::kMean:
+    case Counter::kDistribution: {
+      std::vector<double> samples;
+      AppendSamples(*l, &samples);
+      AppendSamples(r, &samples);
+      l->value = Mean(samples);
+      l->samples = std::move(samples);
+      break;
+    }
+  }
+}
+
 }  // namespace
 
 void Finish(UserCounters* l, IterationCount iterations, double cpu_time,
             double num_threads) {
+  UserCounters percentiles;
   for (auto& c : *l) {
-    c.second.value = Finish(c.second, iterations, cpu_time, num_threads);
+    Counter& counter = c.second;
+    if (counter.samples.empty()) {
+      counter.value =
+          Finish(counter, counter.value, iterations, cpu_time, num_threads);
+    } else {
+      for (double& s : counter.samples) {
+        s = Finish(counter, s, iterations, cpu_time, num_threads);
+      }
+      counter.value = Mean(counter.samples);
+    }
+    if (counter.aggregation == Counter::kDistribution) {
+      AddPercentiles(c.first, counter, &percentiles);
+    }
   }
+  l->insert(percentiles.begin(), percentiles.end());
 }
 
-void Increment(UserCounters* l, UserCounters const& r) {
-  // add counters present in both or just in *l
-  for (auto& c : *l) {
-    auto it = r.find(c.first);
-    if (it != r.end()) {
-      c.second.value = c.second + it->second;
-    }
+void AddPercentiles(std::string const& name, Counter const& c,
+                    UserCounters* out) {
+  std::vector<double> sorted;
+  AppendSamples(c, &sorted);
+  std::sort(sorted.begin(), sorted.end());
+  for (auto const& p : kPercentiles) {
+    (*out)[name + p.first] =
+        Counter(Percentile(sorted, p.second), c.flags, c.oneK);
   }
-  // add counters present in r, but not in *l
+}
+
+void Increment(UserCounters* l, UserCounters const& r) {
+  // Both maps are sorted by name: merge them in one pass, combining counters
+  // present in both and inserting those only in r where they belong.
+  auto it = l->begin();
   for (auto const& tc : r) {
-    auto it = l->find(tc.first);
-    if (it == l->end()) {
-      (*l)[tc.first] = tc.second;
+    while (it != l->end() && it->first < tc.first) {
+      ++it;
+    }
+    if (it != l->end() && it->first == tc.first) {
+      Merge(&it->second, tc.second);
+      ++it;
+    } else {
+      l->emplace_hint(it, tc);
     }
   }
 }
@@ -82,5 +172,43 @@ bool SameNames(UserCounters const& l, UserCounters const& r) {
   return true;
 }
 
+namespace {
+
+// The registry of interned counter names. The deque keeps the names in
+// place as it grows, so references to them stay valid.
+struct CounterRegistry {
+  Mutex mutex;
+  std::map<std::string, size_t> indices GUARDED_BY(mutex);
+  std::deque<std::string> names GUARDED_BY(mutex);
+};
+
+CounterRegistry& GetCounterRegistry() {
+  static CounterRegistry* registry = new CounterRegistry();
+  return *registry;
+}
+
+}  // namespace
+
+const std::string& CounterName(size_t index) {
+  CounterRegistry& registry = GetCounterRegistry();
+  MutexLock l(registry.mutex);
+  return registry.names[index];
+}
+
 }  // end namespace internal
+
+CounterId::CounterId(const std::string& name) {
+  internal::CounterRegistry& registry = internal::GetCounterRegistry();
+  MutexLock l(registry.mutex);
+  auto it = registry.indices.emplace(name, registry.names.size()).first;
+  if (it->second == registry.names.size()) {
+    registry.names.push_back(name);
+  }
+  index_ = it->second;
+}
+
+const std::string& CounterId::name() const {
+  return internal::CounterName(index_);
+}
+
 }  // end namespace benchmark
@@ -23,8 +23,14 @@ namespace benchmark {
 namespace internal {
 void Finish(UserCounters* l, IterationCount iterations, double time,
             double num_threads);
+// Sets the <name>_p50, <name>_p90 and <name>_p99 counters of 'out' to the
+// percentiles of the samples of 'c'.
+void AddPercentiles(std::string const& name, Counter const& c,
+                    UserCounters* out);
 void Increment(UserCounters* l, UserCounters const& r);
 bool SameNames(UserCounters const& l, UserCounters const& r);
+// The interned counter name at 'index' of the registry of CounterId.
+const std::string& CounterName(size_t index);
 }  // end namespace internal
 
 }  // end namespace benchmark
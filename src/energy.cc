@@ -0,0 +1,282 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "energy.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+
+#include "internal_macros.h"
+#include "log.h"
+
+#ifdef BENCHMARK_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace benchmark {
+namespace internal {
+
+const char* const EnergyMeasurement::kPowercapRoot = "/sys/class/powercap";
+
+#ifdef BENCHMARK_OS_LINUX
+
+const bool EnergyMeasurement::kSupported = true;
+
+namespace {
+
+std::string ReadFirstLine(const std::string& path) {
+  std::ifstream in(path);
+  std::string line;
+  std::getline(in, line);
+  return line;
+}
+
+std::vector<std::string> ListDirectory(const std::string& path) {
+  std::vector<std::string> entries;
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    return entries;
+  }
+  while (const struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      entries.emplace_back(entry->d_name);
+    }
+  }
+  closedir(dir);
+  std::sort(entries.begin(), entries.end());
+  return entries;
+}
+
+bool ReadMsr(int fd, uint32_t msr, uint64_t* value) {
+  return pread(fd, value, sizeof(*value), static_cast<off_t>(msr)) ==
+         static_cast<ssize_t>(sizeof(*value));
+}
+
+// RAPL registers, from the Intel SDM vol. 4 and AMD PPR for family 17h.
+constexpr uint32_t kIntelPowerUnit = 0x606;
+constexpr uint32_t kAmdPowerUnit = 0xC0010299;
+struct RaplMsr {
+  uint32_t msr;
+  const char* domain;
+};
+constexpr RaplMsr kIntelDomains[] = {
+    {0x611, "package"}, {0x639, "core"}, {0x641, "uncore"}, {0x619, "dram"}};
+constexpr RaplMsr kAmdDomains[] = {{0xC001029B, "package"}};
+
+}  // namespace
+
+EnergyMeasurement::EnergyMeasurement(bool enabled,
+                                     const std::string& powercap_root) {
+  if (!enabled) {
+    return;
+  }
+  DiscoverPowercap(powercap_root);
+  if (sources_.empty()) {
+    DiscoverMsr();
+  }
+  if (sources_.empty()) {
+    GetErrorLogInstance()
+        << "***WARNING*** Energy measurement was requested but no readable "
+           "RAPL counters were found in "
+        << powercap_root
+        << " or /dev/cpu/*/msr. These usually require root privileges.\n";
+  }
+  start_values_.resize(sources_.size());
+  end_values_.resize(sources_.size());
+}
+
+EnergyMeasurement::~EnergyMeasurement() {
+  std::set<int> fds;
+  for (const Source& source : sources_) {
+    fds.insert(source.fd);
+  }
+  for (int fd : fds) {
+    close(fd);
+  }
+}
+
+size_t EnergyMeasurement::DomainIndex(const std::string& name) {
+  auto it = std::find(names_.begin(), names_.end(), name);
+  if (it != names_.end()) {
+    return static_cast<size_t>(it - names_.begin());
+  }
+  names_.push_back(name);
+  return names_.size() - 1;
+}
+
+void EnergyMeasurement::DiscoverPowercap(const std::string& root) {
+  // Zones are named intel-rapl:<package>[:<subzone>], also on AMD. The
+  // intel-rapl-mmio zones duplicate the package zones and are skipped.
+  for (const std::string& zone : ListDirectory(root)) {
+    if (zone.compare(0, 11, "intel-rapl:") != 0) {
+      continue;
+    }
+    const std::string dir = root + "/" + zone;
+    std::string name = ReadFirstLine(dir + "/name");
+    if (name.empty()) {
+      continue;
+    }
+    // One package zone per socket: "package-0", "package-1", ...
+    if (name.compare(0, 8, "package-") == 0) {
+      name = "package";
+    }
+    const uint64_t range = std::strtoull(
+        ReadFirstLine(dir + "/max_energy_range_uj").c_str(), nullptr, 10);
+    const int fd = open((dir + "/energy_uj").c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || range == 0) {
+      if (fd >= 0) {
+        close(fd);
+      }
+      continue;
+    }
+    sources_.push_back({fd, /*is_msr=*/false, /*msr=*/0, range,
+                        /*joules_per_unit=*/1e-6, DomainIndex(name)});
+  }
+}
+
+void EnergyMeasurement::DiscoverMsr() {
+  // Open the MSR device of the first CPU of every package.
+  const std::string kCpuRoot = "/sys/devices/system/cpu";
+  std::set<std::string> packages;
+  for (const std::string& cpu : ListDirectory(kCpuRoot)) {
+    if (cpu.compare(0, 3, "cpu") != 0 || cpu.size() == 3 ||
+        std::strspn(cpu.c_str() + 3, "0123456789") != cpu.size() - 3) {
+      continue;
+    }
+    const std::string package = ReadFirstLine(
+        kCpuRoot + "/" + cpu + "/topology/physical_package_id");
+    if (package.empty() || !packages.insert(package).second) {
+      continue;
+    }
+    const std::string device = "/dev/cpu/" + cpu.substr(3) + "/msr";
+    const int fd = open(device.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      continue;
+    }
+
+    uint64_t units = 0;
+    const RaplMsr* domains = nullptr;
+    size_t num_domains = 0;
+    if (ReadMsr(fd, kIntelPowerUnit, &units)) {
+      domains = kIntelDomains;
+      num_domains = sizeof(kIntelDomains) / sizeof(kIntelDomains[0]);
+    } else if (ReadMsr(fd, kAmdPowerUnit, &units)) {
+      domains = kAmdDomains;
+      num_domains = sizeof(kAmdDomains) / sizeof(kAmdDomains[0]);
+    } else {
+      close(fd);
+      continue;
+    }
+    // Bits 12:8 hold the energy status unit, in 1/2^ESU joules.
+    const double joules_per_unit =
+        1.0 / static_cast<double>(uint64_t{1} << ((units >> 8) & 0x1f));
+
+    bool used = false;
+    for (size_t i = 0; i < num_domains; ++i) {
+      uint64_t value = 0;
+      if (!ReadMsr(fd, domains[i].msr, &value)) {
+        continue;
+      }
+      // The energy status registers are 32 bits wide.
+      sources_.push_back({fd, /*is_msr=*/true, domains[i].msr,
+                          /*range=*/uint64_t{1} << 32, joules_per_unit,
+                          DomainIndex(domains[i].domain)});
+      used = true;
+    }
+    if (!used) {
+      close(fd);
+    }
+  }
+}
+
+bool EnergyMeasurement::ReadAll(std::vector<uint64_t>* values) const {
+  bool ok = true;
+  for (size_t i = 0; i < sources_.size(); ++i) {
+    const Source& source = sources_[i];
+    uint64_t value = 0;
+    if (source.is_msr) {
+      ok &= ReadMsr(source.fd, source.msr, &value);
+      value &= 0xffffffff;
+    } else {
+      char buf[32];
+      const ssize_t n = pread(source.fd, buf, sizeof(buf) - 1, 0);
+      if (n <= 0) {
+        ok = false;
+      } else {
+        buf[n] = '\0';
+        value = std::strtoull(buf, nullptr, 10);
+      }
+    }
+    (*values)[i] = value;
+  }
+  return ok;
+}
+
+bool EnergyMeasurement::Start() {
+  start_time_ = std::chrono::steady_clock::now();
+  return ReadAll(&start_values_);
+}
+
+bool EnergyMeasurement::Stop(double* joules, double* seconds) {
+  const bool ok = ReadAll(&end_values_);
+  *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                           start_time_)
+                 .count();
+  std::fill(joules, joules + num_domains(), 0.0);
+  for (size_t i = 0; i < sources_.size(); ++i) {
+    const Source& source = sources_[i];
+    joules[source.domain] +=
+        static_cast<double>(
+            CounterDelta(start_values_[i], end_values_[i], source.range)) *
+        source.joules_per_unit;
+  }
+  return ok;
+}
+
+#else  // BENCHMARK_OS_LINUX
+
+const bool EnergyMeasurement::kSupported = false;
+
+EnergyMeasurement::EnergyMeasurement(bool enabled, const std::string&) {
+  if (enabled) {
+    GetErrorLogInstance() << "Energy measurement not supported.\n";
+  }
+}
+
+EnergyMeasurement::~EnergyMeasurement() {}
+
+bool EnergyMeasurement::Start() { return false; }
+
+bool EnergyMeasurement::Stop(double*, double* seconds) {
+  *seconds = 0;
+  return false;
+}
+
+void EnergyMeasurement::DiscoverPowercap(const std::string&) {}
+
+void EnergyMeasurement::DiscoverMsr() {}
+
+size_t EnergyMeasurement::DomainIndex(const std::string&) { return 0; }
+
+bool EnergyMeasurement::ReadAll(std::vector<uint64_t>*) const { return false; }
+
+#endif  // BENCHMARK_OS_LINUX
+
+}  // namespace internal
+}  // namespace benchmark
@@ -0,0 +1,108 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCHMARK_ENERGY_H_
+#define BENCHMARK_ENERGY_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+// C4251: <symbol> needs to have dll-interface to be used by clients of class
+#pragma warning(disable : 4251)
+#endif
+
+namespace benchmark {
+namespace internal {
+
+// Reads the RAPL energy counters of the machine: package, core, uncore, DRAM
+// and platform ("psys") energy, each summed over all packages. The counters
+// are discovered once, through the powercap sysfs interface or, where that is
+// not available, the RAPL MSRs via /dev/cpu/*/msr; their files are then kept
+// open so that a snapshot costs one pread per counter.
+//
+// RAPL counters measure the whole machine, not the calling process, and on
+// most kernels are only readable by root.
+class BENCHMARK_EXPORT EnergyMeasurement final {
+ public:
+  // True iff this platform may provide energy counters.
+  static const bool kSupported;
+
+  // Where the powercap RAPL zones are found.
+  static const char* const kPowercapRoot;
+
+  // Discover the energy counters, if `enabled`. Finding none is reported on
+  // the error log but is not fatal: num_domains() is then 0.
+  explicit EnergyMeasurement(bool enabled,
+                             const std::string& powercap_root = kPowercapRoot);
+  ~EnergyMeasurement();
+
+  EnergyMeasurement(const EnergyMeasurement&) = delete;
+  EnergyMeasurement& operator=(const EnergyMeasurement&) = delete;
+
+  size_t num_domains() const { return names_.size(); }
+
+  // Domain names, e.g. "package" or "dram".
+  const std::vector<std::string>& names() const { return names_; }
+
+  // Take the starting snapshot.
+  bool Start();
+
+  // Take the ending snapshot. Stores the joules consumed by each domain since
+  // Start(), indexed like names(), into `joules` and the elapsed wall time
+  // into `seconds`.
+  bool Stop(double* joules, double* seconds);
+
+  // The increase of a counter that counts modulo `range` and went from
+  // `start` to `end`, wrapping around at most once.
+  static uint64_t CounterDelta(uint64_t start, uint64_t end, uint64_t range) {
+    return end >= start ? end - start : end + range - start;
+  }
+
+ private:
+  // One energy counter of one package.
+  struct Source {
+    int fd;
+    bool is_msr;          // otherwise a powercap energy_uj file
+    uint32_t msr;         // register, for MSR sources
+    uint64_t range;       // the counter counts modulo this
+    double joules_per_unit;
+    size_t domain;        // index into names_
+  };
+
+  void DiscoverPowercap(const std::string& root);
+  void DiscoverMsr();
+  size_t DomainIndex(const std::string& name);
+  bool ReadAll(std::vector<uint64_t>* values) const;
+
+  std::vector<std::string> names_;
+  std::vector<Source> sources_;
+  std::vector<uint64_t> start_values_;
+  std::vector<uint64_t> end_values_;
+  std::chrono::steady_clock::time_point start_time_;
+};
+
+}  // namespace internal
+}  // namespace benchmark
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif  // BENCHMARK_ENERGY_H_
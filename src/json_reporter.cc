@@ -267,6 +267,26 @@ void JSONReporter::PrintRunData(Run const& run) {
         << ",\n";
   }
   out << indent << FormatKV("threads", run.threads) << ",\n";
+  if (!run.args.empty()) {
+    out << indent << "\"args\": {";
+    for (size_t i = 0; i < run.args.size(); ++i) {
+      const TypedArg& arg = run.args[i];
+      out << (i == 0 ? "" : ", ");
+      switch (arg.type) {
+        case TypedArg::kInt:
+          out << FormatKV(arg.name, arg.int_value);
+          break;
+        case TypedArg::kDouble:
+          out << FormatKV(arg.name, arg.double_value);
+          break;
+        case TypedArg::kString:
+        case TypedArg::kEnum:
+          out << FormatKV(arg.name, arg.string_value);
+          break;
+      }
+    }
+    out << "},\n";
+  }
   if (run.run_type == BenchmarkReporter::Run::RT_Aggregate) {
     out << indent << FormatKV("aggregate_name", run.aggregate_name) << ",\n";
     out << indent << FormatKV("aggregate_unit", [&run]() -> const char* {
@@ -337,6 +357,9 @@ void JSONReporter::PrintRunData(Run const& run) {
   if (!run.report_label.empty()) {
     out << ",\n" << indent << FormatKV("label", run.report_label);
   }
+  if (!run.buffer_policy.empty()) {
+    out << ",\n" << indent << FormatKV("buffer_policy", run.buffer_policy);
+  }
   out << '\n';
 }
 
@@ -14,19 +14,34 @@
 
 #include "perf_counters.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <memory>
 #include <vector>
 
+#include "internal_macros.h"
+
 #if defined HAVE_LIBPFM
 #include "perfmon/pfmlib.h"
 #include "perfmon/pfmlib_perf_event.h"
+#elif defined BENCHMARK_OS_LINUX
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined HAVE_LIBPFM || defined BENCHMARK_OS_LINUX
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
 #endif
 
 namespace benchmark {
 namespace internal {
 
-#if defined HAVE_LIBPFM
+#if defined HAVE_LIBPFM || defined BENCHMARK_OS_LINUX
 
 size_t PerfCounterValues::Read(const std::vector<int>& leaders) {
   // Create a pointer for multiple reads
@@ -56,6 +71,23 @@ size_t PerfCounterValues::Read(const std::vector<int>& leaders) {
 
 const bool PerfCounters::kSupported = true;
 
+#if defined HAVE_LIBPFM
+
+namespace {
+
+// Translate a counter name into the attribute struct fed into perf_event_open.
+// The fields other than the event type and configuration are left untouched.
+bool EncodeCounter(const std::string& name, struct perf_event_attr* attr) {
+  // This is the input struct to libpfm.
+  pfm_perf_encode_arg_t arg{};
+  arg.attr = attr;
+  const int kCounterMode = PFM_PLM3;  // user mode only
+  return pfm_get_os_event_encoding(name.c_str(), kCounterMode,
+                                   PFM_OS_PERF_EVENT, &arg) == PFM_SUCCESS;
+}
+
+}  // namespace
+
 // Initializes libpfm only on the first call.  Returns whether that single
 // initialization was successful.
 bool PerfCounters::Initialize() {
@@ -79,6 +111,162 @@ bool PerfCounters::IsCounterSupported(const std::string& name) {
   return (ret == PFM_SUCCESS);
 }
 
+#else  // defined HAVE_LIBPFM
+
+namespace {
+
+// glibc does not provide a wrapper for this syscall.
+int perf_event_open(struct perf_event_attr* attr, pid_t pid, int cpu,
+                    int group_fd, unsigned long flags) {
+  return static_cast<int>(
+      syscall(__NR_perf_event_open, attr, pid, cpu, group_fd, flags));
+}
+
+constexpr uint64_t CacheEvent(uint64_t cache, uint64_t op, uint64_t result) {
+  return cache | (op << 8) | (result << 16);
+}
+
+struct GenericEvent {
+  const char* name;
+  uint32_t type;
+  uint64_t config;
+};
+
+// The generic events every kernel exposes, spelled the way `perf list` does.
+// Names are matched case-insensitively so that the libpfm spellings used
+// elsewhere (e.g. `CYCLES`, `INSTRUCTIONS`) keep working.
+const GenericEvent kGenericEvents[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"cpu-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+    {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+    {"branch-instructions", PERF_TYPE_HARDWARE,
+     PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"bus-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES},
+    {"ref-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES},
+    {"stalled-cycles-frontend", PERF_TYPE_HARDWARE,
+     PERF_COUNT_HW_STALLED_CYCLES_FRONTEND},
+    {"stalled-cycles-backend", PERF_TYPE_HARDWARE,
+     PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+
+    {"L1-dcache-loads", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+    {"L1-dcache-load-misses", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"L1-dcache-stores", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_WRITE,
+                PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+    {"L1-icache-load-misses", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_L1I, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"LLC-loads", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+    {"LLC-load-misses", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"LLC-stores", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_WRITE,
+                PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+    {"LLC-store-misses", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_WRITE,
+                PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"dTLB-loads", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_ACCESS)},
+    {"dTLB-load-misses", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"dTLB-store-misses", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_WRITE,
+                PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"iTLB-load-misses", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_ITLB, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"branch-load-misses", PERF_TYPE_HW_CACHE,
+     CacheEvent(PERF_COUNT_HW_CACHE_BPU, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_MISS)},
+
+    // Software events work even where the PMU is not exposed (e.g. VMs).
+    {"task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+    {"page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    {"minor-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN},
+    {"major-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ},
+    {"context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+    {"cpu-migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS},
+};
+
+bool EqualsIgnoreCase(const std::string& lhs, const char* rhs) {
+  const size_t len = std::strlen(rhs);
+  if (lhs.size() != len) {
+    return false;
+  }
+  for (size_t i = 0; i < len; ++i) {
+    if (std::tolower(static_cast<unsigned char>(lhs[i])) !=
+        std::tolower(static_cast<unsigned char>(rhs[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Translate a counter name into the attribute struct fed into perf_event_open.
+// Besides the generic events above, the `rNNNN` syntax of perf(1) selects a
+// raw, model-specific event encoding given in hexadecimal.
+bool EncodeCounter(const std::string& name, struct perf_event_attr* attr) {
+  for (const GenericEvent& event : kGenericEvents) {
+    if (EqualsIgnoreCase(name, event.name)) {
+      attr->type = event.type;
+      attr->config = event.config;
+      return true;
+    }
+  }
+  if (name.size() > 1 && name.size() <= 17 && name[0] == 'r') {
+    char* p_end = nullptr;
+    errno = 0;
+    const unsigned long long config =
+        std::strtoull(name.c_str() + 1, &p_end, 16);
+    if (errno == 0 && p_end != nullptr && *p_end == '\0' &&
+        std::isxdigit(static_cast<unsigned char>(name[1])) != 0) {
+      attr->type = PERF_TYPE_RAW;
+      attr->config = config;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+// The perf_event_open backend has no library to initialize.
+bool PerfCounters::Initialize() { return true; }
+
+bool PerfCounters::IsCounterSupported(const std::string& name) {
+  struct perf_event_attr attr {};
+  attr.size = sizeof(attr);
+  if (!EncodeCounter(name, &attr)) {
+    return false;
+  }
+  // Without libpfm there is no event database to consult, so ask the kernel
+  // whether it can actually count this event for us.
+  attr.disabled = true;
+  attr.exclude_kernel = true;
+  attr.exclude_hv = true;
+  const int id = perf_event_open(&attr, 0, -1, -1, 0);
+  if (id < 0) {
+    return false;
+  }
+  ::close(id);
+  return true;
+}
+
+#endif  // defined HAVE_LIBPFM
+
 PerfCounters PerfCounters::Create(
     const std::vector<std::string>& counter_names) {
   if (!counter_names.empty()) {
@@ -94,8 +282,6 @@ PerfCounters PerfCounters::Create(
   valid_names.reserve(counter_names.size());
   counter_ids.reserve(counter_names.size());
 
-  const int kCounterMode = PFM_PLM3;  // user mode only
-
   // Group leads will be assigned on demand. The idea is that once we cannot
   // create a counter descriptor, the reason is that this group has maxed out
   // so we set the group_id again to -1 and retry - giving the algorithm a
@@ -127,17 +313,12 @@ PerfCounters PerfCounters::Create(
     // Here first means first in group, ie the group leader
     const bool is_first = (group_id < 0);
 
-    // This struct will be populated by libpfm from the counter string
-    // and then fed into the syscall perf_event_open
+    // This struct will be populated from the counter string and then fed
+    // into the syscall perf_event_open
     struct perf_event_attr attr {};
     attr.size = sizeof(attr);
 
-    // This is the input struct to libpfm.
-    pfm_perf_encode_arg_t arg{};
-    arg.attr = &attr;
-    const int pfm_get = pfm_get_os_event_encoding(name.c_str(), kCounterMode,
-                                                  PFM_OS_PERF_EVENT, &arg);
-    if (pfm_get != PFM_SUCCESS) {
+    if (!EncodeCounter(name, &attr)) {
       GetErrorLogInstance()
           << "Unknown performance counter name: " << name << "\n";
       continue;
@@ -242,7 +423,164 @@ void PerfCounters::CloseCounters() const {
     close(fd);
   }
 }
-#else   // defined HAVE_LIBPFM
+
+PerfSampler::~PerfSampler() {
+  Stop();
+  Close();
+}
+
+namespace {
+
+int OpenSelfEvent(struct perf_event_attr* attr, int group_fd) {
+  int id = -1;
+  while (true) {
+    id = perf_event_open(attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+    if (id >= 0 || errno != EINTR) {
+      return id;
+    }
+  }
+}
+
+}  // namespace
+
+bool PerfSampler::Open(struct perf_event_attr* attr, RecordCallback callback,
+                       size_t data_pages, struct perf_event_attr* leader) {
+  BM_CHECK(!is_open()) << "PerfSampler opened twice";
+  BM_CHECK(data_pages != 0 && (data_pages & (data_pages - 1)) == 0)
+      << "The ring buffer size must be a power of two";
+  const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  data_size_ = data_pages * page_size;
+  ring_size_ = data_size_ + page_size;  // plus the metadata page
+
+  int leader_id = -1;
+  if (leader != nullptr) {
+    leader->size = sizeof(*leader);
+    leader->disabled = true;
+    leader_id = OpenSelfEvent(leader, -1);
+    if (leader_id < 0) {
+      return false;
+    }
+  }
+
+  attr->size = sizeof(*attr);
+  // A group member follows its leader.
+  attr->disabled = leader == nullptr;
+  // Wake the reader up once half of the buffer has been filled.
+  attr->watermark = true;
+  attr->wakeup_watermark = static_cast<uint32_t>(data_size_ / 2);
+
+  const int id = OpenSelfEvent(attr, leader_id);
+  if (id < 0) {
+    const int err = errno;
+    if (leader_id >= 0) {
+      ::close(leader_id);
+    }
+    errno = err;
+    return false;
+  }
+  void* ring =
+      mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED, id, 0);
+  if (ring == MAP_FAILED) {
+    GetErrorLogInstance() << "***WARNING*** Failed to map the perf ring "
+                          << "buffer, errno: " << errno << "\n";
+    ::close(id);
+    if (leader_id >= 0) {
+      ::close(leader_id);
+    }
+    return false;
+  }
+  fd_ = id;
+  leader_fd_ = leader_id;
+  ring_ = ring;
+  callback_ = std::move(callback);
+  return true;
+}
+
+void PerfSampler::Start() {
+  if (!is_open()) {
+    return;
+  }
+  stop_.store(false, std::memory_order_relaxed);
+  reader_ = std::thread([this]() {
+    struct pollfd pfd {};
+    pfd.fd = fd_;
+    pfd.events = POLLIN;
+    while (!stop_.load(std::memory_order_relaxed)) {
+      // Poll with a timeout so that Stop() never waits on a quiet event.
+      if (poll(&pfd, 1, /*timeout=*/100) > 0) {
+        Drain();
+      }
+    }
+  });
+  const int control_fd = leader_fd_ >= 0 ? leader_fd_ : fd_;
+  ioctl(control_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(control_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void PerfSampler::Stop() {
+  if (!reader_.joinable()) {
+    return;
+  }
+  ioctl(leader_fd_ >= 0 ? leader_fd_ : fd_, PERF_EVENT_IOC_DISABLE,
+        PERF_IOC_FLAG_GROUP);
+  stop_.store(true, std::memory_order_relaxed);
+  reader_.join();
+  Drain();
+}
+
+void PerfSampler::Drain() {
+  auto* meta = static_cast<struct perf_event_mmap_page*>(ring_);
+  const char* data = static_cast<const char*>(ring_) + (ring_size_ - data_size_);
+  const uint64_t mask = data_size_ - 1;
+  const uint64_t head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+  uint64_t tail = meta->data_tail;
+
+  // Copy `size` bytes starting at ring position `pos`, which may wrap around
+  // the end of the buffer.
+  auto copy_out = [&](uint64_t pos, size_t size, char* out) {
+    const size_t offset = static_cast<size_t>(pos & mask);
+    const size_t first = std::min(size, data_size_ - offset);
+    std::memcpy(out, data + offset, first);
+    std::memcpy(out + first, data, size - first);
+  };
+
+  while (tail < head) {
+    struct perf_event_header header;
+    copy_out(tail, sizeof(header), reinterpret_cast<char*>(&header));
+    if (header.size < sizeof(header)) {
+      break;  // corrupted; drop the rest
+    }
+    const size_t payload = header.size - sizeof(header);
+    record_.resize(payload);
+    copy_out(tail + sizeof(header), payload, record_.data());
+    if (header.type == PERF_RECORD_LOST && payload >= 2 * sizeof(uint64_t)) {
+      uint64_t lost;
+      std::memcpy(&lost, record_.data() + sizeof(uint64_t), sizeof(lost));
+      lost_ += lost;
+    } else {
+      callback_(header.type, record_.data(), payload);
+    }
+    tail += header.size;
+  }
+  __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+}
+
+void PerfSampler::Close() {
+  if (ring_ != nullptr) {
+    munmap(ring_, ring_size_);
+    ring_ = nullptr;
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  if (leader_fd_ >= 0) {
+    ::close(leader_fd_);
+    leader_fd_ = -1;
+  }
+}
+
+#else   // defined HAVE_LIBPFM || defined BENCHMARK_OS_LINUX
 size_t PerfCounterValues::Read(const std::vector<int>&) { return 0; }
 
 const bool PerfCounters::kSupported = false;
@@ -260,7 +598,22 @@ PerfCounters PerfCounters::Create(
 }
 
 void PerfCounters::CloseCounters() const {}
-#endif  // defined HAVE_LIBPFM
+
+PerfSampler::~PerfSampler() {}
+
+bool PerfSampler::Open(struct perf_event_attr*, RecordCallback, size_t,
+                       struct perf_event_attr*) {
+  return false;
+}
+
+void PerfSampler::Start() {}
+
+void PerfSampler::Stop() {}
+
+void PerfSampler::Drain() {}
+
+void PerfSampler::Close() {}
+#endif  // defined HAVE_LIBPFM || defined BENCHMARK_OS_LINUX
 
 PerfCountersMeasurement::PerfCountersMeasurement(
     const std::vector<std::string>& counter_names)
@@ -16,9 +16,12 @@
 #define BENCHMARK_PERF_COUNTERS_H
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include "benchmark/benchmark.h"
@@ -36,6 +39,8 @@
 #pragma warning(disable : 4251)
 #endif
 
+struct perf_event_attr;
+
 namespace benchmark {
 namespace internal {
 
@@ -152,7 +157,7 @@ class BENCHMARK_EXPORT PerfCountersMeasurement final {
 
   size_t num_counters() const { return counters_.num_counters(); }
 
-  std::vector<std::string> names() const { return counters_.names(); }
+  const std::vector<std::string>& names() const { return counters_.names(); }
 
   BENCHMARK_ALWAYS_INLINE bool Start() {
     if (num_counters() == 0) return true;
@@ -165,8 +170,10 @@ class BENCHMARK_EXPORT PerfCountersMeasurement final {
     return valid_read_;
   }
 
-  BENCHMARK_ALWAYS_INLINE bool Stop(
-      std::vector<std::pair<std::string, double>>& measurements) {
+  // Add the counts since the last Start() to `accumulators`, which holds one
+  // slot per counter, indexed like names(). This does not allocate, so it is
+  // what State uses on every PauseTiming().
+  BENCHMARK_ALWAYS_INLINE bool Stop(double* accumulators) {
     if (num_counters() == 0) return true;
     // Tell the compiler to not move instructions above/below where we take
     // the snapshot.
@@ -174,15 +181,24 @@ class BENCHMARK_EXPORT PerfCountersMeasurement final {
     valid_read_ &= counters_.Snapshot(&end_values_);
     ClobberMemory();
 
-    for (size_t i = 0; i < counters_.names().size(); ++i) {
-      double measurement = static_cast<double>(end_values_[i]) -
-                           static_cast<double>(start_values_[i]);
-      measurements.push_back({counters_.names()[i], measurement});
+    for (size_t i = 0; i < num_counters(); ++i) {
+      accumulators[i] += static_cast<double>(end_values_[i]) -
+                         static_cast<double>(start_values_[i]);
     }
 
     return valid_read_;
   }
 
+  // As above, but appends the counts by name to `measurements`.
+  bool Stop(std::vector<std::pair<std::string, double>>& measurements) {
+    std::array<double, PerfCounterValues::kMaxCounters> deltas{};
+    const bool valid = Stop(deltas.data());
+    for (size_t i = 0; i < num_counters(); ++i) {
+      measurements.push_back({counters_.names()[i], deltas[i]});
+    }
+    return valid;
+  }
+
  private:
   PerfCounters counters_;
   bool valid_read_ = true;
@@ -190,6 +206,59 @@ class BENCHMARK_EXPORT PerfCountersMeasurement final {
   PerfCounterValues end_values_;
 };
 
+// Stream the records of a sampling perf_event out of its mmap ring buffer.
+// The event is attached to the calling thread. While sampling, a reader
+// thread drains the buffer whenever it is half full, so long runs do not lose
+// samples; the callback is invoked on that thread and, after Stop(), on the
+// calling one, but never concurrently.
+class BENCHMARK_EXPORT PerfSampler final {
+ public:
+  // Receives one record: its PERF_RECORD_* type and the payload following
+  // the record header, laid out as selected by the attribute's sample_type.
+  using RecordCallback =
+      std::function<void(uint32_t type, const char* data, size_t size)>;
+
+  PerfSampler() = default;
+  ~PerfSampler();
+  PerfSampler(const PerfSampler&) = delete;
+  PerfSampler& operator=(const PerfSampler&) = delete;
+
+  // Open the event described by `attr` (which must request sampling) and map
+  // its ring buffer of `data_pages` pages, a power of two. Some events only
+  // count as part of a group led by an auxiliary event, which `leader` then
+  // describes. The events are left disabled. Returns false if the kernel
+  // refuses any of this; callers may retry with another event, errno tells
+  // why the last attempt failed.
+  bool Open(struct perf_event_attr* attr, RecordCallback callback,
+            size_t data_pages = 64, struct perf_event_attr* leader = nullptr);
+
+  // Enable sampling and start draining the buffer in the background.
+  void Start();
+
+  // Disable sampling and hand every remaining record to the callback.
+  void Stop();
+
+  bool is_open() const { return fd_ >= 0; }
+
+  // Number of records the kernel dropped because the buffer was full.
+  uint64_t lost() const { return lost_; }
+
+ private:
+  void Drain();
+  void Close();
+
+  int fd_ = -1;
+  int leader_fd_ = -1;
+  void* ring_ = nullptr;
+  size_t ring_size_ = 0;
+  size_t data_size_ = 0;
+  RecordCallback callback_;
+  std::vector<char> record_;
+  std::thread reader_;
+  std::atomic<bool> stop_{false};
+  uint64_t lost_ = 0;
+};
+
 }  // namespace internal
 }  // namespace benchmark
 
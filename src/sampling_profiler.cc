@@ -0,0 +1,838 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sampling_profiler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "internal_macros.h"
+#include "log.h"
+#include "string_util.h"
+
+#ifdef BENCHMARK_OS_LINUX
+#include <cxxabi.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace benchmark {
+namespace internal {
+
+namespace {
+
+// Frames must not contain the separators of the folded format.
+std::string SanitizeFrame(std::string frame) {
+  std::replace(frame.begin(), frame.end(), ';', ':');
+  std::replace(frame.begin(), frame.end(), '\n', ' ');
+  return frame;
+}
+
+// Open `path` for writing, creating its directory if needed.
+bool OpenProfileFile(const std::string& path, std::ofstream* out) {
+#ifdef BENCHMARK_OS_LINUX
+  const std::string dir = path.substr(0, path.rfind('/'));
+  if (!dir.empty() && dir != path && mkdir(dir.c_str(), 0755) != 0 &&
+      errno != EEXIST) {
+    GetErrorLogInstance() << "Could not create profile directory '" << dir
+                          << "', errno: " << errno << "\n";
+    return false;
+  }
+#endif
+  out->open(path);
+  if (!*out) {
+    GetErrorLogInstance() << "Could not open profile file '" << path << "'\n";
+    return false;
+  }
+  return true;
+}
+
+#ifdef BENCHMARK_OS_LINUX
+
+// The function symbols of one ELF file, and how its file offsets map to the
+// virtual addresses the symbols are expressed in.
+class ElfSymbols {
+ public:
+  explicit ElfSymbols(const std::string& path) { Load(path); }
+
+  // Returns the symbol covering `file_offset` in the file, or null.
+  const std::string* Find(uint64_t file_offset) const {
+    uint64_t addr = 0;
+    bool mapped = false;
+    for (const Segment& seg : segments_) {
+      if (file_offset >= seg.offset && file_offset < seg.offset + seg.size) {
+        addr = file_offset - seg.offset + seg.vaddr;
+        mapped = true;
+        break;
+      }
+    }
+    if (!mapped) {
+      return nullptr;
+    }
+    auto it = std::upper_bound(
+        symbols_.begin(), symbols_.end(), addr,
+        [](uint64_t a, const Symbol& sym) { return a < sym.addr; });
+    if (it == symbols_.begin()) {
+      return nullptr;
+    }
+    --it;
+    if (it->size != 0 && addr >= it->addr + it->size) {
+      return nullptr;
+    }
+    return &it->name;
+  }
+
+ private:
+  struct Segment {
+    uint64_t offset;
+    uint64_t size;
+    uint64_t vaddr;
+  };
+  struct Symbol {
+    uint64_t addr;
+    uint64_t size;
+    std::string name;
+  };
+
+  void Load(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(Elf64_Ehdr)) {
+      close(fd);
+      return;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+      return;
+    }
+    Parse(static_cast<const char*>(map), size);
+    munmap(map, size);
+
+    std::sort(symbols_.begin(), symbols_.end(),
+              [](const Symbol& a, const Symbol& b) { return a.addr < b.addr; });
+  }
+
+  void Parse(const char* base, size_t size) {
+    Elf64_Ehdr ehdr;
+    std::memcpy(&ehdr, base, sizeof(ehdr));
+    if (std::memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 ||
+        ehdr.e_ident[EI_CLASS] != ELFCLASS64) {
+      return;
+    }
+    auto in_bounds = [size](uint64_t off, uint64_t len) {
+      return off <= size && len <= size - off;
+    };
+
+    if (!in_bounds(ehdr.e_phoff,
+                   uint64_t{ehdr.e_phnum} * sizeof(Elf64_Phdr))) {
+      return;
+    }
+    for (size_t i = 0; i < ehdr.e_phnum; ++i) {
+      Elf64_Phdr phdr;
+      std::memcpy(&phdr, base + ehdr.e_phoff + i * sizeof(phdr), sizeof(phdr));
+      if (phdr.p_type == PT_LOAD) {
+        segments_.push_back({phdr.p_offset, phdr.p_filesz, phdr.p_vaddr});
+      }
+    }
+
+    if (!in_bounds(ehdr.e_shoff,
+                   uint64_t{ehdr.e_shnum} * sizeof(Elf64_Shdr))) {
+      return;
+    }
+    std::vector<Elf64_Shdr> sections(ehdr.e_shnum);
+    std::memcpy(sections.data(), base + ehdr.e_shoff,
+                sections.size() * sizeof(Elf64_Shdr));
+    // Prefer the full symbol table; stripped objects only keep the dynamic
+    // one.
+    bool has_symtab = false;
+    for (const Elf64_Shdr& shdr : sections) {
+      has_symtab |= shdr.sh_type == SHT_SYMTAB;
+    }
+    const uint32_t wanted = has_symtab ? SHT_SYMTAB : SHT_DYNSYM;
+    for (const Elf64_Shdr& shdr : sections) {
+      if (shdr.sh_type != wanted || shdr.sh_link >= sections.size() ||
+          !in_bounds(shdr.sh_offset, shdr.sh_size)) {
+        continue;
+      }
+      const Elf64_Shdr& strtab = sections[shdr.sh_link];
+      if (!in_bounds(strtab.sh_offset, strtab.sh_size)) {
+        continue;
+      }
+      const char* strings = base + strtab.sh_offset;
+      for (uint64_t off = 0; off + sizeof(Elf64_Sym) <= shdr.sh_size;
+           off += sizeof(Elf64_Sym)) {
+        Elf64_Sym sym;
+        std::memcpy(&sym, base + shdr.sh_offset + off, sizeof(sym));
+        const unsigned type = ELF64_ST_TYPE(sym.st_info);
+        if ((type != STT_FUNC && type != STT_GNU_IFUNC) || sym.st_value == 0 ||
+            sym.st_name >= strtab.sh_size) {
+          continue;
+        }
+        const char* name = strings + sym.st_name;
+        const size_t len = strnlen(name, strtab.sh_size - sym.st_name);
+        symbols_.push_back({sym.st_value, sym.st_size, std::string(name, len)});
+      }
+    }
+  }
+
+  std::vector<Segment> segments_;
+  std::vector<Symbol> symbols_;
+};
+
+// Resolves addresses of the current process to function names, using the
+// mappings in /proc/self/maps and the symbol tables of the mapped files.
+class Symbolizer {
+ public:
+  Symbolizer() {
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+      Mapping m;
+      char perms[5] = {};
+      int path_start = 0;
+      unsigned long long start = 0;
+      unsigned long long end = 0;
+      unsigned long long offset = 0;
+      if (std::sscanf(line.c_str(), "%llx-%llx %4s %llx %*s %*s %n", &start,
+                      &end, perms, &offset, &path_start) < 4) {
+        continue;
+      }
+      if (perms[2] != 'x') {
+        continue;
+      }
+      m.start = start;
+      m.end = end;
+      m.offset = offset;
+      if (path_start > 0 && static_cast<size_t>(path_start) < line.size()) {
+        m.path = line.substr(static_cast<size_t>(path_start));
+      }
+      mappings_.push_back(std::move(m));
+    }
+  }
+
+  std::string Symbolize(uint64_t addr) {
+    auto cached = cache_.find(addr);
+    if (cached != cache_.end()) {
+      return cached->second;
+    }
+    std::string frame = Lookup(addr);
+    cache_.emplace(addr, frame);
+    return frame;
+  }
+
+ private:
+  struct Mapping {
+    uint64_t start;
+    uint64_t end;
+    uint64_t offset;
+    std::string path;
+  };
+
+  std::string Lookup(uint64_t addr) {
+    for (const Mapping& m : mappings_) {
+      if (addr < m.start || addr >= m.end) {
+        continue;
+      }
+      const uint64_t file_offset = addr - m.start + m.offset;
+      if (m.path.empty() || m.path[0] != '/') {
+        // Anonymous memory (e.g. JIT code) or a pseudo-file like [vdso].
+        return m.path.empty() ? "[unknown]" : m.path;
+      }
+      std::unique_ptr<ElfSymbols>& symbols = files_[m.path];
+      if (!symbols) {
+        symbols.reset(new ElfSymbols(m.path));
+      }
+      if (const std::string* name = symbols->Find(file_offset)) {
+        return Demangle(*name);
+      }
+      const std::string module = m.path.substr(m.path.rfind('/') + 1);
+      return StrFormat("%s+0x%llx", module.c_str(),
+                       static_cast<unsigned long long>(file_offset));
+    }
+    return "[unknown]";
+  }
+
+  static std::string Demangle(const std::string& name) {
+    int status = 0;
+    char* demangled =
+        abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+    if (status != 0 || demangled == nullptr) {
+      return name;
+    }
+    std::string result(demangled);
+    std::free(demangled);
+    return result;
+  }
+
+  std::vector<Mapping> mappings_;
+  std::map<std::string, std::unique_ptr<ElfSymbols>> files_;
+  std::unordered_map<uint64_t, std::string> cache_;
+};
+
+std::string ReadFirstLine(const std::string& path) {
+  std::ifstream in(path);
+  std::string line;
+  std::getline(in, line);
+  return line;
+}
+
+// Where the memory hierarchy served a load, from perf_mem_data_src.
+std::string DataSourceName(uint64_t data_src) {
+  const uint64_t lvl = (data_src >> PERF_MEM_LVL_SHIFT) & 0x3fff;
+  static const std::pair<uint64_t, const char*> kLevels[] = {
+      {PERF_MEM_LVL_L1, "L1"},
+      {PERF_MEM_LVL_LFB, "LFB"},
+      {PERF_MEM_LVL_L2, "L2"},
+      {PERF_MEM_LVL_L3, "L3"},
+      {PERF_MEM_LVL_LOC_RAM, "local DRAM"},
+      {PERF_MEM_LVL_REM_RAM1 | PERF_MEM_LVL_REM_RAM2, "remote DRAM"},
+      {PERF_MEM_LVL_REM_CCE1 | PERF_MEM_LVL_REM_CCE2, "remote cache"},
+      {PERF_MEM_LVL_IO, "I/O"},
+      {PERF_MEM_LVL_UNC, "uncached"},
+  };
+  for (const auto& level : kLevels) {
+    if ((lvl & level.first) != 0) {
+      std::string name = level.second;
+      if ((lvl & PERF_MEM_LVL_MISS) != 0) {
+        name += " miss";
+      } else if ((lvl & PERF_MEM_LVL_HIT) != 0) {
+        name += " hit";
+      }
+      return name;
+    }
+  }
+  return "unknown";
+}
+
+// How the dTLB translated the address of a load, from perf_mem_data_src.
+std::string TlbName(uint64_t data_src) {
+  const uint64_t tlb = (data_src >> PERF_MEM_TLB_SHIFT) & 0x7f;
+  if ((tlb & PERF_MEM_TLB_HIT) != 0) {
+    return "hit";
+  }
+  if ((tlb & PERF_MEM_TLB_MISS) != 0) {
+    return (tlb & PERF_MEM_TLB_WK) != 0 ? "miss, page walk" : "miss";
+  }
+  return "unknown";
+}
+
+#else  // BENCHMARK_OS_LINUX
+
+std::string DataSourceName(uint64_t) { return "unknown"; }
+
+std::string TlbName(uint64_t) { return "unknown"; }
+
+class Symbolizer {
+ public:
+  std::string Symbolize(uint64_t addr) {
+    return StrFormat("0x%llx", static_cast<unsigned long long>(addr));
+  }
+};
+
+#endif  // BENCHMARK_OS_LINUX
+
+}  // namespace
+
+#ifdef BENCHMARK_OS_LINUX
+
+const bool SamplingProfiler::kSupported = true;
+
+void SamplingProfiler::AfterSetupStart() {
+  if (chained_ != nullptr) {
+    chained_->AfterSetupStart();
+  }
+  // Prefer sampling on cycles; fall back to the kernel's CPU clock where no
+  // PMU is available, e.g. inside most VMs.
+  const std::pair<uint32_t, uint64_t> kEvents[] = {
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK},
+  };
+  for (const auto& event : kEvents) {
+    struct perf_event_attr attr {};
+    attr.type = event.first;
+    attr.config = event.second;
+    attr.freq = true;
+    attr.sample_freq = kSampleFrequency;
+    attr.sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_CALLCHAIN;
+    attr.exclude_kernel = true;
+    attr.exclude_hv = true;
+    attr.exclude_callchain_kernel = true;
+    if (sampler_.Open(
+            &attr, [this](uint32_t type, const char* data, size_t size) {
+              OnRecord(type, data, size);
+            })) {
+      break;
+    }
+  }
+  if (!sampler_.is_open()) {
+    GetErrorLogInstance() << "***WARNING*** Failed to open a sampling perf "
+                          << "event, errno: " << errno << "\n";
+  }
+  sampler_.Start();
+}
+
+void SamplingProfiler::BeforeTeardownStop() {
+  sampler_.Stop();
+  if (sampler_.lost() != 0) {
+    GetErrorLogInstance() << "***WARNING*** The profiler dropped "
+                          << sampler_.lost() << " samples\n";
+  }
+  if (chained_ != nullptr) {
+    chained_->BeforeTeardownStop();
+  }
+}
+
+void SamplingProfiler::OnRecord(uint32_t type, const char* data,
+                                size_t size) {
+  if (type != PERF_RECORD_SAMPLE) {
+    return;
+  }
+  // Layout for PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_CALLCHAIN:
+  //   u64 ip; u32 pid, tid; u64 nr; u64 ips[nr];
+  constexpr size_t kFixedSize = 3 * sizeof(uint64_t);
+  if (size < kFixedSize) {
+    return;
+  }
+  uint64_t ip;
+  uint64_t nr;
+  std::memcpy(&ip, data, sizeof(ip));
+  std::memcpy(&nr, data + 2 * sizeof(uint64_t), sizeof(nr));
+  nr = std::min<uint64_t>(nr, (size - kFixedSize) / sizeof(uint64_t));
+
+  scratch_.clear();
+  for (uint64_t i = 0; i < nr; ++i) {
+    uint64_t frame;
+    std::memcpy(&frame, data + kFixedSize + i * sizeof(uint64_t),
+                sizeof(frame));
+    // Skip the PERF_CONTEXT_* markers interleaved with the addresses.
+    if (frame >= static_cast<uint64_t>(PERF_CONTEXT_MAX)) {
+      continue;
+    }
+    scratch_.push_back(frame);
+  }
+  if (scratch_.empty()) {
+    scratch_.push_back(ip);
+  }
+  ++stacks_[scratch_];
+  ++num_samples_;
+}
+
+void MemoryAccessProfiler::AfterSetupStart() {
+  if (chained_ != nullptr) {
+    chained_->AfterSetupStart();
+  }
+  const std::string kDevices = "/sys/bus/event_source/devices/";
+
+  struct Candidate {
+    std::string description;
+    struct perf_event_attr attr;
+    bool has_leader;
+    struct perf_event_attr leader;
+  };
+  std::vector<Candidate> candidates;
+  auto encode = [&](const std::string& pmu, const char* event,
+                    struct perf_event_attr* attr) {
+    uint32_t type = 0;
+    uint64_t config = 0;
+    uint64_t config1 = 0;
+    if (!EncodePmuEvent(kDevices + pmu, event, &type, &config, &config1)) {
+      return false;
+    }
+    attr->type = type;
+    attr->config = config;
+    attr->config1 = config1;
+    return true;
+  };
+  // Intel PEBS load latency. Hybrid parts name the big-core PMU cpu_core,
+  // and some generations only count loads in a group led by mem-loads-aux.
+  for (const char* pmu : {"cpu", "cpu_core"}) {
+    Candidate c{};
+    if (!encode(pmu, "mem-loads", &c.attr)) {
+      continue;
+    }
+    c.description = std::string(pmu) + "/mem-loads/";
+    c.has_leader = encode(pmu, "mem-loads-aux", &c.leader);
+    for (int precise_ip = 3; precise_ip > 0; --precise_ip) {
+      c.attr.precise_ip = static_cast<uint64_t>(precise_ip) & 3;
+      candidates.push_back(c);
+    }
+  }
+  // AMD IBS op sampling; the kernel decodes its data source and latency.
+  const std::string ibs_type = ReadFirstLine(kDevices + "ibs_op/type");
+  if (!ibs_type.empty()) {
+    Candidate c{};
+    c.description = "ibs_op//";
+    c.attr.type =
+        static_cast<uint32_t>(std::strtoul(ibs_type.c_str(), nullptr, 10));
+    candidates.push_back(c);
+  }
+
+  for (Candidate& c : candidates) {
+    c.attr.freq = true;
+    c.attr.sample_freq = SamplingProfiler::kSampleFrequency;
+    c.attr.sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_ADDR |
+                         PERF_SAMPLE_WEIGHT | PERF_SAMPLE_DATA_SRC;
+    c.attr.exclude_kernel = true;
+    c.attr.exclude_hv = true;
+    c.leader.exclude_kernel = true;
+    c.leader.exclude_hv = true;
+    if (sampler_.Open(
+            &c.attr,
+            [this](uint32_t type, const char* data, size_t size) {
+              OnRecord(type, data, size);
+            },
+            /*data_pages=*/64, c.has_leader ? &c.leader : nullptr)) {
+      event_description_ = c.description;
+      break;
+    }
+  }
+  if (!sampler_.is_open()) {
+    GetErrorLogInstance()
+        << "***WARNING*** Precise memory access sampling is not available on "
+        << "this machine (needs Intel PEBS load latency or AMD IBS)\n";
+  }
+  sampler_.Start();
+}
+
+void MemoryAccessProfiler::BeforeTeardownStop() {
+  sampler_.Stop();
+  if (chained_ != nullptr) {
+    chained_->BeforeTeardownStop();
+  }
+}
+
+void MemoryAccessProfiler::OnRecord(uint32_t type, const char* data,
+                                    size_t size) {
+  // Layout for PERF_SAMPLE_IP | PERF_SAMPLE_ADDR | PERF_SAMPLE_WEIGHT |
+  // PERF_SAMPLE_DATA_SRC:
+  //   u64 ip; u64 addr; u64 weight; u64 data_src;
+  if (type != PERF_RECORD_SAMPLE || size < 4 * sizeof(uint64_t)) {
+    return;
+  }
+  uint64_t fields[4];
+  std::memcpy(fields, data, sizeof(fields));
+  // Recent PMUs put the instruction latency in the upper half of the weight.
+  AddSample(fields[0], fields[1], fields[2] & 0xffffffff, fields[3]);
+}
+
+bool MemoryAccessProfiler::EncodePmuEvent(const std::string& pmu_dir,
+                                          const std::string& event,
+                                          uint32_t* type, uint64_t* config,
+                                          uint64_t* config1) {
+  const std::string type_str = ReadFirstLine(pmu_dir + "/type");
+  const std::string terms = ReadFirstLine(pmu_dir + "/events/" + event);
+  if (type_str.empty() || terms.empty()) {
+    return false;
+  }
+  *type = static_cast<uint32_t>(std::strtoul(type_str.c_str(), nullptr, 10));
+  *config = 0;
+  *config1 = 0;
+
+  // The event is a list of `term[=value]`, each term placed into the config
+  // words as described by its format file, e.g. "config1:0-15".
+  for (const std::string& term : StrSplit(terms, ',')) {
+    const size_t eq = term.find('=');
+    const std::string name = term.substr(0, eq);
+    const uint64_t value =
+        eq == std::string::npos
+            ? 1
+            : std::strtoull(term.c_str() + eq + 1, nullptr, 0);
+    const std::string format = ReadFirstLine(pmu_dir + "/format/" + name);
+    const size_t colon = format.find(':');
+    if (colon == std::string::npos) {
+      return false;
+    }
+    const std::string field = format.substr(0, colon);
+    uint64_t* word = field == "config"    ? config
+                     : field == "config1" ? config1
+                                          : nullptr;
+    if (word == nullptr) {
+      return false;
+    }
+    // Scatter the value over the, possibly discontiguous, bit ranges.
+    unsigned value_bit = 0;
+    for (const std::string& range : StrSplit(format.substr(colon + 1), ',')) {
+      unsigned lo = 0;
+      unsigned hi = 0;
+      const int n = std::sscanf(range.c_str(), "%u-%u", &lo, &hi);
+      if (n < 1) {
+        return false;
+      }
+      if (n == 1) {
+        hi = lo;
+      }
+      for (unsigned bit = lo; bit <= hi && bit < 64; ++bit, ++value_bit) {
+        if (value_bit < 64 && ((value >> value_bit) & 1) != 0) {
+          *word |= uint64_t{1} << bit;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+#else  // BENCHMARK_OS_LINUX
+
+const bool SamplingProfiler::kSupported = false;
+
+void SamplingProfiler::AfterSetupStart() {
+  if (chained_ != nullptr) {
+    chained_->AfterSetupStart();
+  }
+}
+
+void SamplingProfiler::BeforeTeardownStop() {
+  if (chained_ != nullptr) {
+    chained_->BeforeTeardownStop();
+  }
+}
+
+void SamplingProfiler::OnRecord(uint32_t, const char*, size_t) {}
+
+void MemoryAccessProfiler::AfterSetupStart() {
+  if (chained_ != nullptr) {
+    chained_->AfterSetupStart();
+  }
+}
+
+void MemoryAccessProfiler::BeforeTeardownStop() {
+  if (chained_ != nullptr) {
+    chained_->BeforeTeardownStop();
+  }
+}
+
+void MemoryAccessProfiler::OnRecord(uint32_t, const char*, size_t) {}
+
+bool MemoryAccessProfiler::EncodePmuEvent(const std::string&,
+                                          const std::string&, uint32_t*,
+                                          uint64_t*, uint64_t*) {
+  return false;
+}
+
+#endif  // BENCHMARK_OS_LINUX
+
+bool SamplingProfiler::WriteFoldedStacks(const std::string& path) const {
+  if (!kSupported) {
+    GetErrorLogInstance() << "Sampling profiler not supported.\n";
+    return false;
+  }
+  std::ofstream out;
+  if (!OpenProfileFile(path, &out)) {
+    return false;
+  }
+
+  // Distinct addresses often resolve to the same function, so merge the
+  // stacks again once symbolized.
+  Symbolizer symbolizer;
+  std::map<std::string, uint64_t> folded;
+  for (const auto& stack_and_count : stacks_) {
+    const std::vector<uint64_t>& stack = stack_and_count.first;
+    std::string line;
+    for (size_t i = stack.size(); i-- > 0;) {
+      // Apart from the sampled instruction itself, the frames hold return
+      // addresses, which may already belong to the next function.
+      const uint64_t addr = i == 0 ? stack[i] : stack[i] - 1;
+      if (!line.empty()) {
+        line += ';';
+      }
+      line += SanitizeFrame(symbolizer.Symbolize(addr));
+    }
+    folded[line] += stack_and_count.second;
+  }
+  for (const auto& line_and_count : folded) {
+    out << line_and_count.first << ' ' << line_and_count.second << '\n';
+  }
+  return static_cast<bool>(out);
+}
+
+std::string SamplingProfiler::OutputPath(const std::string& dir,
+                                         const std::string& benchmark_name,
+                                         int64_t repetition_index,
+                                         int64_t repetitions,
+                                         const std::string& extension) {
+  std::string file = benchmark_name;
+  for (char& c : file) {
+    const bool keep = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                      (c >= '0' && c <= '9') || c == '_' || c == '-' ||
+                      c == '.';
+    if (!keep) {
+      c = '_';
+    }
+  }
+  if (repetitions > 1) {
+    file += StrFormat(".rep%lld", static_cast<long long>(repetition_index));
+  }
+  return dir + "/" + file + extension;
+}
+
+void MemoryAccessProfiler::AddSample(uint64_t ip, uint64_t addr,
+                                     uint64_t latency, uint64_t data_src) {
+  ++num_samples_;
+  size_t bucket = 0;
+  for (uint64_t bound = 4; latency >= bound && bucket + 1 < kLatencyBuckets;
+       bound *= 2) {
+    ++bucket;
+  }
+  ++latency_histogram_[bucket];
+
+  auto account = [latency](Stats& stats) {
+    ++stats.samples;
+    stats.total_latency += latency;
+  };
+  account(sources_[DataSourceName(data_src)]);
+  account(tlb_[TlbName(data_src)]);
+  account(instructions_[ip]);
+  if (addr != 0) {
+    LineStats& line = lines_[addr & ~(kCacheLineSize - 1)];
+    account(line.stats);
+    ++line.offsets[static_cast<uint32_t>(addr & (kCacheLineSize - 1))];
+  }
+}
+
+namespace {
+
+// The `n` entries of `m` whose `total_latency(value)` is the largest.
+template <typename Key, typename Value, typename TotalLatency>
+std::vector<std::pair<Key, Value>> TopByLatency(const std::map<Key, Value>& m,
+                                                size_t n,
+                                                TotalLatency total_latency) {
+  std::vector<std::pair<Key, Value>> top(m.begin(), m.end());
+  auto total = [&](const std::pair<Key, Value>& kv) -> uint64_t {
+    return total_latency(kv.second);
+  };
+  std::sort(top.begin(), top.end(),
+            [&](const std::pair<Key, Value>& a,
+                const std::pair<Key, Value>& b) {
+              return total(a) > total(b);
+            });
+  if (top.size() > n) {
+    top.resize(n);
+  }
+  return top;
+}
+
+double Percent(uint64_t part, uint64_t whole) {
+  return whole == 0 ? 0.0
+                    : 100.0 * static_cast<double>(part) /
+                          static_cast<double>(whole);
+}
+
+double Average(uint64_t total, uint64_t count) {
+  return count == 0 ? 0.0
+                    : static_cast<double>(total) / static_cast<double>(count);
+}
+
+}  // namespace
+
+bool MemoryAccessProfiler::WriteReport(
+    const std::string& path, const std::string& benchmark_name) const {
+  std::ofstream out;
+  if (!OpenProfileFile(path, &out)) {
+    return false;
+  }
+  out << "Memory access samples for " << benchmark_name << "\n"
+      << "event: "
+      << (event_description_.empty() ? "none" : event_description_) << "\n"
+      << "samples: " << num_samples_ << ", lost: " << sampler_.lost()
+      << "\n\n";
+
+  out << StrFormat("%-24s %10s %7s\n", "Load latency (cycles)", "Samples",
+                   "%");
+  for (size_t i = 0; i < kLatencyBuckets; ++i) {
+    const unsigned long long lo = i == 0 ? 0 : 2ULL << i;
+    const std::string range =
+        i + 1 == kLatencyBuckets ? StrFormat("[%llu, inf)", lo)
+                                 : StrFormat("[%llu, %llu)", lo, 4ULL << i);
+    out << StrFormat("%-24s %10llu %6.2f%%\n", range.c_str(),
+                     static_cast<unsigned long long>(latency_histogram_[i]),
+                     Percent(latency_histogram_[i], num_samples_));
+  }
+
+  auto stats_latency = [](const Stats& stats) { return stats.total_latency; };
+  auto write_breakdown = [&](const char* title,
+                             const std::map<std::string, Stats>& breakdown) {
+    out << StrFormat("\n%-24s %10s %7s %12s\n", title, "Samples", "%",
+                     "Avg latency");
+    for (const auto& kv :
+         TopByLatency(breakdown, breakdown.size(), stats_latency)) {
+      out << StrFormat("%-24s %10llu %6.2f%% %12.1f\n", kv.first.c_str(),
+                       static_cast<unsigned long long>(kv.second.samples),
+                       Percent(kv.second.samples, num_samples_),
+                       Average(kv.second.total_latency, kv.second.samples));
+    }
+  };
+  write_breakdown("Data source", sources_);
+  write_breakdown("dTLB", tlb_);
+
+  out << StrFormat("\n%-24s %10s %12s %14s  %s\n", "Cache line", "Samples",
+                   "Avg latency", "Total latency", "Hot offsets");
+  for (const auto& kv :
+       TopByLatency(lines_, kTopEntries, [](const LineStats& line) {
+         return line.stats.total_latency;
+       })) {
+    const LineStats& line = kv.second;
+    std::vector<std::pair<uint32_t, uint64_t>> offsets(line.offsets.begin(),
+                                                       line.offsets.end());
+    std::sort(offsets.begin(), offsets.end(),
+              [](const std::pair<uint32_t, uint64_t>& a,
+                 const std::pair<uint32_t, uint64_t>& b) {
+                return a.second > b.second;
+              });
+    std::string hot;
+    for (size_t i = 0; i < offsets.size() && i < 4; ++i) {
+      hot += StrFormat("%s+%u(%llu)", hot.empty() ? "" : " ", offsets[i].first,
+                       static_cast<unsigned long long>(offsets[i].second));
+    }
+    out << StrFormat("0x%-22llx %10llu %12.1f %14llu  %s\n",
+                     static_cast<unsigned long long>(kv.first),
+                     static_cast<unsigned long long>(line.stats.samples),
+                     Average(line.stats.total_latency, line.stats.samples),
+                     static_cast<unsigned long long>(line.stats.total_latency),
+                     hot.c_str());
+  }
+
+  Symbolizer symbolizer;
+  out << StrFormat("\n%-18s %10s %12s %14s  %s\n", "Load instruction",
+                   "Samples", "Avg latency", "Total latency", "Function");
+  for (const auto& kv :
+       TopByLatency(instructions_, kTopEntries, stats_latency)) {
+    out << StrFormat("0x%-16llx %10llu %12.1f %14llu  %s\n",
+                     static_cast<unsigned long long>(kv.first),
+                     static_cast<unsigned long long>(kv.second.samples),
+                     Average(kv.second.total_latency, kv.second.samples),
+                     static_cast<unsigned long long>(kv.second.total_latency),
+                     symbolizer.Symbolize(kv.first).c_str());
+  }
+  return static_cast<bool>(out);
+}
+
+}  // namespace internal
+}  // namespace benchmark
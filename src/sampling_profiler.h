@@ -0,0 +1,157 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCHMARK_SAMPLING_PROFILER_H_
+#define BENCHMARK_SAMPLING_PROFILER_H_
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "perf_counters.h"
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+// C4251: <symbol> needs to have dll-interface to be used by clients of class
+#pragma warning(disable : 4251)
+#endif
+
+namespace benchmark {
+namespace internal {
+
+// The profiler behind --benchmark_profile. It samples the user-space call
+// stacks of the calling thread during the profiling run of a benchmark and,
+// once the run is over, symbolizes them and writes them out in the "folded"
+// format understood by flamegraph.pl and most flamegraph viewers: one line
+// per distinct stack, frames from the outermost caller down separated by ';',
+// followed by the number of samples.
+//
+// Call chains are recovered through frame pointers, so binaries built with
+// -fno-omit-frame-pointer give the most complete stacks.
+class BENCHMARK_EXPORT SamplingProfiler final : public ProfilerManager {
+ public:
+  // True iff this platform supports sampling.
+  static const bool kSupported;
+
+  // Samples per second requested from the kernel.
+  static constexpr uint64_t kSampleFrequency = 4000;
+
+  // `chained`, if not null, is a user-registered manager whose hooks are run
+  // around the sampled region.
+  explicit SamplingProfiler(ProfilerManager* chained = nullptr)
+      : chained_(chained) {}
+
+  void AfterSetupStart() override;
+  void BeforeTeardownStop() override;
+
+  // Symbolize the collected stacks and write them to `path`. Returns false,
+  // logging why, if the file cannot be written.
+  bool WriteFoldedStacks(const std::string& path) const;
+
+  // Raw call stacks, innermost frame first, and how often each was sampled.
+  const std::map<std::vector<uint64_t>, uint64_t>& stacks() const {
+    return stacks_;
+  }
+  uint64_t num_samples() const { return num_samples_; }
+
+  // The file, under `dir`, the profile of one run of `benchmark_name` goes to,
+  // ending in `extension`. The name is sanitized so that e.g.
+  // "BM_Foo/8/threads:2" maps to a single file rather than a directory tree.
+  static std::string OutputPath(const std::string& dir,
+                                const std::string& benchmark_name,
+                                int64_t repetition_index, int64_t repetitions,
+                                const std::string& extension = ".folded");
+
+ private:
+  void OnRecord(uint32_t type, const char* data, size_t size);
+
+  ProfilerManager* const chained_;
+  PerfSampler sampler_;
+  std::map<std::vector<uint64_t>, uint64_t> stacks_;
+  std::vector<uint64_t> scratch_;
+  uint64_t num_samples_ = 0;
+};
+
+// The memory-access mode of --benchmark_profile. It records precise load
+// samples during the profiling run: Intel PEBS load-latency samples through
+// the PMU's `mem-loads` event, or AMD IBS op samples. Each sample carries the
+// load instruction, the data address, the latency in core cycles and where in
+// the memory hierarchy the data was found. The report breaks the loads down
+// by latency, data source and dTLB outcome, and lists the cache lines and load
+// instructions accounting for most of the latency.
+class BENCHMARK_EXPORT MemoryAccessProfiler final : public ProfilerManager {
+ public:
+  static constexpr uint64_t kCacheLineSize = 64;
+  // Number of cache lines and instructions listed in the report.
+  static constexpr size_t kTopEntries = 16;
+  // Power-of-two latency buckets: [0, 4), [4, 8), ..., [2048, inf).
+  static constexpr size_t kLatencyBuckets = 11;
+
+  explicit MemoryAccessProfiler(ProfilerManager* chained = nullptr)
+      : chained_(chained) {}
+
+  void AfterSetupStart() override;
+  void BeforeTeardownStop() override;
+
+  // Account one load. `data_src` is encoded as perf_mem_data_src.
+  void AddSample(uint64_t ip, uint64_t addr, uint64_t latency,
+                 uint64_t data_src);
+
+  // Write the report for `benchmark_name` to `path`. Returns false, logging
+  // why, if the file cannot be written.
+  bool WriteReport(const std::string& path,
+                   const std::string& benchmark_name) const;
+
+  uint64_t num_samples() const { return num_samples_; }
+
+  // Encode `event`, as listed in the `events` directory of the PMU at
+  // `pmu_dir` in sysfs, through the PMU's `format` descriptions.
+  static bool EncodePmuEvent(const std::string& pmu_dir,
+                             const std::string& event, uint32_t* type,
+                             uint64_t* config, uint64_t* config1);
+
+ private:
+  struct Stats {
+    uint64_t samples = 0;
+    uint64_t total_latency = 0;
+  };
+  struct LineStats {
+    Stats stats;
+    std::map<uint32_t, uint64_t> offsets;  // offset in line -> samples
+  };
+
+  void OnRecord(uint32_t type, const char* data, size_t size);
+
+  ProfilerManager* const chained_;
+  PerfSampler sampler_;
+  std::string event_description_;
+  uint64_t num_samples_ = 0;
+  std::array<uint64_t, kLatencyBuckets> latency_histogram_{};
+  std::map<std::string, Stats> sources_;
+  std::map<std::string, Stats> tlb_;
+  std::map<uint64_t, LineStats> lines_;
+  std::map<uint64_t, Stats> instructions_;
+};
+
+}  // namespace internal
+}  // namespace benchmark
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif  // BENCHMARK_SAMPLING_PROFILER_H_
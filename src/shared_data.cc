@@ -0,0 +1,121 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "shared_data.h"
+
+#include "timers.h"
+
+namespace benchmark {
+namespace internal {
+
+std::shared_ptr<const void> SharedDataCache::Get(
+    const std::string& key, const SharedDataBuilder& build) {
+  std::shared_ptr<Entry> entry;
+  {
+    MutexLock l(mutex_);
+    std::shared_ptr<Entry>& slot = entries_[key];
+    if (slot == nullptr) {
+      slot = std::make_shared<Entry>();
+    }
+    entry = slot;
+    entry->last_use = ++clock_;
+    if (entry->data != nullptr) {
+      ++stats_.hits;
+      return entry->data;
+    }
+  }
+
+  MutexLock build_lock(entry->build_mutex);
+  {
+    // Another caller may have built it while we waited.
+    MutexLock l(mutex_);
+    if (entry->data != nullptr) {
+      ++stats_.hits;
+      return entry->data;
+    }
+  }
+  const double start = ChronoClockNow();
+  size_t bytes = 0;
+  std::shared_ptr<const void> data = build(&bytes);
+  const double seconds = ChronoClockNow() - start;
+
+  MutexLock l(mutex_);
+  entry->data = data;
+  entry->bytes = bytes;
+  ++stats_.misses;
+  ++stats_.entries;
+  stats_.bytes += bytes;
+  stats_.build_seconds += seconds;
+  EvictLocked(entry.get());
+  return data;
+}
+
+void SharedDataCache::EvictLocked(const Entry* keep) {
+  while (budget_ != 0 && stats_.bytes > budget_) {
+    Entry* victim = nullptr;
+    for (auto& kv : entries_) {
+      Entry* entry = kv.second.get();
+      if (entry != keep && entry->data != nullptr &&
+          (victim == nullptr || entry->last_use < victim->last_use)) {
+        victim = entry;
+      }
+    }
+    if (victim == nullptr) {
+      // Only 'keep' is left, which stays even if over budget on its own.
+      return;
+    }
+    // The entry stays, so that a caller waiting to build it still updates
+    // the cache.
+    victim->data.reset();
+    stats_.bytes -= victim->bytes;
+    victim->bytes = 0;
+    --stats_.entries;
+    ++stats_.evictions;
+  }
+}
+
+void SharedDataCache::SetBudget(size_t bytes) {
+  MutexLock l(mutex_);
+  budget_ = bytes;
+  EvictLocked(nullptr);
+}
+
+SharedDataStats SharedDataCache::stats() {
+  MutexLock l(mutex_);
+  return stats_;
+}
+
+void SharedDataCache::Clear() {
+  MutexLock l(mutex_);
+  entries_.clear();
+  stats_ = SharedDataStats();
+}
+
+SharedDataCache& GetSharedDataCache() {
+  static SharedDataCache* cache = new SharedDataCache();
+  return *cache;
+}
+
+std::shared_ptr<const void> GetSharedData(const std::string& key,
+                                          const SharedDataBuilder& build) {
+  return GetSharedDataCache().Get(key, build);
+}
+
+}  // namespace internal
+
+SharedDataStats GetSharedDataStats() {
+  return internal::GetSharedDataCache().stats();
+}
+
+}  // namespace benchmark
@@ -0,0 +1,87 @@
+// Copyright 2025 Google Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCHMARK_SHARED_DATA_H_
+#define BENCHMARK_SHARED_DATA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "mutex.h"
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+// C4251: <symbol> needs to have dll-interface to be used by clients of class
+#pragma warning(disable : 4251)
+#endif
+
+namespace benchmark {
+namespace internal {
+
+// The datasets handed out by SharedData(), keyed by name. Building happens
+// outside of the cache lock, so that a slow build only holds up the callers
+// asking for the same key.
+class BENCHMARK_EXPORT SharedDataCache {
+ public:
+  SharedDataCache() = default;
+
+  SharedDataCache(const SharedDataCache&) = delete;
+  SharedDataCache& operator=(const SharedDataCache&) = delete;
+
+  // The dataset cached under 'key', built with 'build' if there is none.
+  std::shared_ptr<const void> Get(const std::string& key,
+                                  const SharedDataBuilder& build);
+
+  // Evict the least recently used datasets whenever the cached ones take
+  // more than 'bytes'; 0 for no limit.
+  void SetBudget(size_t bytes);
+
+  SharedDataStats stats();
+
+  // Drop every dataset and reset the statistics.
+  // REQUIRES: No Get() is in progress.
+  void Clear();
+
+ private:
+  struct Entry {
+    Mutex build_mutex;  // Held while the dataset is being built.
+    std::shared_ptr<const void> data;
+    size_t bytes = 0;
+    uint64_t last_use = 0;
+  };
+
+  void EvictLocked(const Entry* keep) REQUIRES(mutex_);
+
+  Mutex mutex_;
+  std::map<std::string, std::shared_ptr<Entry>> entries_ GUARDED_BY(mutex_);
+  size_t budget_ GUARDED_BY(mutex_) = 0;
+  uint64_t clock_ GUARDED_BY(mutex_) = 0;
+  SharedDataStats stats_ GUARDED_BY(mutex_);
+};
+
+// The cache used by SharedData().
+BENCHMARK_EXPORT SharedDataCache& GetSharedDataCache();
+
+}  // namespace internal
+}  // namespace benchmark
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+#endif  // BENCHMARK_SHARED_DATA_H_
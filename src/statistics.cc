@@ -23,6 +23,7 @@
 
 #include "benchmark/benchmark.h"
 #include "check.h"
+#include "counter.h"
 
 namespace benchmark {
 
@@ -132,6 +133,8 @@ std::vector<BenchmarkReporter::Run> ComputeStats(
   struct CounterStat {
     Counter c;
     std::vector<double> s;
+    // The pooled samples of a kDistribution counter.
+    std::vector<double> samples;
   };
   std::map<std::string, CounterStat> counter_stats;
   for (Run const& r : reports) {
@@ -140,11 +143,13 @@ std::vector<BenchmarkReporter::Run> ComputeStats(
       if (it == counter_stats.end()) {
         it = counter_stats
                  .emplace(cnt.first,
-                          CounterStat{cnt.second, std::vector<double>{}})
+                          CounterStat{cnt.second, std::vector<double>{},
+                                      std::vector<double>{}})
                  .first;
         it->second.s.reserve(reports.size());
       } else {
         BM_CHECK_EQ(it->second.c.flags, cnt.second.flags);
+        BM_CHECK_EQ(it->second.c.aggregation, cnt.second.aggregation);
       }
     }
   }
@@ -163,6 +168,15 @@ std::vector<BenchmarkReporter::Run> ComputeStats(
       auto it = counter_stats.find(cnt.first);
       BM_CHECK_NE(it, counter_stats.end());
       it->second.s.emplace_back(cnt.second);
+      if (cnt.second.aggregation == Counter::kDistribution) {
+        if (cnt.second.samples.empty()) {
+          it->second.samples.push_back(cnt.second.value);
+        } else {
+          it->second.samples.insert(it->second.samples.end(),
+                                    cnt.second.samples.begin(),
+                                    cnt.second.samples.end());
+        }
+      }
     }
   }
 
@@ -191,6 +205,8 @@ std::vector<BenchmarkReporter::Run> ComputeStats(
     data.aggregate_name = Stat.name_;
     data.aggregate_unit = Stat.unit_;
     data.report_label = report_label;
+    data.buffer_policy = reports[0].buffer_policy;
+    data.args = reports[0].args;
 
     // It is incorrect to say that an aggregate is computed over
     // run's iterations, because those iterations already got averaged.
@@ -218,9 +234,23 @@ std::vector<BenchmarkReporter::Run> ComputeStats(
     for (auto const& kv : counter_stats) {
       // Do *NOT* rescale the custom counters. They are already properly scaled.
       const auto uc_stat = Stat.compute_(kv.second.s);
-      auto c = Counter(uc_stat, counter_stats[kv.first].c.flags,
-                       counter_stats[kv.first].c.oneK);
-      data.counters[kv.first] = c;
+      data.counters[kv.first] = Counter(uc_stat, kv.second.c.flags,
+                                        kv.second.c.oneK,
+                                        kv.second.c.aggregation);
+    }
+    // The mean and median percentiles of a distribution are those of the
+    // pooled samples of all repetitions; the other aggregates, such as the
+    // stddev, are taken over the percentiles of each repetition as usual.
+    if (Stat.compute_ == &StatisticsMean ||
+        Stat.compute_ == &StatisticsMedian) {
+      for (auto const& kv : counter_stats) {
+        if (kv.second.samples.empty()) {
+          continue;
+        }
+        Counter pooled = kv.second.c;
+        pooled.samples = kv.second.samples;
+        internal::AddPercentiles(kv.first, pooled, &data.counters);
+      }
     }
 
     results.push_back(data);
@@ -28,6 +28,7 @@ class ThreadManager {
     double manual_time_used = 0;
     int64_t complexity_n = 0;
     std::string report_label_;
+    std::string buffer_policy_;
     std::string skip_message_;
     internal::Skipped skipped_ = internal::NotSkipped;
     UserCounters counters;
@@ -0,0 +1,120 @@
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../src/adaptive_range.h"
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+using benchmark::internal::AdaptiveRangeExplorer;
+
+// Runs the exploration of [lo, hi] against the time per item 'f'.
+AdaptiveRangeExplorer Explore(int64_t lo, int64_t hi, int budget,
+                              const std::function<double(int64_t)>& f,
+                              int* num_points) {
+  AdaptiveRangeExplorer explorer(budget);
+  std::vector<int64_t> points =
+      AdaptiveRangeExplorer::InitialPoints(lo, hi, budget, 8);
+  *num_points = 0;
+  while (!points.empty()) {
+    for (int64_t x : points) {
+      explorer.AddMeasurement(x, f(x));
+    }
+    *num_points += static_cast<int>(points.size());
+    points = explorer.NextPoints();
+  }
+  return explorer;
+}
+
+TEST(AdaptiveRangeTest, InitialPointsFitTheBudget) {
+  EXPECT_EQ(AdaptiveRangeExplorer::InitialPoints(1, 4096, 100, 8),
+            std::vector<int64_t>({1, 8, 64, 512, 4096}));
+  EXPECT_EQ(AdaptiveRangeExplorer::InitialPoints(1, 4096, 6, 8),
+            std::vector<int64_t>({1, 64, 4096}));
+  EXPECT_EQ(AdaptiveRangeExplorer::InitialPoints(1, 4096, 2, 8),
+            std::vector<int64_t>({1, 4096}));
+}
+
+TEST(AdaptiveRangeTest, LocatesAStep) {
+  int num_points = 0;
+  AdaptiveRangeExplorer explorer = Explore(
+      1, 1 << 20, 40, [](int64_t x) { return x < 3000 ? 1.0 : 3.0; },
+      &num_points);
+  const auto cliffs = explorer.Cliffs();
+  ASSERT_EQ(cliffs.size(), 1u);
+  EXPECT_EQ(cliffs[0].from, 2999);
+  EXPECT_EQ(cliffs[0].to, 3000);
+  EXPECT_DOUBLE_EQ(cliffs[0].time_before, 1.0);
+  EXPECT_DOUBLE_EQ(cliffs[0].time_after, 3.0);
+  EXPECT_LE(num_points, 40);
+}
+
+TEST(AdaptiveRangeTest, LeavesSmoothRangesAlone) {
+  int num_points = 0;
+  AdaptiveRangeExplorer explorer = Explore(
+      1, 1 << 20, 40,
+      [](int64_t x) { return 1.0 + 1e-9 * static_cast<double>(x); },
+      &num_points);
+  EXPECT_TRUE(explorer.Cliffs().empty());
+  EXPECT_EQ(num_points, 8);
+}
+
+TEST(AdaptiveRangeTest, StaysWithinBudget) {
+  int num_points = 0;
+  // Cliffs everywhere: only the budget stops the exploration.
+  AdaptiveRangeExplorer explorer = Explore(
+      1, 1000001, 20, [](int64_t x) { return x % 2 == 0 ? 1.0 : 2.0; },
+      &num_points);
+  EXPECT_EQ(num_points, 20);
+  EXPECT_FALSE(explorer.Cliffs().empty());
+}
+
+class CliffReporter : public benchmark::ConsoleReporter {
+ public:
+  bool ReportContext(const Context& /*unused*/) override { return true; }
+  void ReportRuns(const std::vector<Run>& runs) override {
+    for (const Run& run : runs) {
+      if (run.run_type == Run::RT_Aggregate) {
+        cliffs.push_back(run);
+      } else {
+        ++num_runs;
+      }
+    }
+  }
+
+  int num_runs = 0;
+  std::vector<Run> cliffs;
+};
+
+TEST(AdaptiveRangeTest, ReportsCliffs) {
+  benchmark::RegisterBenchmark(
+      "BM_Cliff",
+      [](benchmark::State& state) {
+        const int64_t x = state.range(0);
+        const double per_item = x < 5000 ? 1e-9 : 4e-9;
+        for (auto _ : state) {
+          state.SetIterationTime(per_item * static_cast<double>(x));
+        }
+      })
+      ->ArgName("size")
+      ->AdaptiveRange(64, 1 << 16, 30)
+      ->UseManualTime()
+      ->Iterations(1);
+  CliffReporter reporter;
+  const size_t num_benchmarks = benchmark::RunSpecifiedBenchmarks(&reporter);
+  benchmark::ClearRegisteredBenchmarks();
+
+  EXPECT_EQ(num_benchmarks, static_cast<size_t>(reporter.num_runs));
+  EXPECT_LE(reporter.num_runs, 30);
+  ASSERT_EQ(reporter.cliffs.size(), 1u);
+  const auto& cliff = reporter.cliffs[0];
+  EXPECT_EQ(cliff.aggregate_name, "cliff");
+  EXPECT_EQ(cliff.run_name.args, "size:4999..5000");
+  EXPECT_NEAR(cliff.counters.at("ratio").value, 4.0, 1e-6);
+  EXPECT_NEAR(cliff.GetAdjustedRealTime(), 4.0, 1e-6);
+}
+
+}  // namespace
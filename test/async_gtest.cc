@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../src/async_runner.h"
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+
+namespace benchmark {
+namespace {
+
+// An in-process stand-in for a remote service: each call completes on the
+// service's own thread once 'latency' has passed, however many are pending.
+class StandInService {
+ public:
+  explicit StandInService(std::chrono::microseconds latency)
+      : latency_(latency), thread_([this]() { Serve(); }) {}
+
+  ~StandInService() {
+    {
+      std::lock_guard<std::mutex> l(mutex_);
+      stopping_ = true;
+    }
+    cond_.notify_one();
+    thread_.join();
+  }
+
+  void Call(AsyncDone done) {
+    {
+      std::lock_guard<std::mutex> l(mutex_);
+      pending_.emplace_back(std::chrono::steady_clock::now() + latency_,
+                            std::move(done));
+      max_pending_ = std::max(max_pending_, pending_.size());
+    }
+    cond_.notify_one();
+  }
+
+  size_t max_pending() {
+    std::lock_guard<std::mutex> l(mutex_);
+    return max_pending_;
+  }
+
+ private:
+  using PendingCall =
+      std::pair<std::chrono::steady_clock::time_point, AsyncDone>;
+
+  void Serve() {
+    std::unique_lock<std::mutex> l(mutex_);
+    for (;;) {
+      cond_.wait(l, [this]() { return stopping_ || !pending_.empty(); });
+      if (pending_.empty()) {
+        return;
+      }
+      // Calls all take as long, so the oldest is always due first.
+      const auto due = pending_.front().first;
+      if (cond_.wait_until(l, due) != std::cv_status::timeout &&
+          std::chrono::steady_clock::now() < due) {
+        continue;
+      }
+      AsyncDone done = std::move(pending_.front().second);
+      pending_.pop_front();
+      l.unlock();
+      done();
+      l.lock();
+    }
+  }
+
+  const std::chrono::microseconds latency_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<PendingCall> pending_;
+  size_t max_pending_ = 0;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+TEST(AsyncExecutorTest, RunsEveryTask) {
+  std::atomic<int> sum(0);
+  {
+    internal::AsyncExecutor executor(3);
+    for (int i = 1; i <= 100; ++i) {
+      executor.Post([&sum, i]() { sum += i; });
+    }
+  }
+  EXPECT_EQ(sum, 5050);
+}
+
+TEST(AsyncRunTest, KeepsTheTargetInFlight) {
+  StandInService service(std::chrono::microseconds(500));
+  internal::AsyncExecutor executor(2);
+  const internal::AsyncResult result = internal::RunAsyncOperations(
+      200, 8, [&](AsyncDone done) { service.Call(std::move(done)); },
+      executor);
+  EXPECT_EQ(result.completed, 200);
+  EXPECT_LE(service.max_pending(), 8u);
+  // Every operation takes at least the latency of the service.
+  EXPECT_GE(result.total_latency, 200 * 500e-6);
+  EXPECT_GE(result.seconds, 200 / 8 * 500e-6);
+}
+
+TEST(AsyncRunTest, CompletesInlineOperations) {
+  int calls = 0;
+  internal::AsyncExecutor executor(1);
+  const internal::AsyncResult result = internal::RunAsyncOperations(
+      1000, 4,
+      [&](AsyncDone done) {
+        ++calls;
+        done();
+      },
+      executor);
+  EXPECT_EQ(result.completed, 1000);
+  EXPECT_EQ(calls, 1000);
+}
+
+TEST(AsyncRunTest, CompletesFromForeignThreads) {
+  // Each done() runs on a thread of its own, which may still be inside it
+  // when the last operation completes. Many short runs give the teardown
+  // every chance to race with it.
+  for (int run = 0; run < 50; ++run) {
+    std::mutex mutex;
+    std::vector<std::thread> threads;
+    internal::AsyncResult result;
+    {
+      internal::AsyncExecutor executor(2);
+      result = internal::RunAsyncOperations(
+          20, 4,
+          [&](AsyncDone done) {
+            std::lock_guard<std::mutex> l(mutex);
+            threads.emplace_back(std::move(done));
+          },
+          executor);
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(result.completed, 20);
+    EXPECT_EQ(threads.size(), 20u);
+  }
+}
+
+class RunsReporter : public ConsoleReporter {
+ public:
+  bool ReportContext(const Context& /*unused*/) override { return true; }
+  void ReportRuns(const std::vector<Run>& report) override {
+    runs.insert(runs.end(), report.begin(), report.end());
+  }
+
+  std::vector<Run> runs;
+};
+
+TEST(AsyncRunTest, ReportsThroughputLatencyAndConcurrency) {
+  RegisterBenchmark("BM_Async", [](State& state) {
+    StandInService service(std::chrono::microseconds(1000));
+    state.RunAsync(static_cast<int>(state.range(0)), [&](AsyncDone done) {
+      service.Call(std::move(done));
+    });
+  })
+      ->Arg(16)
+      ->Iterations(320)
+      ->UseRealTime();
+  RunsReporter reporter;
+  RunSpecifiedBenchmarks(&reporter);
+  ClearRegisteredBenchmarks();
+
+  ASSERT_EQ(reporter.runs.size(), 1u);
+  const BenchmarkReporter::Run& run = reporter.runs[0];
+  EXPECT_EQ(run.iterations, 320);
+  const UserCounters& counters = run.counters;
+  EXPECT_GE(counters.at("latency_p50").value, 1e-3);
+  EXPECT_LE(counters.at("latency_p50").value,
+            counters.at("latency_p99").value);
+  // At most 16 operations of 1ms each complete per millisecond.
+  EXPECT_LE(counters.at("ops_per_second").value, 16 / 1e-3);
+  EXPECT_GT(counters.at("ops_per_second").value, 0);
+  EXPECT_LE(counters.at("in_flight").value, 16.01);
+  EXPECT_GT(counters.at("in_flight").value, 1);
+}
+
+}  // namespace
+}  // namespace benchmark
@@ -0,0 +1,79 @@
+#include <cstdint>
+#include <vector>
+
+#include "../src/batch_histogram.h"
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+
+namespace benchmark {
+namespace {
+
+TEST(BatchHistogramTest, SmallValuesAreExact) {
+  std::vector<uint64_t> buckets;
+  for (uint64_t t = 1; t <= 10; ++t) {
+    internal::AddBatchTicks(&buckets, t);
+  }
+  EXPECT_EQ(buckets.size(), internal::kBatchHistogramBuckets);
+  EXPECT_EQ(internal::BatchTicksPercentile(buckets, 0.5), 5);
+  EXPECT_EQ(internal::BatchTicksPercentile(buckets, 0.9), 9);
+  EXPECT_EQ(internal::BatchTicksPercentile(buckets, 0), 1);
+  EXPECT_EQ(internal::BatchTicksMax(buckets), 10);
+}
+
+TEST(BatchHistogramTest, LargeValuesAreClose) {
+  std::vector<uint64_t> buckets;
+  for (uint64_t t = 1000; t < 2000; ++t) {
+    internal::AddBatchTicks(&buckets, t);
+  }
+  internal::AddBatchTicks(&buckets, uint64_t{1} << 40);
+  EXPECT_NEAR(internal::BatchTicksPercentile(buckets, 0.5), 1500, 1500 / 16.);
+  EXPECT_NEAR(internal::BatchTicksPercentile(buckets, 0.99), 1990, 1990 / 16.);
+  EXPECT_NEAR(internal::BatchTicksMax(buckets), 1099511627776.,
+              1099511627776. / 16);
+}
+
+class RunsReporter : public ConsoleReporter {
+ public:
+  bool ReportContext(const Context& /*unused*/) override { return true; }
+  void ReportRuns(const std::vector<Run>& report) override {
+    runs.insert(runs.end(), report.begin(), report.end());
+  }
+
+  std::vector<Run> runs;
+};
+
+TEST(BatchesTest, RunsWholeBatchesAndReportsTheirTimes) {
+  RegisterBenchmark("BM_Batches", [](State& state) {
+    int64_t batches = 0;
+    int64_t x = 0;
+    for (auto batch : state.Batches<64>()) {
+      for (IterationCount i = 0; i < batch.size(); ++i) {
+        DoNotOptimize(x += i);
+      }
+      ++batches;
+    }
+    state.counters["batches"] = static_cast<double>(batches);
+  })
+      ->Iterations(1000)
+      ->Threads(2);
+  RunsReporter reporter;
+  RunSpecifiedBenchmarks(&reporter);
+  ClearRegisteredBenchmarks();
+
+  ASSERT_EQ(reporter.runs.size(), 1u);
+  const BenchmarkReporter::Run& run = reporter.runs[0];
+  // 1000 iterations round up to 16 batches of 64, on each thread.
+  EXPECT_EQ(run.iterations, 2 * 1024);
+  EXPECT_EQ(run.counters.at("batches").value, 2 * 16);
+  const double p50 = run.counters.at("batch_p50").value;
+  EXPECT_GT(p50, 0);
+  EXPECT_LE(p50, run.counters.at("batch_p90").value);
+  EXPECT_LE(run.counters.at("batch_p90").value,
+            run.counters.at("batch_p99").value);
+  EXPECT_LE(run.counters.at("batch_p99").value,
+            run.counters.at("batch_max").value);
+  EXPECT_LT(p50, 1e-3);
+}
+
+}  // namespace
+}  // namespace benchmark
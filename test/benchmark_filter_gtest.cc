@@ -0,0 +1,169 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/benchmark_api_internal.h"
+#include "../src/benchmark_filter.h"
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+
+namespace benchmark {
+namespace internal {
+namespace {
+
+void BM_Nop(State& state) {
+  for (auto _ : state) {
+  }
+}
+
+TEST(GlobMatchTest, Wildcards) {
+  EXPECT_TRUE(GlobMatch("BM_Copy", "BM_Copy"));
+  EXPECT_FALSE(GlobMatch("BM_Copy", "BM_CopyFast"));
+  EXPECT_TRUE(GlobMatch("BM_Copy*", "BM_CopyFast"));
+  EXPECT_TRUE(GlobMatch("BM_Copy*", "BM_Copy"));
+  EXPECT_TRUE(GlobMatch("*Fast", "BM_CopyFast"));
+  EXPECT_TRUE(GlobMatch("BM_*y*t", "BM_CopyFast"));
+  EXPECT_FALSE(GlobMatch("BM_*y*x", "BM_CopyFast"));
+  EXPECT_TRUE(GlobMatch("BM_Cop?", "BM_Copy"));
+  EXPECT_FALSE(GlobMatch("BM_Cop?", "BM_Cop"));
+  EXPECT_TRUE(GlobMatch("*", ""));
+}
+
+class BenchmarkFilterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    RegisterBenchmark("BM_Copy", BM_Nop)
+        ->ArgNames({"size", "stride"})
+        ->ArgsProduct({{1024, 4096, 65536}, {1, 8}})
+        ->ThreadRange(1, 2);
+    RegisterBenchmark("BM_CopySlow", BM_Nop)
+        ->ArgName("size")
+        ->Arg(4096);
+    RegisterBenchmark("BM_Fill", BM_Nop)->Arg(4096)->Arg(8192);
+  }
+  void TearDown() override { ClearRegisteredBenchmarks(); }
+
+  std::vector<std::string> Select(const std::string& select) {
+    std::string error;
+    std::unique_ptr<BenchmarkFilter> filter =
+        BenchmarkFilter::Create("", select, &error);
+    EXPECT_NE(filter, nullptr) << error;
+    std::vector<std::string> names;
+    if (filter == nullptr) {
+      return names;
+    }
+    BenchmarkInstanceGenerator generator(filter.get());
+    std::vector<BenchmarkInstance> instances;
+    generator.Next(1000, &instances);
+    for (const auto& instance : instances) {
+      names.push_back(instance.name().str());
+    }
+    return names;
+  }
+
+  std::string Error(const std::string& select) {
+    std::string error;
+    EXPECT_EQ(BenchmarkFilter::Create("", select, &error), nullptr) << select;
+    return error;
+  }
+};
+
+TEST_F(BenchmarkFilterTest, Globs) {
+  EXPECT_EQ(Select("BM_Fill"),
+            std::vector<std::string>({"BM_Fill/4096", "BM_Fill/8192"}));
+  EXPECT_EQ(Select("BM_Copy* && !BM_Copy"),
+            std::vector<std::string>({"BM_CopySlow/size:4096"}));
+  EXPECT_EQ(Select("'BM_Fill' or BM_CopyS*").size(), 3u);
+  EXPECT_EQ(Select("except BM_Copy*"),
+            std::vector<std::string>({"BM_Fill/4096", "BM_Fill/8192"}));
+  EXPECT_EQ(Select("except BM_Copy, BM_Fill"),
+            std::vector<std::string>({"BM_CopySlow/size:4096"}));
+}
+
+TEST_F(BenchmarkFilterTest, Comparisons) {
+  EXPECT_EQ(Select("size>=4096 && stride==8 && threads>1"),
+            std::vector<std::string>(
+                {"BM_Copy/size:4096/stride:8/threads:2",
+                 "BM_Copy/size:65536/stride:8/threads:2"}));
+  // Unnamed arguments are found by position, and a comparison on an
+  // argument an instance doesn't have is false.
+  EXPECT_EQ(Select("arg0 > 4096"),
+            std::vector<std::string>(
+                {"BM_Copy/size:65536/stride:1/threads:1",
+                 "BM_Copy/size:65536/stride:1/threads:2",
+                 "BM_Copy/size:65536/stride:8/threads:1",
+                 "BM_Copy/size:65536/stride:8/threads:2", "BM_Fill/8192"}));
+  EXPECT_EQ(Select("not stride = 1 except BM_Copy"),
+            std::vector<std::string>({"BM_CopySlow/size:4096", "BM_Fill/4096",
+                                      "BM_Fill/8192"}));
+  EXPECT_EQ(Select("(BM_Fill || size < 2048) and (threads == 1)"),
+            std::vector<std::string>({"BM_Copy/size:1024/stride:1/threads:1",
+                                      "BM_Copy/size:1024/stride:8/threads:1",
+                                      "BM_Fill/4096", "BM_Fill/8192"}));
+}
+
+TEST_F(BenchmarkFilterTest, ComparesTypedAxesByValue) {
+  enum class Probe { kLinear, kQuadratic };
+  RegisterBenchmark("BM_Lookup", BM_Nop)
+      ->DoubleAxis("load", {0.5, 0.75, 0.9})
+      ->EnumAxis<Probe>("probe", {{Probe::kLinear, "linear"},
+                                  {Probe::kQuadratic, "quadratic"}});
+  // Doubles compare by value, not by their position in the axis.
+  EXPECT_EQ(Select("load>=0.75 && probe==linear"),
+            std::vector<std::string>({"BM_Lookup/load:0.75/probe:linear",
+                                      "BM_Lookup/load:0.9/probe:linear"}));
+  EXPECT_EQ(Select("load>=1"), std::vector<std::string>());
+  EXPECT_EQ(Select("load==0.5 && probe!='quadratic'"),
+            std::vector<std::string>({"BM_Lookup/load:0.5/probe:linear"}));
+  // Enums compare by name, not by the value of the enumerator.
+  EXPECT_EQ(Select("probe==0"), std::vector<std::string>());
+  EXPECT_EQ(Error("probe<linear"),
+            "Could not parse benchmark selection: expected a number after "
+            "'<' at offset 6");
+}
+
+TEST_F(BenchmarkFilterTest, RejectsFamiliesEarly) {
+  std::string error;
+  std::unique_ptr<BenchmarkFilter> filter =
+      BenchmarkFilter::Create("", "BM_Copy* && size > 1 except *Slow", &error);
+  ASSERT_NE(filter, nullptr) << error;
+  EXPECT_TRUE(filter->MatchesFamily("BM_Copy"));
+  EXPECT_FALSE(filter->MatchesFamily("BM_CopySlow"));
+  EXPECT_FALSE(filter->MatchesFamily("BM_Fill"));
+}
+
+TEST_F(BenchmarkFilterTest, CombinesWithRegex) {
+  std::string error;
+  std::unique_ptr<BenchmarkFilter> filter =
+      BenchmarkFilter::Create("stride:8", "threads == 2", &error);
+  ASSERT_NE(filter, nullptr) << error;
+  BenchmarkInstanceGenerator generator(filter.get());
+  std::vector<BenchmarkInstance> instances;
+  EXPECT_EQ(generator.Next(1000, &instances), 3u);
+}
+
+TEST_F(BenchmarkFilterTest, ReportsSyntaxErrors) {
+  EXPECT_EQ(Error("size >="),
+            "Could not parse benchmark selection: expected a number after "
+            "'>=' at offset 7");
+  EXPECT_EQ(Error("(BM_Copy"),
+            "Could not parse benchmark selection: unbalanced '(' at offset 0");
+  EXPECT_EQ(Error("BM_Copy BM_Fill"),
+            "Could not parse benchmark selection: unexpected 'BM_Fill' at "
+            "offset 8");
+  EXPECT_EQ(Error("size > 4k"),
+            "Could not parse benchmark selection: expected a number after "
+            "'>' at offset 7");
+  EXPECT_EQ(Error("BM_* & size"),
+            "Could not parse benchmark selection: unexpected '&' at offset 5");
+  EXPECT_EQ(Error("BM_Copy except"),
+            "Could not parse benchmark selection: expected a family name "
+            "after 'except' at offset 14");
+  EXPECT_EQ(Error("'BM_Copy"),
+            "Could not parse benchmark selection: unterminated quote at "
+            "offset 0");
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace benchmark
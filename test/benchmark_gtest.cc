@@ -135,6 +135,69 @@ TEST(AddRangeTest, Simple8) {
               testing::ElementsAre(int8_t{1}, int8_t{2}, int8_t{4}, int8_t{8}));
 }
 
+TEST(WorkingSetPointsTest, Hierarchy) {
+  const std::vector<CPUInfo::CacheInfo> caches = {
+      {"Data", 1, 32 << 10, 2},
+      {"Instruction", 1, 32 << 10, 2},
+      {"Unified", 2, 1 << 20, 2},
+      {"Unified", 3, 32 << 20, 16}};
+  EXPECT_THAT(
+      WorkingSetPoints(caches, 1),
+      testing::ElementsAre(
+          testing::Pair(16384, "L1"), testing::Pair(29491, "L1"),
+          testing::Pair(49152, "L2"), testing::Pair(524288, "L2"),
+          testing::Pair(943718, "L2"), testing::Pair(1572864, "L3"),
+          testing::Pair(16777216, "L3"), testing::Pair(30198988, "L3"),
+          testing::Pair(50331648, "DRAM"), testing::Pair(134217728, "DRAM"),
+          testing::Pair(536870912, "DRAM")));
+
+  const auto points = WorkingSetPoints(caches, 8);
+  ASSERT_EQ(points.size(), 11u);
+  EXPECT_EQ(points.front(), std::make_pair(int64_t{2048}, std::string("L1")));
+  EXPECT_EQ(points.back(),
+            std::make_pair(int64_t{67108864}, std::string("DRAM")));
+}
+
+TEST(WorkingSetPointsTest, AssumesCachesWhenUnknown) {
+  const auto points = WorkingSetPoints({}, 1);
+  ASSERT_EQ(points.size(), 11u);
+  EXPECT_EQ(points.front().second, "L1");
+  EXPECT_EQ(points.back().second, "DRAM");
+}
+
+class LabelReporter : public ConsoleReporter {
+ public:
+  bool ReportContext(const Context& /*unused*/) override { return true; }
+  void ReportRuns(const std::vector<Run>& runs) override {
+    for (const Run& run : runs) {
+      labels.push_back(run.report_label);
+    }
+  }
+
+  std::vector<std::string> labels;
+};
+
+TEST(WorkingSetSweepTest, LabelsRunsWithTheLevel) {
+  RegisterBenchmark("BM_Sweep",
+                    [](State& state) {
+                      for (auto _ : state) {
+                      }
+                      if (state.range(0) == 0) {
+                        state.SetLabel("own");
+                      }
+                    })
+      ->Arg(0)
+      ->WorkingSetSweep(1 << 20)
+      ->Iterations(1);
+  LabelReporter reporter;
+  RunSpecifiedBenchmarks(&reporter);
+  ClearRegisteredBenchmarks();
+
+  ASSERT_GE(reporter.labels.size(), 2u);
+  EXPECT_EQ(reporter.labels.front(), "own");
+  EXPECT_EQ(reporter.labels.back(), "DRAM");
+}
+
 TEST(AddCustomContext, Simple) {
   std::map<std::string, std::string> *&global_context = GetGlobalContext();
   EXPECT_THAT(global_context, nullptr);
@@ -0,0 +1,164 @@
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/benchmark_api_internal.h"
+#include "../src/benchmark_filter.h"
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+
+namespace benchmark {
+namespace internal {
+namespace {
+
+void BM_Nop(State& state) {
+  for (auto _ : state) {
+  }
+}
+
+std::vector<std::string> Generate(const std::string& spec,
+                                  size_t batch_size = 3) {
+  std::string error;
+  std::unique_ptr<BenchmarkFilter> filter =
+      BenchmarkFilter::Create(spec, "", &error);
+  EXPECT_NE(filter, nullptr) << error;
+  BenchmarkInstanceGenerator generator(filter.get());
+  std::vector<std::string> names;
+  std::vector<BenchmarkInstance> instances;
+  while (!generator.Done()) {
+    generator.Next(batch_size, &instances);
+    for (const auto& instance : instances) {
+      names.push_back(instance.name().str());
+    }
+    instances.clear();
+  }
+  return names;
+}
+
+class BenchmarkInstanceGeneratorTest : public ::testing::Test {
+ protected:
+  void TearDown() override { ClearRegisteredBenchmarks(); }
+};
+
+TEST_F(BenchmarkInstanceGeneratorTest, KeepsRegistrationOrder) {
+  RegisterBenchmark("BM_A", BM_Nop)
+      ->ArgsProduct({{1, 2, 3}, {10, 20}})
+      ->Args({7, 70})
+      ->Threads(1)
+      ->Threads(2);
+  RegisterBenchmark("BM_B", BM_Nop);
+
+  EXPECT_EQ(Generate("."),
+            std::vector<std::string>({
+                "BM_A/1/10/threads:1",  "BM_A/1/10/threads:2",
+                "BM_A/2/10/threads:1",  "BM_A/2/10/threads:2",
+                "BM_A/3/10/threads:1",  "BM_A/3/10/threads:2",
+                "BM_A/1/20/threads:1",  "BM_A/1/20/threads:2",
+                "BM_A/2/20/threads:1",  "BM_A/2/20/threads:2",
+                "BM_A/3/20/threads:1",  "BM_A/3/20/threads:2",
+                "BM_A/7/70/threads:1",  "BM_A/7/70/threads:2",
+                "BM_B",
+            }));
+}
+
+TEST_F(BenchmarkInstanceGeneratorTest, FiltersAndIndexes) {
+  RegisterBenchmark("BM_A", BM_Nop)->DenseRange(1, 4);
+  RegisterBenchmark("DISABLED_BM_B", BM_Nop)->Arg(1);
+  RegisterBenchmark("BM_C", BM_Nop)->DenseRange(1, 4);
+
+  EXPECT_EQ(Generate("[24]$"), std::vector<std::string>({"BM_A/2", "BM_A/4",
+                                                         "BM_C/2", "BM_C/4"}));
+  EXPECT_EQ(Generate("-BM_A"),
+            std::vector<std::string>({"BM_C/1", "BM_C/2", "BM_C/3", "BM_C/4"}));
+
+  std::string error;
+  std::unique_ptr<BenchmarkFilter> filter =
+      BenchmarkFilter::Create("C/", "", &error);
+  BenchmarkInstanceGenerator generator(filter.get());
+  std::vector<BenchmarkInstance> instances;
+  EXPECT_EQ(generator.Next(10, &instances), 4u);
+  EXPECT_TRUE(generator.Done());
+  // Families without a matching instance don't take an index.
+  EXPECT_EQ(instances[0].family_index(), 0);
+  EXPECT_EQ(instances[3].family_index(), 0);
+  EXPECT_EQ(instances[3].per_family_instance_index(), 3);
+}
+
+TEST_F(BenchmarkInstanceGeneratorTest, RejectsInvalidFilter) {
+  std::string error;
+  EXPECT_EQ(BenchmarkFilter::Create("(", "", &error), nullptr);
+  EXPECT_FALSE(error.empty());
+}
+
+TEST_F(BenchmarkInstanceGeneratorTest, HugeFamiliesAreLazy) {
+  std::vector<int64_t> values;
+  for (int64_t i = 0; i < 1000; ++i) {
+    values.push_back(i);
+  }
+  // 10^12 combinations: only ever possible to enumerate lazily.
+  RegisterBenchmark("BM_Huge", BM_Nop)
+      ->ArgsProduct({values, values, values, values});
+
+  std::string error;
+  std::unique_ptr<BenchmarkFilter> filter =
+      BenchmarkFilter::Create(".", "", &error);
+  BenchmarkInstanceGenerator generator(filter.get());
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<BenchmarkInstance> instances;
+  EXPECT_EQ(generator.Next(1001, &instances), 1001u);
+  const BenchmarkInstanceGenerator::Bounds bounds =
+      generator.RemainingBounds();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+  EXPECT_FALSE(generator.Done());
+  EXPECT_EQ(instances[0].name().str(), "BM_Huge/0/0/0/0");
+  EXPECT_EQ(instances[999].name().str(), "BM_Huge/999/0/0/0");
+  EXPECT_EQ(instances[1000].name().str(), "BM_Huge/0/1/0/0");
+  EXPECT_EQ(bounds.name_width, std::string("BM_Huge/999/999/999/999").size());
+}
+
+class CountingReporter : public ConsoleReporter {
+ public:
+  bool ReportContext(const Context& context) override {
+    name_field_width = context.name_field_width;
+    return true;
+  }
+  void ReportRuns(const std::vector<Run>& runs) override {
+    for (const Run& run : runs) {
+      if (run.run_type == Run::RT_Aggregate) {
+        aggregates.push_back(run.aggregate_name);
+      } else {
+        ++num_runs;
+      }
+    }
+  }
+
+  size_t name_field_width = 0;
+  size_t num_runs = 0;
+  std::vector<std::string> aggregates;
+};
+
+TEST_F(BenchmarkInstanceGeneratorTest, ComplexitySpansBatches) {
+  // More instances than run in one batch.
+  RegisterBenchmark("BM_Long", [](State& state) {
+    for (auto _ : state) {
+    }
+    state.SetComplexityN(state.range(0));
+  })
+      ->DenseRange(1, (1 << 14) + 10)
+      ->Iterations(1)
+      ->Complexity(oN);
+  RegisterBenchmark("BM_Short", BM_Nop)->Iterations(1);
+
+  CountingReporter reporter;
+  EXPECT_EQ(RunSpecifiedBenchmarks(&reporter, "."), (1u << 14) + 11);
+  EXPECT_EQ(reporter.num_runs, (1u << 14) + 11);
+  EXPECT_EQ(reporter.aggregates, std::vector<std::string>({"BigO", "RMS"}));
+  EXPECT_EQ(reporter.name_field_width,
+            std::string("BM_Long/16394/iterations:1").size());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace benchmark
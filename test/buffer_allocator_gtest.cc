@@ -0,0 +1,163 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../src/buffer_allocator.h"
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+using benchmark::BufferPolicy;
+using benchmark::ClearRegisteredBenchmarks;
+using benchmark::ConsoleReporter;
+using benchmark::RegisterBenchmark;
+using benchmark::RunSpecifiedBenchmarks;
+using benchmark::State;
+using benchmark::internal::BufferCache;
+using benchmark::internal::MapBuffer;
+using benchmark::internal::MappedBuffer;
+using benchmark::internal::UnmapBuffer;
+
+bool IsAligned(const void* p, size_t alignment) {
+  return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+TEST(BufferAllocatorTest, MapsAlignedPrefaultedMemory) {
+  BufferPolicy policy;
+  policy.alignment = 4096;
+  MappedBuffer buffer;
+  ASSERT_TRUE(MapBuffer(10000, policy, &buffer));
+  EXPECT_TRUE(IsAligned(buffer.data, 4096));
+  EXPECT_GE(buffer.capacity, 10000u);
+  const unsigned char* bytes = static_cast<unsigned char*>(buffer.data);
+  for (size_t i = 0; i < 10000; ++i) {
+    ASSERT_EQ(bytes[i], 0) << i;
+  }
+  UnmapBuffer(&buffer);
+  EXPECT_EQ(buffer.data, nullptr);
+}
+
+TEST(BufferAllocatorTest, HugePagesFallBack) {
+  BufferPolicy policy;
+  policy.pages = BufferPolicy::kHugePages1G;
+  policy.prefault = false;
+  MappedBuffer buffer;
+  ASSERT_TRUE(MapBuffer(1 << 20, policy, &buffer));
+  EXPECT_TRUE(IsAligned(buffer.data, policy.alignment));
+  EXPECT_GE(buffer.capacity, size_t{1} << 20);
+  // Whatever was obtained, the description says it and what was wanted.
+  const std::string description = buffer.Describe(policy);
+  if (buffer.obtained.pages == BufferPolicy::kHugePages1G) {
+    EXPECT_EQ(description, "pages=1G node=any align=64");
+  } else {
+    EXPECT_NE(description.find("(wanted 1G)"), std::string::npos)
+        << description;
+  }
+  UnmapBuffer(&buffer);
+}
+
+TEST(BufferAllocatorTest, DescribesNumaBinding) {
+  BufferPolicy policy;
+  policy.numa_node = 0;
+  MappedBuffer buffer;
+  buffer.obtained = policy;
+  EXPECT_EQ(buffer.Describe(policy),
+            "pages=default node=0(not bound) align=64 prefault");
+  buffer.numa_bound = true;
+  EXPECT_EQ(buffer.Describe(policy), "pages=default node=0 align=64 prefault");
+}
+
+TEST(BufferCacheTest, ReusesBuffersWithinAFamily) {
+  BufferCache cache;
+  BufferPolicy policy;
+  std::string description;
+  void* first = cache.Acquire("BM_A", 0, 0, 4096, policy, &description);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(cache.Acquire("BM_A", 0, 0, 1024, policy, &description), first);
+  EXPECT_NE(cache.Acquire("BM_A", 0, 1, 1024, policy, &description), first);
+  EXPECT_NE(cache.Acquire("BM_A", 1, 0, 1024, policy, &description), first);
+  EXPECT_EQ(cache.size(), 3u);
+
+  // Another family releases the buffers of the previous one.
+  ASSERT_NE(cache.Acquire("BM_B", 0, 0, 1024, policy, &description), nullptr);
+  EXPECT_EQ(cache.size(), 1u);
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(BufferCacheTest, RemapsOnPolicyChange) {
+  BufferCache cache;
+  BufferPolicy policy;
+  std::string description;
+  ASSERT_NE(cache.Acquire("BM_A", 0, 0, 4096, policy, &description), nullptr);
+  policy.alignment = 1 << 16;
+  void* data = cache.Acquire("BM_A", 0, 0, 4096, policy, &description);
+  EXPECT_TRUE(IsAligned(data, 1 << 16));
+  EXPECT_NE(description.find("align=65536"), std::string::npos);
+}
+
+class TestReporter : public ConsoleReporter {
+ public:
+  bool ReportContext(const Context& /*unused*/) override { return true; }
+
+  void PrintHeader(const Run&) override {}
+  void PrintRunData(const Run& run) override { runs.push_back(run); }
+
+  std::vector<Run> runs;
+};
+
+TEST(StateAllocateBufferTest, ReportsPolicy) {
+  std::vector<void*> buffers;
+  RegisterBenchmark("BM_Buffers",
+                    [&buffers](State& st) {
+                      BufferPolicy policy;
+                      policy.pages = BufferPolicy::kTransparentHugePages;
+                      double* data = st.AllocateBuffer<double>(
+                          static_cast<size_t>(st.range(0)), policy);
+                      buffers.push_back(data);
+                      for (auto _ : st) {
+                        benchmark::DoNotOptimize(data[0] += 1.0);
+                      }
+                    })
+      ->Arg(512)
+      ->Arg(1024)
+      ->Iterations(1);
+  TestReporter reporter;
+  RunSpecifiedBenchmarks(&reporter);
+  ClearRegisteredBenchmarks();
+
+  ASSERT_EQ(reporter.runs.size(), 2u);
+  for (const auto& run : reporter.runs) {
+    EXPECT_EQ(run.buffer_policy.find("pages="), 0u) << run.buffer_policy;
+  }
+  // Both instances of the family get the same memory.
+  ASSERT_EQ(buffers.size(), 2u);
+  EXPECT_EQ(buffers[0], buffers[1]);
+  EXPECT_EQ(benchmark::internal::GetBufferCache().size(), 0u);
+}
+
+TEST(StateAllocateBufferTest, SetupHasBuffersOfItsOwn) {
+  static void* setup_buffer = nullptr;
+  static void* body_buffer = nullptr;
+  RegisterBenchmark("BM_SetupBuffers",
+                    [](State& st) {
+                      body_buffer = st.AllocateBuffer(4096);
+                      for (auto _ : st) {
+                      }
+                    })
+      ->Setup([](const State& st) {
+        // Setup() gets a const State; the buffer cache does not mind.
+        setup_buffer = const_cast<State&>(st).AllocateBuffer(4096);
+      })
+      ->Iterations(1);
+  TestReporter reporter;
+  RunSpecifiedBenchmarks(&reporter);
+  ClearRegisteredBenchmarks();
+
+  ASSERT_NE(setup_buffer, nullptr);
+  ASSERT_NE(body_buffer, nullptr);
+  EXPECT_NE(setup_buffer, body_buffer);
+}
+
+}  // namespace
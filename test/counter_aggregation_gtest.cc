@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+#include "../src/counter.h"
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+
+namespace benchmark {
+namespace {
+
+// The counters of four threads that reported 'values' for "c".
+UserCounters MergeThreads(Counter::Aggregation aggregation,
+                          const std::vector<double>& values,
+                          Counter::Flags flags = Counter::kDefaults) {
+  UserCounters merged;
+  for (double v : values) {
+    internal::Increment(&merged,
+                        {{"c", Counter(v, flags, Counter::kIs1000,
+                                       aggregation)}});
+  }
+  internal::Finish(&merged, 1, 1.0, static_cast<double>(values.size()));
+  return merged;
+}
+
+TEST(CounterAggregationTest, MergesThreads) {
+  const std::vector<double> values = {4, 1, 8, 3};
+  EXPECT_EQ(MergeThreads(Counter::kSum, values).at("c").value, 16);
+  EXPECT_EQ(MergeThreads(Counter::kMin, values).at("c").value, 1);
+  EXPECT_EQ(MergeThreads(Counter::kMax, values).at("c").value, 8);
+  EXPECT_EQ(MergeThreads(Counter::kMean, values).at("c").value, 4);
+  EXPECT_EQ(MergeThreads(Counter::kLast, values).at("c").value, 3);
+  EXPECT_EQ(MergeThreads(Counter::kSum, values).size(), 1u);
+}
+
+TEST(CounterAggregationTest, AvgThreadsOnlyDividesSums) {
+  const std::vector<double> values = {4, 1, 8, 3};
+  EXPECT_EQ(
+      MergeThreads(Counter::kSum, values, Counter::kAvgThreads).at("c").value,
+      4);
+  EXPECT_EQ(
+      MergeThreads(Counter::kMax, values, Counter::kAvgThreads).at("c").value,
+      8);
+}
+
+TEST(CounterAggregationTest, DistributionAddsPercentiles) {
+  std::vector<double> values;
+  for (int i = 100; i >= 0; --i) {
+    values.push_back(i);
+  }
+  const UserCounters merged = MergeThreads(Counter::kDistribution, values);
+  ASSERT_EQ(merged.size(), 4u);
+  EXPECT_EQ(merged.at("c").value, 50);
+  EXPECT_EQ(merged.at("c").samples.size(), 101u);
+  EXPECT_EQ(merged.at("c_p50").value, 50);
+  EXPECT_EQ(merged.at("c_p90").value, 90);
+  EXPECT_EQ(merged.at("c_p99").value, 99);
+
+  // Transforms apply to every sample before the percentiles are taken.
+  const UserCounters inverted =
+      MergeThreads(Counter::kDistribution, {1, 2, 4}, Counter::kInvert);
+  EXPECT_EQ(inverted.at("c_p50").value, 0.5);
+  EXPECT_EQ(inverted.at("c").value, (1 + 0.5 + 0.25) / 3);
+}
+
+class RunsReporter : public ConsoleReporter {
+ public:
+  bool ReportContext(const Context& /*unused*/) override { return true; }
+  void ReportRuns(const std::vector<Run>& report) override {
+    runs.insert(runs.end(), report.begin(), report.end());
+  }
+
+  std::vector<Run> runs;
+};
+
+TEST(CounterAggregationTest, MergesRepetitions) {
+  static std::atomic<int> next_value(0);
+  next_value = 0;
+  RegisterBenchmark("BM_Aggregation", [](State& state) {
+    for (auto _ : state) {
+    }
+    const double v = static_cast<double>(++next_value);
+    state.counters["peak"] =
+        Counter(v, Counter::kDefaults, Counter::kIs1000, Counter::kMax);
+    state.counter("depth", Counter::kDefaults, Counter::kIs1000,
+                  Counter::kDistribution) = v;
+  })
+      ->Iterations(1)
+      ->Threads(2)
+      ->Repetitions(2)
+      ->ComputeStatistics("max", [](const std::vector<double>& v) {
+        return *std::max_element(v.begin(), v.end());
+      });
+  RunsReporter reporter;
+  RunSpecifiedBenchmarks(&reporter);
+  ClearRegisteredBenchmarks();
+
+  // Two repetitions, then mean, median, stddev, cv and max.
+  ASSERT_EQ(reporter.runs.size(), 7u);
+  const BenchmarkReporter::Run& first = reporter.runs[0];
+  const BenchmarkReporter::Run& second = reporter.runs[1];
+  EXPECT_EQ(first.counters.at("peak").value, 2);
+  EXPECT_EQ(second.counters.at("peak").value, 4);
+  EXPECT_EQ(first.counters.at("depth").value, 1.5);
+  EXPECT_EQ(first.counters.at("depth_p50").value, 1.5);
+  EXPECT_EQ(second.counters.at("depth_p90").value, 3.9);
+
+  const BenchmarkReporter::Run& mean = reporter.runs[2];
+  EXPECT_EQ(mean.aggregate_name, "mean");
+  EXPECT_EQ(mean.counters.at("peak").value, 3);
+  EXPECT_EQ(mean.counters.at("depth").aggregation, Counter::kDistribution);
+  EXPECT_TRUE(mean.counters.at("depth").samples.empty());
+  const BenchmarkReporter::Run& max = reporter.runs[6];
+  EXPECT_EQ(max.aggregate_name, "max");
+  EXPECT_EQ(max.counters.at("peak").value, 4);
+}
+
+TEST(CounterAggregationTest, PoolsPercentilesOfRepetitions) {
+  static std::atomic<int> next_value(0);
+  next_value = 0;
+  RegisterBenchmark("BM_Pooled", [](State& state) {
+    for (auto _ : state) {
+    }
+    state.counter("depth", Counter::kDefaults, Counter::kIs1000,
+                  Counter::kDistribution) =
+        static_cast<double>(++next_value);
+  })
+      ->Iterations(1)
+      ->Threads(2)
+      ->Repetitions(2);
+  RunsReporter reporter;
+  RunSpecifiedBenchmarks(&reporter);
+  ClearRegisteredBenchmarks();
+
+  // Two repetitions, then mean, median, stddev and cv.
+  ASSERT_EQ(reporter.runs.size(), 6u);
+  // The repetitions saw {1, 2} and {3, 4}: their own p99 are 1.99 and 3.99,
+  // while the p99 of the pooled {1, 2, 3, 4} is 3 + 0.97 * (4 - 3).
+  EXPECT_DOUBLE_EQ(reporter.runs[0].counters.at("depth_p99").value, 1.99);
+  EXPECT_DOUBLE_EQ(reporter.runs[1].counters.at("depth_p99").value, 3.99);
+  const BenchmarkReporter::Run& mean = reporter.runs[2];
+  EXPECT_EQ(mean.aggregate_name, "mean");
+  EXPECT_DOUBLE_EQ(mean.counters.at("depth_p99").value, 3.97);
+  EXPECT_DOUBLE_EQ(mean.counters.at("depth_p50").value, 2.5);
+  const BenchmarkReporter::Run& median = reporter.runs[3];
+  EXPECT_EQ(median.aggregate_name, "median");
+  EXPECT_DOUBLE_EQ(median.counters.at("depth_p99").value, 3.97);
+  // The stddev is that of the percentiles of the repetitions.
+  const BenchmarkReporter::Run& stddev = reporter.runs[4];
+  EXPECT_EQ(stddev.aggregate_name, "stddev");
+  EXPECT_DOUBLE_EQ(stddev.counters.at("depth_p99").value, std::sqrt(2.0));
+}
+
+}  // namespace
+}  // namespace benchmark
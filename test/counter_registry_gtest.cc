@@ -0,0 +1,78 @@
+#include <string>
+#include <vector>
+
+#include "../src/counter.h"
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+
+namespace benchmark {
+namespace {
+
+TEST(CounterIdTest, InternsNames) {
+  const CounterId a("registry_a");
+  const CounterId b("registry_b");
+  EXPECT_NE(a.index(), b.index());
+  EXPECT_EQ(CounterId("registry_a").index(), a.index());
+  EXPECT_EQ(a.name(), "registry_a");
+  EXPECT_EQ(internal::CounterName(b.index()), "registry_b");
+}
+
+TEST(CounterIncrementTest, MergesByName) {
+  UserCounters l = {{"a", Counter(1)}, {"c", Counter(3)}, {"e", Counter(5)}};
+  const UserCounters r = {
+      {"a", Counter(10)}, {"b", Counter(20)}, {"e", Counter(50)},
+      {"f", Counter(60, Counter::kIsRate)}};
+  internal::Increment(&l, r);
+  ASSERT_EQ(l.size(), 5u);
+  EXPECT_EQ(l["a"].value, 11);
+  EXPECT_EQ(l["b"].value, 20);
+  EXPECT_EQ(l["c"].value, 3);
+  EXPECT_EQ(l["e"].value, 55);
+  EXPECT_EQ(l["f"].value, 60);
+  EXPECT_EQ(l["f"].flags, Counter::kIsRate);
+}
+
+class RunsReporter : public ConsoleReporter {
+ public:
+  bool ReportContext(const Context& /*unused*/) override { return true; }
+  void ReportRuns(const std::vector<Run>& report) override {
+    runs.insert(runs.end(), report.begin(), report.end());
+  }
+
+  std::vector<Run> runs;
+};
+
+const CounterId kHits("hits");
+
+TEST(CounterHandleTest, ReportedWithTheMapCounters) {
+  RegisterBenchmark("BM_Handles", [](State& state) {
+    auto hits = state.counter(kHits);
+    auto per_iter = state.counter("per_iter", Counter::kAvgIterations);
+    int i = 0;
+    for (auto _ : state) {
+      hits += 1;
+      ++per_iter;
+      // Interning a new name grows the array under the held handles.
+      state.counter("late_" + std::to_string(i++ % 3)) += 2;
+    }
+    state.counters["map"] = 7;
+    // Both views of one name add up.
+    state.counters["hits"] = 100;
+  })
+      ->Iterations(6)
+      ->Threads(2);
+  RunsReporter reporter;
+  RunSpecifiedBenchmarks(&reporter);
+  ClearRegisteredBenchmarks();
+
+  ASSERT_EQ(reporter.runs.size(), 1u);
+  const UserCounters& counters = reporter.runs[0].counters;
+  EXPECT_EQ(counters.at("hits").value, 2 * (100 + 6));
+  EXPECT_EQ(counters.at("per_iter").value, 1);
+  EXPECT_EQ(counters.at("map").value, 14);
+  EXPECT_EQ(counters.at("late_0").value, 8);
+  EXPECT_EQ(counters.at("late_2").value, 8);
+}
+
+}  // namespace
+}  // namespace benchmark
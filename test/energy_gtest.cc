@@ -0,0 +1,80 @@
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../src/energy.h"
+#include "gtest/gtest.h"
+
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
+#ifndef GTEST_SKIP
+struct MsgHandler {
+  void operator=(std::ostream&) {}
+};
+#define GTEST_SKIP() return MsgHandler() = std::cout
+#endif
+
+using benchmark::internal::EnergyMeasurement;
+
+namespace {
+
+TEST(EnergyMeasurementTest, CounterDelta) {
+  EXPECT_EQ(EnergyMeasurement::CounterDelta(100, 250, 1000), 150u);
+  EXPECT_EQ(EnergyMeasurement::CounterDelta(900, 50, 1000), 150u);
+  EXPECT_EQ(EnergyMeasurement::CounterDelta(7, 7, 1000), 0u);
+  const uint64_t kMsrRange = uint64_t{1} << 32;
+  EXPECT_EQ(EnergyMeasurement::CounterDelta(0xfffffff0, 0x10, kMsrRange),
+            0x20u);
+}
+
+TEST(EnergyMeasurementTest, Disabled) {
+  EnergyMeasurement energy(false);
+  EXPECT_EQ(energy.num_domains(), 0u);
+}
+
+#ifdef __linux__
+void WriteFile(const std::string& path, const std::string& contents) {
+  std::ofstream out(path);
+  out << contents << "\n";
+}
+
+void MakeZone(const std::string& dir, const std::string& name,
+              const std::string& energy_uj, const std::string& range_uj) {
+  mkdir(dir.c_str(), 0755);
+  WriteFile(dir + "/name", name);
+  WriteFile(dir + "/energy_uj", energy_uj);
+  WriteFile(dir + "/max_energy_range_uj", range_uj);
+}
+
+TEST(EnergyMeasurementTest, Powercap) {
+  // A fake two-socket machine laid out like /sys/class/powercap.
+  const std::string root = ::testing::TempDir() + "fake_powercap";
+  mkdir(root.c_str(), 0755);
+  MakeZone(root + "/intel-rapl:0", "package-0", "1000000", "262143328850");
+  MakeZone(root + "/intel-rapl:0:0", "core", "500", "262143328850");
+  MakeZone(root + "/intel-rapl:1", "package-1", "262143000000",
+           "262143328850");
+  MakeZone(root + "/intel-rapl-mmio:0", "package-0", "0", "262143328850");
+
+  EnergyMeasurement energy(true, root);
+  ASSERT_EQ(energy.num_domains(), 2u);
+  EXPECT_EQ(energy.names()[0], "package");
+  EXPECT_EQ(energy.names()[1], "core");
+
+  ASSERT_TRUE(energy.Start());
+  WriteFile(root + "/intel-rapl:0/energy_uj", "3000000");
+  WriteFile(root + "/intel-rapl:0:0/energy_uj", "250500");
+  // The second package wraps around.
+  WriteFile(root + "/intel-rapl:1/energy_uj", "671150");
+  std::vector<double> joules(energy.num_domains());
+  double seconds = -1;
+  ASSERT_TRUE(energy.Stop(joules.data(), &seconds));
+  EXPECT_DOUBLE_EQ(joules[0], 2.0 + 1.0);
+  EXPECT_DOUBLE_EQ(joules[1], 0.25);
+  EXPECT_GE(seconds, 0.0);
+}
+#endif
+
+}  // namespace
@@ -23,12 +23,20 @@ namespace {
 const char kGenericPerfEvent1[] = "CYCLES";
 const char kGenericPerfEvent2[] = "INSTRUCTIONS";
 
+// Whether the generic hardware events used below can actually be counted.
+// This is not the case e.g. inside VMs that do not expose a PMU.
+bool GenericEventsSupported() {
+  return PerfCounters::kSupported &&
+         PerfCounters::IsCounterSupported(kGenericPerfEvent1) &&
+         PerfCounters::IsCounterSupported(kGenericPerfEvent2);
+}
+
 TEST(PerfCountersTest, Init) {
   EXPECT_EQ(PerfCounters::Initialize(), PerfCounters::kSupported);
 }
 
 TEST(PerfCountersTest, OneCounter) {
-  if (!PerfCounters::kSupported) {
+  if (!GenericEventsSupported()) {
     GTEST_SKIP() << "Performance counters not supported.\n";
   }
   EXPECT_TRUE(PerfCounters::Initialize());
@@ -48,6 +56,9 @@ TEST(PerfCountersTest, NegativeTest) {
   EXPECT_EQ(PerfCounters::Create({}).num_counters(), 0);
   EXPECT_EQ(PerfCounters::Create({""}).num_counters(), 0);
   EXPECT_EQ(PerfCounters::Create({"not a counter name"}).num_counters(), 0);
+  if (!GenericEventsSupported()) {
+    return;
+  }
   {
     // Try sneaking in a bad egg to see if it is filtered out. The
     // number of counters has to be two, not zero
@@ -82,8 +93,8 @@ TEST(PerfCountersTest, NegativeTest) {
 }
 
 TEST(PerfCountersTest, Read1Counter) {
-  if (!PerfCounters::kSupported) {
-    GTEST_SKIP() << "Test skipped because libpfm is not supported.\n";
+  if (!GenericEventsSupported()) {
+    GTEST_SKIP() << "Test skipped because perf counters are not available.\n";
   }
   EXPECT_TRUE(PerfCounters::Initialize());
   auto counters = PerfCounters::Create({kGenericPerfEvent1});
@@ -98,8 +109,8 @@ TEST(PerfCountersTest, Read1Counter) {
 }
 
 TEST(PerfCountersTest, Read2Counters) {
-  if (!PerfCounters::kSupported) {
-    GTEST_SKIP() << "Test skipped because libpfm is not supported.\n";
+  if (!GenericEventsSupported()) {
+    GTEST_SKIP() << "Test skipped because perf counters are not available.\n";
   }
   EXPECT_TRUE(PerfCounters::Initialize());
   auto counters =
@@ -118,8 +129,8 @@ TEST(PerfCountersTest, Read2Counters) {
 TEST(PerfCountersTest, ReopenExistingCounters) {
   // This test works in recent and old Intel hardware, Pixel 3, and Pixel 6.
   // However we cannot make assumptions beyond 2 HW counters due to Pixel 6.
-  if (!PerfCounters::kSupported) {
-    GTEST_SKIP() << "Test skipped because libpfm is not supported.\n";
+  if (!GenericEventsSupported()) {
+    GTEST_SKIP() << "Test skipped because perf counters are not available.\n";
   }
   EXPECT_TRUE(PerfCounters::Initialize());
   std::vector<std::string> kMetrics({kGenericPerfEvent1});
@@ -137,8 +148,8 @@ TEST(PerfCountersTest, CreateExistingMeasurements) {
   // about hardware capabilities (i.e. small number (2) hardware
   // counters) at this date,
   // the same as previous test ReopenExistingCounters.
-  if (!PerfCounters::kSupported) {
-    GTEST_SKIP() << "Test skipped because libpfm is not supported.\n";
+  if (!GenericEventsSupported()) {
+    GTEST_SKIP() << "Test skipped because perf counters are not available.\n";
   }
   EXPECT_TRUE(PerfCounters::Initialize());
 
@@ -237,8 +248,8 @@ void measure(size_t threadcount, PerfCounterValues* before,
 }
 
 TEST(PerfCountersTest, MultiThreaded) {
-  if (!PerfCounters::kSupported) {
-    GTEST_SKIP() << "Test skipped because libpfm is not supported.";
+  if (!GenericEventsSupported()) {
+    GTEST_SKIP() << "Test skipped because perf counters are not available.";
   }
   EXPECT_TRUE(PerfCounters::Initialize());
   PerfCounterValues before(2);
@@ -276,7 +287,7 @@ TEST(PerfCountersTest, HardwareLimits) {
   // counters) at this date,
   // the same as previous test ReopenExistingCounters.
   if (!PerfCounters::kSupported) {
-    GTEST_SKIP() << "Test skipped because libpfm is not supported.\n";
+    GTEST_SKIP() << "Test skipped because perf counters are not available.\n";
   }
   EXPECT_TRUE(PerfCounters::Initialize());
 
@@ -308,4 +319,35 @@ TEST(PerfCountersTest, HardwareLimits) {
   EXPECT_TRUE(counter.Stop(measurements));
 }
 
+TEST(PerfCountersTest, SoftwareCounter) {
+  // Software events are provided by the kernel itself and are available even
+  // where the hardware counters are not, e.g. inside VMs.
+  if (!PerfCounters::kSupported ||
+      !PerfCounters::IsCounterSupported("task-clock")) {
+    GTEST_SKIP() << "Test skipped because perf counters are not available.\n";
+  }
+  auto counters = PerfCounters::Create({"task-clock"});
+  EXPECT_EQ(counters.num_counters(), 1);
+  PerfCounterValues values1(1);
+  EXPECT_TRUE(counters.Snapshot(&values1));
+  volatile double sink = 0;
+  for (int i = 0; i < 1000000; ++i) {
+    sink = sink + i;
+  }
+  PerfCounterValues values2(1);
+  EXPECT_TRUE(counters.Snapshot(&values2));
+  EXPECT_GT(values2[0], values1[0]);
+}
+
+TEST(PerfCountersTest, RawCounterSyntax) {
+  if (!PerfCounters::kSupported) {
+    GTEST_SKIP() << "Test skipped because perf counters are not available.\n";
+  }
+  // Malformed raw encodings are rejected up front, whatever the backend.
+  EXPECT_FALSE(PerfCounters::IsCounterSupported("r"));
+  EXPECT_FALSE(PerfCounters::IsCounterSupported("rzz"));
+  EXPECT_FALSE(PerfCounters::IsCounterSupported("r12345678123456789"));
+  EXPECT_EQ(PerfCounters::Create({"rzz"}).num_counters(), 0);
+}
+
 }  // namespace
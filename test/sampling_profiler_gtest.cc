@@ -0,0 +1,168 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "../src/sampling_profiler.h"
+#include "gtest/gtest.h"
+
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
+#ifndef GTEST_SKIP
+struct MsgHandler {
+  void operator=(std::ostream&) {}
+};
+#define GTEST_SKIP() return MsgHandler() = std::cout
+#endif
+
+using benchmark::internal::MemoryAccessProfiler;
+using benchmark::internal::SamplingProfiler;
+
+namespace {
+
+class CountingProfilerManager : public benchmark::ProfilerManager {
+ public:
+  void AfterSetupStart() override { ++start_called; }
+  void BeforeTeardownStop() override { ++stop_called; }
+
+  int start_called = 0;
+  int stop_called = 0;
+};
+
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+double SpinForAWhile() {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+  volatile double sink = 0;
+  while (std::chrono::steady_clock::now() < deadline) {
+    for (int i = 0; i < 1000; ++i) {
+      sink = sink + i;
+    }
+  }
+  return sink;
+}
+
+TEST(SamplingProfilerTest, OutputPath) {
+  EXPECT_EQ(SamplingProfiler::OutputPath("prof", "BM_Foo/8/threads:2", 0, 1),
+            "prof/BM_Foo_8_threads_2.folded");
+  EXPECT_EQ(SamplingProfiler::OutputPath("prof", "BM_Foo<int>", 2, 3),
+            "prof/BM_Foo_int_.rep2.folded");
+}
+
+TEST(SamplingProfilerTest, ChainsRegisteredManager) {
+  CountingProfilerManager user_manager;
+  SamplingProfiler profiler(&user_manager);
+  profiler.AfterSetupStart();
+  EXPECT_EQ(user_manager.start_called, 1);
+  EXPECT_EQ(user_manager.stop_called, 0);
+  profiler.BeforeTeardownStop();
+  EXPECT_EQ(user_manager.start_called, 1);
+  EXPECT_EQ(user_manager.stop_called, 1);
+}
+
+TEST(SamplingProfilerTest, WritesFoldedStacks) {
+  if (!SamplingProfiler::kSupported) {
+    GTEST_SKIP() << "Sampling profiler not supported.\n";
+  }
+  SamplingProfiler profiler;
+  profiler.AfterSetupStart();
+  SpinForAWhile();
+  profiler.BeforeTeardownStop();
+  if (profiler.num_samples() == 0) {
+    GTEST_SKIP() << "Sampling perf events are not available.\n";
+  }
+
+  const std::string path = ::testing::TempDir() + "sampling_profiler.folded";
+  ASSERT_TRUE(profiler.WriteFoldedStacks(path));
+  std::ifstream in(path);
+  std::string line;
+  bool found = false;
+  uint64_t total = 0;
+  while (std::getline(in, line)) {
+    const size_t space = line.rfind(' ');
+    ASSERT_NE(space, std::string::npos) << line;
+    total += std::stoull(line.substr(space + 1));
+    found |= line.find("SpinForAWhile") != std::string::npos;
+  }
+  EXPECT_EQ(total, profiler.num_samples());
+  EXPECT_TRUE(found);
+  std::remove(path.c_str());
+}
+
+#ifdef __linux__
+void WriteFile(const std::string& path, const std::string& contents) {
+  std::ofstream out(path);
+  out << contents << "\n";
+}
+
+TEST(MemoryAccessProfilerTest, EncodePmuEvent) {
+  // A fake PMU laid out like /sys/bus/event_source/devices/cpu.
+  const std::string pmu = ::testing::TempDir() + "fake_pmu";
+  mkdir(pmu.c_str(), 0755);
+  mkdir((pmu + "/format").c_str(), 0755);
+  mkdir((pmu + "/events").c_str(), 0755);
+  WriteFile(pmu + "/type", "4");
+  WriteFile(pmu + "/format/event", "config:0-7");
+  WriteFile(pmu + "/format/umask", "config:8-15");
+  WriteFile(pmu + "/format/inv", "config:23");
+  WriteFile(pmu + "/format/ldlat", "config1:0-15");
+  WriteFile(pmu + "/format/split", "config:16-17,32-33");
+  WriteFile(pmu + "/events/mem-loads", "event=0xcd,umask=0x1,ldlat=3");
+  WriteFile(pmu + "/events/odd", "event=0x3c,inv,split=0xd");
+
+  uint32_t type = 0;
+  uint64_t config = 0;
+  uint64_t config1 = 0;
+  ASSERT_TRUE(MemoryAccessProfiler::EncodePmuEvent(pmu, "mem-loads", &type,
+                                                   &config, &config1));
+  EXPECT_EQ(type, 4u);
+  EXPECT_EQ(config, 0x1cdu);
+  EXPECT_EQ(config1, 3u);
+
+  ASSERT_TRUE(MemoryAccessProfiler::EncodePmuEvent(pmu, "odd", &type, &config,
+                                                   &config1));
+  // 0xd = 0b1101 spreads over bits 16, 17, 32 and 33.
+  EXPECT_EQ(config, 0x3cu | (1u << 23) | (1u << 16) | (uint64_t{3} << 32));
+  EXPECT_EQ(config1, 0u);
+
+  EXPECT_FALSE(MemoryAccessProfiler::EncodePmuEvent(pmu, "missing", &type,
+                                                    &config, &config1));
+}
+#endif
+
+TEST(MemoryAccessProfilerTest, WritesReport) {
+  MemoryAccessProfiler profiler;
+  // Two loads hitting the same cache line and one slow outlier elsewhere.
+  profiler.AddSample(0x1000, 0x7f0000000040, 5, 0);
+  profiler.AddSample(0x1000, 0x7f0000000048, 6, 0);
+  profiler.AddSample(0x2000, 0x7f0000001000, 300, 0);
+  EXPECT_EQ(profiler.num_samples(), 3u);
+
+  const std::string path = ::testing::TempDir() + "memory_access.txt";
+  ASSERT_TRUE(profiler.WriteReport(path, "BM_Test"));
+  std::ifstream in(path);
+  const std::string report((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+  EXPECT_NE(report.find("Memory access samples for BM_Test"),
+            std::string::npos);
+  EXPECT_NE(report.find("samples: 3"), std::string::npos);
+  EXPECT_NE(report.find("[4, 8)                            2"),
+            std::string::npos);
+  EXPECT_NE(report.find("[256, 512)                        1"),
+            std::string::npos);
+  // The slow line comes first, the shared line lists both offsets.
+  const size_t slow = report.find("0x7f0000001000");
+  const size_t shared = report.find("0x7f0000000040");
+  ASSERT_NE(slow, std::string::npos);
+  ASSERT_NE(shared, std::string::npos);
+  EXPECT_LT(slow, shared);
+  EXPECT_NE(report.find("+0(1) +8(1)", shared), std::string::npos);
+  std::remove(path.c_str());
+}
+
+}  // namespace
@@ -0,0 +1,133 @@
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/shared_data.h"
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+
+namespace benchmark {
+namespace internal {
+namespace {
+
+// Gets 'key' from 'cache' as a vector of 'n' bytes, counting the builds.
+std::shared_ptr<const std::vector<char>> GetBytes(SharedDataCache* cache,
+                                                  const std::string& key,
+                                                  size_t n,
+                                                  std::atomic<int>* builds) {
+  return std::static_pointer_cast<const std::vector<char>>(
+      cache->Get(key, [&](size_t* bytes) -> std::shared_ptr<const void> {
+        ++*builds;
+        *bytes = n;
+        return std::make_shared<std::vector<char>>(n, 'x');
+      }));
+}
+
+TEST(SharedDataCacheTest, BuildsOnce) {
+  SharedDataCache cache;
+  std::atomic<int> builds(0);
+  auto first = GetBytes(&cache, "a", 10, &builds);
+  auto second = GetBytes(&cache, "a", 10, &builds);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(builds, 1);
+
+  const SharedDataStats stats = cache.stats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.entries, 1u);
+  EXPECT_EQ(stats.bytes, 10u);
+}
+
+TEST(SharedDataCacheTest, ConcurrentCallersShareOneBuild) {
+  SharedDataCache cache;
+  std::atomic<int> builds(0);
+  std::vector<std::thread> threads;
+  std::vector<std::shared_ptr<const std::vector<char>>> results(8);
+  for (size_t i = 0; i < results.size(); ++i) {
+    threads.emplace_back([&, i] {
+      results[i] = GetBytes(&cache, "big", 1 << 20, &builds);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(builds, 1);
+  for (const auto& result : results) {
+    EXPECT_EQ(result, results[0]);
+  }
+}
+
+TEST(SharedDataCacheTest, EvictsLeastRecentlyUsed) {
+  SharedDataCache cache;
+  cache.SetBudget(100);
+  std::atomic<int> builds(0);
+  GetBytes(&cache, "a", 40, &builds);
+  GetBytes(&cache, "b", 40, &builds);
+  GetBytes(&cache, "a", 40, &builds);
+  // Over budget: "b" is the least recently used.
+  auto held = GetBytes(&cache, "c", 40, &builds);
+  EXPECT_EQ(cache.stats().evictions, 1);
+  EXPECT_EQ(cache.stats().bytes, 80u);
+  EXPECT_EQ(builds, 3);
+  GetBytes(&cache, "a", 40, &builds);
+  EXPECT_EQ(builds, 3);
+  GetBytes(&cache, "b", 40, &builds);
+  EXPECT_EQ(builds, 4);
+
+  // A dataset larger than the budget is still kept on its own.
+  GetBytes(&cache, "huge", 1000, &builds);
+  EXPECT_EQ(cache.stats().entries, 1u);
+  EXPECT_EQ(held->size(), 40u);
+}
+
+class CounterReporter : public ConsoleReporter {
+ public:
+  bool ReportContext(const Context& /*unused*/) override { return true; }
+  void ReportRuns(const std::vector<Run>& report) override {
+    runs.insert(runs.end(), report.begin(), report.end());
+  }
+
+  std::vector<Run> runs;
+};
+
+TEST(SharedDataTest, SharedAcrossInstancesAndReported) {
+  GetSharedDataCache().Clear();
+  std::atomic<int> builds(0);
+  RegisterBenchmark("BM_Sum",
+                    [&builds](State& state) {
+                      auto data = SharedData<std::vector<int64_t>>(
+                          "iota", [&builds] {
+                            ++builds;
+                            return std::vector<int64_t>(1000, 1);
+                          });
+                      for (auto _ : state) {
+                        int64_t sum = 0;
+                        for (int64_t x : *data) sum += x;
+                        DoNotOptimize(sum);
+                      }
+                    })
+      ->Arg(1)
+      ->Arg(2)
+      ->Repetitions(2)
+      ->Iterations(1);
+  CounterReporter reporter;
+  RunSpecifiedBenchmarks(&reporter);
+  ClearRegisteredBenchmarks();
+
+  EXPECT_EQ(builds, 1);
+  EXPECT_EQ(GetSharedDataStats().bytes,
+            sizeof(std::vector<int64_t>) + 1000 * sizeof(int64_t));
+  ASSERT_GE(reporter.runs.size(), 4u);
+  const BenchmarkReporter::Run& first = reporter.runs[0];
+  EXPECT_DOUBLE_EQ(first.counters.at("shared_data_hit_rate").value, 0.0);
+  EXPECT_GE(first.counters.at("shared_data_build_time").value, 0.0);
+  EXPECT_DOUBLE_EQ(reporter.runs[1].counters.at("shared_data_hit_rate").value,
+                   1.0);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace benchmark
@@ -0,0 +1,138 @@
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/benchmark_api_internal.h"
+#include "../src/benchmark_filter.h"
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+
+namespace benchmark {
+namespace internal {
+namespace {
+
+enum class Probe { kLinear = 1, kQuadratic = 4 };
+
+void BM_Nop(State& state) {
+  for (auto _ : state) {
+  }
+}
+
+std::vector<std::string> InstanceNames() {
+  std::string error;
+  std::unique_ptr<BenchmarkFilter> filter =
+      BenchmarkFilter::Create(".", "", &error);
+  BenchmarkInstanceGenerator generator(filter.get());
+  std::vector<BenchmarkInstance> instances;
+  generator.Next(1000, &instances);
+  std::vector<std::string> names;
+  for (const auto& instance : instances) {
+    names.push_back(instance.name().str());
+  }
+  return names;
+}
+
+class TypedArgsTest : public ::testing::Test {
+ protected:
+  void TearDown() override { ClearRegisteredBenchmarks(); }
+};
+
+TEST_F(TypedArgsTest, NamesShowTheValues) {
+  RegisterBenchmark("BM_Probe", BM_Nop)
+      ->DoubleAxis("load", {0.5, 0.875})
+      ->EnumAxis<Probe>("probe", {{Probe::kLinear, "linear"},
+                                  {Probe::kQuadratic, "quadratic"}})
+      ->StringAxis("keys", {"words"})
+      ->IntAxis("size", {64});
+  EXPECT_EQ(InstanceNames(),
+            std::vector<std::string>(
+                {"BM_Probe/load:0.5/probe:linear/keys:words/size:64",
+                 "BM_Probe/load:0.875/probe:linear/keys:words/size:64",
+                 "BM_Probe/load:0.5/probe:quadratic/keys:words/size:64",
+                 "BM_Probe/load:0.875/probe:quadratic/keys:words/size:64"}));
+}
+
+TEST_F(TypedArgsTest, NearbyDoublesGetDistinctNames) {
+  RegisterBenchmark("BM_Load", BM_Nop)
+      ->DoubleAxis("load", {1.0000001, 1.0000002, 0.1, 1e-300});
+  EXPECT_EQ(InstanceNames(),
+            std::vector<std::string>({"BM_Load/load:1.0000001",
+                                      "BM_Load/load:1.0000002",
+                                      "BM_Load/load:0.1",
+                                      "BM_Load/load:1e-300"}));
+}
+
+class RunsReporter : public ConsoleReporter {
+ public:
+  bool ReportContext(const Context& /*unused*/) override { return true; }
+  void ReportRuns(const std::vector<Run>& report) override {
+    runs.insert(runs.end(), report.begin(), report.end());
+  }
+
+  std::vector<Run> runs;
+};
+
+TEST_F(TypedArgsTest, StateAccessors) {
+  std::vector<std::string> seen;
+  RegisterBenchmark("BM_Probe", [&seen](State& state) {
+    for (auto _ : state) {
+    }
+    const double load = state.range_as<double>(0);
+    const Probe probe = state.arg<Probe>("probe");
+    seen.push_back(state.arg<std::string>("probe") + "@" +
+                   std::to_string(load) + "/" +
+                   std::to_string(static_cast<int>(probe)) + "/" +
+                   state.range_as<std::string>(2) + "/" +
+                   std::to_string(state.arg<int>("size")));
+  })
+      ->DoubleAxis("load", {0.25})
+      ->EnumAxis<Probe>("probe", {{Probe::kQuadratic, "quadratic"}})
+      ->StringAxis("keys", {"urls"})
+      ->IntAxis("size", {128})
+      ->Iterations(1);
+  RunsReporter reporter;
+  RunSpecifiedBenchmarks(&reporter);
+  EXPECT_EQ(seen,
+            std::vector<std::string>({"quadratic@0.250000/4/urls/128"}));
+
+  ASSERT_EQ(reporter.runs.size(), 1u);
+  const auto& args = reporter.runs[0].args;
+  ASSERT_EQ(args.size(), 4u);
+  EXPECT_EQ(args[0].name, "load");
+  EXPECT_EQ(args[0].type, TypedArg::kDouble);
+  EXPECT_DOUBLE_EQ(args[0].double_value, 0.25);
+  EXPECT_EQ(args[1].type, TypedArg::kEnum);
+  EXPECT_EQ(args[1].int_value, 4);
+  EXPECT_EQ(args[1].string_value, "quadratic");
+  EXPECT_EQ(args[2].type, TypedArg::kString);
+  EXPECT_EQ(args[3].type, TypedArg::kInt);
+  EXPECT_EQ(args[3].int_value, 128);
+}
+
+TEST_F(TypedArgsTest, PlainArgumentsAreNotTyped) {
+  RegisterBenchmark("BM_Plain", BM_Nop)->Arg(3)->Iterations(1);
+  RunsReporter reporter;
+  RunSpecifiedBenchmarks(&reporter);
+  ASSERT_EQ(reporter.runs.size(), 1u);
+  EXPECT_TRUE(reporter.runs[0].args.empty());
+}
+
+TEST_F(TypedArgsTest, JsonHasTypedValues) {
+  RegisterBenchmark("BM_Probe", BM_Nop)
+      ->DoubleAxis("load", {0.75})
+      ->StringAxis("keys", {"words"})
+      ->Iterations(1);
+  std::stringstream out;
+  JSONReporter reporter;
+  reporter.SetOutputStream(&out);
+  RunSpecifiedBenchmarks(&reporter);
+  EXPECT_NE(out.str().find("\"args\": {\"load\": 7.5000000000000000e-01, "
+                           "\"keys\": \"words\"},"),
+            std::string::npos)
+      << out.str();
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace benchmark